@@ -0,0 +1,366 @@
+// Copyright 2022 Alexey Kutepov <reximkut@gmail.com>
+
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+/*
+    C++17 layer over arena.h:
+    - `ArenaResource`  std::pmr::memory_resource on top of an arena (owned or borrowed)
+    - `ArenaAllocator` one pointer allocator for containers that take an allocator type
+    - `ArenaScope`     mark on construction, restore on destruction
+    Memory comes back in bulk (reset / restore / destroy), per object deallocation only
+    gives bytes back when the block is the last one on the arena.
+    Objects made with `make` / `make_array` get their destructors run by the same bulk release
+    (see `arena_defer`), trivially destructible types cost a plain bump.
+    C++20: `ArenaPromise` puts coroutine frames on an arena (see `ArenaFrameScope`).
+*/
+
+#ifndef ARENA_HPP_
+#define ARENA_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+#include <memory_resource>
+#include <stdexcept>
+#include <type_traits>
+
+#include "arena.h"
+
+namespace arena_detail {
+
+inline void *allocate(Arena *arena, std::size_t bytes, std::size_t alignment)
+{
+    void *p = arena_alloc_raw(arena, bytes ? bytes : 1, alignment);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+inline void release(Arena *arena, void *p, std::size_t bytes) noexcept
+{
+    // top of the arena goes back in place, anything else waits for reset
+    if (!arena || !p || (arena->flags & (ARENA_FLAG_SHARED | ARENA_FLAG_FROZEN))) return;
+
+    ArenaChunk *chunk = arena->last_chunk;
+    arena_ptr_t base  = (arena_ptr_t)chunk->base;
+    arena_ptr_t ptr   = (arena_ptr_t)p;
+    if (ptr < base || ptr + (bytes ? bytes : 1) != base + chunk->offset) return;
+
+    ArenaMark mark = arena_mark(arena);
+    mark.offset = ptr - base;
+    arena_restore(arena, mark, false);
+}
+
+template <typename T, typename... Args>
+inline void construct(T *p, Args&&... args)
+{
+    // aggregates have no constructor to call with parentheses before C++20
+    if constexpr (std::is_constructible_v<T, Args...>) new (p) T(std::forward<Args>(args)...);
+    else new (p) T{std::forward<Args>(args)...};
+}
+
+template <typename T>
+inline void destroy(void *ctx)
+{
+    static_cast<T*>(ctx)->~T();
+}
+
+template <typename T>
+struct ArrayRecord {
+    T           *items;
+    std::size_t count;
+};
+
+template <typename T>
+inline void destroy_array(void *ctx)
+{
+    ArrayRecord<T> *record = static_cast<ArrayRecord<T>*>(ctx);
+    for (std::size_t i = record->count; i > 0; --i) record->items[i - 1].~T();
+}
+
+template <typename T, typename... Args>
+inline T *make(Arena *arena, Args&&... args)
+{
+    T *p = static_cast<T*>(allocate(arena, sizeof(T), alignof(T)));
+    if constexpr (std::is_trivially_destructible_v<T>) {
+        construct(p, std::forward<Args>(args)...);
+    } else {
+        try {
+            construct(p, std::forward<Args>(args)...);
+        } catch (...) {
+            release(arena, p, sizeof(T));
+            throw;
+        }
+        if (!arena_defer(arena, destroy<T>, p)) {
+            p->~T();
+            throw std::bad_alloc();
+        }
+    }
+    return p;
+}
+
+template <typename T>
+inline T *make_array(Arena *arena, std::size_t count)
+{
+    if (count > SIZE_MAX / sizeof(T)) throw std::bad_array_new_length();
+    if constexpr (std::is_trivially_destructible_v<T>) {
+        T *items = static_cast<T*>(allocate(arena, count * sizeof(T), alignof(T)));
+        for (std::size_t i = 0; i < count; ++i) new (items + i) T;
+        return items;
+    } else {
+        ArrayRecord<T> *record = static_cast<ArrayRecord<T>*>(allocate(arena, sizeof(ArrayRecord<T>), alignof(ArrayRecord<T>)));
+        T *items = static_cast<T*>(allocate(arena, count * sizeof(T), alignof(T)));
+        std::size_t made = 0;
+        try {
+            for (; made < count; ++made) new (items + made) T;
+        } catch (...) {
+            while (made > 0) items[--made].~T();
+            throw;
+        }
+
+        *record = ArrayRecord<T>{ items, count };
+        if (!arena_defer(arena, destroy_array<T>, record)) {
+            destroy_array<T>(record);
+            throw std::bad_alloc();
+        }
+        return items;
+    }
+}
+
+inline Arena *check(Arena *arena)
+{
+    if (!arena || !arena->head_chunk) throw std::invalid_argument("arena is not initialized");
+    // containers keep raw pointers, memory must stay where it was handed out
+    if (arena->growth_contract == ARENA_GROWTH_CONTRACT_REALLOC) throw std::invalid_argument("realloc arenas move memory");
+    return arena;
+}
+
+} // namespace arena_detail
+
+class ArenaResource : public std::pmr::memory_resource {
+public:
+    explicit ArenaResource(Arena *arena) : arena_(arena_detail::check(arena)) {}
+
+    explicit ArenaResource(ArenaConfig config) : owned_(arena_create_ex(config)), arena_(&owned_)
+    {
+        if (!owned_.head_chunk) throw std::bad_alloc();
+        if (owned_.growth_contract == ARENA_GROWTH_CONTRACT_REALLOC) {
+            arena_destroy(&owned_);
+            throw std::invalid_argument("realloc arenas move memory");
+        }
+    }
+
+    ~ArenaResource() override
+    {
+        if (arena_ == &owned_) arena_destroy(&owned_);
+    }
+
+    ArenaResource(const ArenaResource&)            = delete;
+    ArenaResource &operator=(const ArenaResource&) = delete;
+
+    Arena *arena() const noexcept { return arena_; }
+    bool   reset() noexcept { return arena_reset(arena_); }
+
+    /*
+    - `make<T>(args...)` constructs one object, `make_array<T>(n)` default-initializes n of them (like `new T[n]`)
+    - Non-trivial destructors run on reset, restore past the object (ArenaScope) or destroy, newest first
+    - Never `delete` the result, the arena owns it
+    */
+    template <typename T, typename... Args>
+    T *make(Args&&... args) { return arena_detail::make<T>(arena_, std::forward<Args>(args)...); }
+
+    template <typename T>
+    T *make_array(std::size_t count) { return arena_detail::make_array<T>(arena_, count); }
+
+protected:
+    void *do_allocate(std::size_t bytes, std::size_t alignment) override
+    {
+        return arena_detail::allocate(arena_, bytes, alignment);
+    }
+
+    void do_deallocate(void *p, std::size_t bytes, std::size_t) noexcept override
+    {
+        arena_detail::release(arena_, p, bytes);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override
+    {
+        const ArenaResource *that = dynamic_cast<const ArenaResource*>(&other);
+        return that && that->arena_ == arena_;
+    }
+
+private:
+    Arena owned_ = {};
+    Arena *arena_;
+};
+
+template <typename T>
+class ArenaAllocator {
+public:
+    /*
+    - Just the arena pointer, no virtual call per allocation (unlike polymorphic_allocator)
+    - Copies compare equal when they point at the same arena
+    - Follows the container on copy, move and swap so nodes never outlive their arena's owner
+    */
+    using value_type                             = T;
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap            = std::true_type;
+    using is_always_equal                        = std::false_type;
+
+    explicit ArenaAllocator(Arena *arena) : arena_(arena_detail::check(arena)) {}
+    ArenaAllocator(ArenaResource &resource) noexcept : arena_(resource.arena()) {}
+
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U> &other) noexcept : arena_(other.arena()) {}
+
+    T *allocate(std::size_t n)
+    {
+        if (n > SIZE_MAX / sizeof(T)) throw std::bad_array_new_length();
+        return static_cast<T*>(arena_detail::allocate(arena_, n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T *p, std::size_t n) noexcept
+    {
+        arena_detail::release(arena_, p, n * sizeof(T));
+    }
+
+    Arena *arena() const noexcept { return arena_; }
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U> &other) const noexcept { return arena_ == other.arena(); }
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U> &other) const noexcept { return arena_ != other.arena(); }
+
+private:
+    Arena *arena_;
+};
+
+class ArenaScope {
+public:
+    /*
+    - Everything allocated while the scope is alive is released when it ends
+    - Scopes nest, end them in LIFO order (automatic with block scope)
+    - Containers using the arena must be destroyed before the scope ends
+    */
+    explicit ArenaScope(Arena *arena) noexcept : temp_(arena_temp_begin(arena)) {}
+    explicit ArenaScope(ArenaResource &resource) noexcept : temp_(arena_temp_begin(resource.arena())) {}
+    ~ArenaScope() { arena_temp_end(temp_); }
+
+    ArenaScope(const ArenaScope&)            = delete;
+    ArenaScope &operator=(const ArenaScope&) = delete;
+
+    Arena *arena() const noexcept { return temp_.arena; }
+
+private:
+    ArenaTemp temp_;
+};
+
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#include <coroutine>
+
+namespace arena_detail {
+
+inline thread_local Arena *frame_arena = nullptr;
+
+// frame remembers where it came from, it may be destroyed after the scope that made it is gone
+constexpr std::size_t FRAME_HEADER = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+
+// whole header units, so no padding sneaks in between frames and LIFO release reaches every one of them
+constexpr std::size_t frame_block_size(std::size_t size)
+{
+    return (size + 2*FRAME_HEADER - 1) & ~(FRAME_HEADER - 1);
+}
+
+inline void *frame_allocate(Arena *arena, std::size_t size)
+{
+    void *block = arena ? allocate(arena, frame_block_size(size), FRAME_HEADER) : ::operator new(frame_block_size(size));
+    *static_cast<Arena**>(block) = arena;
+    return static_cast<char*>(block) + FRAME_HEADER;
+}
+
+inline void frame_release(void *frame, std::size_t size) noexcept
+{
+    void *block  = static_cast<char*>(frame) - FRAME_HEADER;
+    Arena *arena = *static_cast<Arena**>(block);
+    if (arena) release(arena, block, frame_block_size(size));
+    else ::operator delete(block, frame_block_size(size));
+}
+
+} // namespace arena_detail
+
+class ArenaFrameScope {
+public:
+    /*
+    - Coroutines with `ArenaPromise` started on this thread while the scope is alive put their frames on `arena`
+    - Scopes nest, the previous arena comes back when the scope ends
+    - Frames stay valid after the scope ends, they belong to the arena: release a finished task tree
+      in bulk with `arena_reset` / `ArenaScope`, frames destroyed in LIFO order give bytes back right away
+    */
+    explicit ArenaFrameScope(Arena *arena) : previous_(arena_detail::frame_arena)
+    {
+        arena_detail::frame_arena = arena_detail::check(arena);
+    }
+    explicit ArenaFrameScope(ArenaResource &resource) noexcept : previous_(arena_detail::frame_arena)
+    {
+        arena_detail::frame_arena = resource.arena();
+    }
+    ~ArenaFrameScope() { arena_detail::frame_arena = previous_; }
+
+    ArenaFrameScope(const ArenaFrameScope&)            = delete;
+    ArenaFrameScope &operator=(const ArenaFrameScope&) = delete;
+
+private:
+    Arena *previous_;
+};
+
+struct ArenaPromise {
+    /*
+    - Base for a promise type, frame allocation picks the arena:
+      1. first coroutine parameter `Arena*` or `ArenaResource&` (task scoped)
+      2. innermost `ArenaFrameScope` of the calling thread
+      3. global operator new when there is neither
+    - Arenas are not thread safe: frames have to be created and destroyed on a thread that owns their arena
+    */
+    static void *operator new(std::size_t size)
+    {
+        return arena_detail::frame_allocate(arena_detail::frame_arena, size);
+    }
+
+    template <typename... Args>
+    static void *operator new(std::size_t size, Arena *arena, Args&&...)
+    {
+        return arena_detail::frame_allocate(arena_detail::check(arena), size);
+    }
+
+    template <typename... Args>
+    static void *operator new(std::size_t size, ArenaResource &resource, Args&&...)
+    {
+        return arena_detail::frame_allocate(resource.arena(), size);
+    }
+
+    static void operator delete(void *frame, std::size_t size) noexcept
+    {
+        arena_detail::frame_release(frame, size);
+    }
+};
+#endif // __cpp_impl_coroutine
+
+#endif // ARENA_HPP_
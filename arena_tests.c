@@ -1,6 +1,11 @@
 #include <stdio.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
 #include <time.h>
+#include <sys/wait.h>
+#include <signal.h>
+#include <sys/socket.h>
 // #define ARENA_PLATFORM ARENA_PLATFORM_LIBC
 // #define ARENA_LOGGING
 #define ARENA_IMPLEMENTATION
@@ -161,6 +166,44 @@ TEST_CREATE(test_arena_reset_chunky)
     return true;
 }
 
+TEST_CREATE(test_arena_reset_chunky_cycles)
+{
+    Arena arena = arena_create_ex(arena_config_create(
+        ARENA_CAPACITY_1KB,
+        ARENA_CAPACITY_16KB,
+        ARENA_GROWTH_CONTRACT_CHUNKY,
+        ARENA_GROWTH_FACTOR_CHUNKY_4KB,
+        ARENA_FLAG_NONE
+    ));
+    ASSERT(arena.last_chunk != NULL);
+
+    uint32_t chunk_count = 0, owned_count = 0;
+    for (int cycle = 0; cycle < 1000; ++cycle) {
+        for (int i = 0; i < 3; ++i) {
+            ASSERT(arena_alloc_raw(&arena, 0xC00, ARENA_ALIGN_CACHELINE) != NULL);
+        }
+        if (cycle == 0) {
+            chunk_count = arena.chunk_count;
+            owned_count = arena.owned_count;
+            ASSERT(chunk_count > 1);
+        }
+        ASSERT(arena.chunk_count <= chunk_count);
+        ASSERT(arena.owned_count <= owned_count);
+        ASSERT(arena.reserved <= arena.max_capacity);
+
+        ASSERT(arena_reset(&arena));
+        ASSERT(arena.chunk_count == 1);
+        ASSERT(arena.last_chunk == arena.head_chunk);
+        ASSERT(arena.reserved == arena.head_chunk->capacity);
+        ASSERT(arena.owned_count == owned_count);
+    }
+
+    arena_destroy(&arena);
+    ASSERT(arena.last_chunk == NULL);
+
+    return true;
+}
+
 TEST_CREATE(test_arena_grow_chunky)
 {
     Arena arena = arena_create_ex(arena_config_create(
@@ -343,6 +386,1608 @@ TEST_CREATE(test_arena_stress_no_grow)
     return true;
 }
 
+TEST_CREATE(test_arena_ring_wrap)
+{
+    ArenaRing ring = arena_ring_create(ARENA_CAPACITY_4KB);
+    ASSERT(ring.base != NULL);
+    ASSERT(ring.capacity >= ARENA_CAPACITY_4KB);
+
+    arena_size_t capacity = ring.capacity;
+
+    uint8_t *a = arena_ring_alloc(&ring, capacity - 100, ARENA_ALIGN_8B);
+    ASSERT(a == ring.base);
+    arena_ring_commit(&ring);
+
+    ASSERT(arena_ring_alloc(&ring, 200, 1) == NULL);
+    ASSERT(ring.error == ARENA_ERROR_RING_FULL);
+
+    ASSERT(arena_ring_release_to(&ring, a + capacity - 100));
+
+    // this record crosses the end of the buffer
+    uint8_t *r = arena_ring_alloc(&ring, 200, 1);
+    ASSERT(r == a + capacity - 100);
+    for (int i = 0; i < 200; ++i) r[i] = (uint8_t)i;
+    arena_ring_commit(&ring);
+
+    ASSERT(ring.base[99] == 199); // wrapped tail is visible at the start
+
+    arena_size_t available = 0;
+    uint8_t *p = arena_ring_peek(&ring, &available);
+    ASSERT(p == r);
+    ASSERT(available == 200);
+
+    ASSERT(arena_ring_release(&ring, 200));
+    ASSERT(!arena_ring_release(&ring, 1));
+    arena_ring_peek(&ring, &available);
+    ASSERT(available == 0);
+
+    // tail sits before the end of the buffer while the record after it was handed out at the start
+    ASSERT(arena_ring_alloc(&ring, capacity - 150, 1) == ring.base + 100);
+    arena_ring_commit(&ring);
+    ASSERT(arena_ring_release(&ring, capacity - 150));
+    uint8_t *q = arena_ring_alloc(&ring, 50, 1);
+    uint8_t *s = arena_ring_alloc(&ring, 32, 1);
+    ASSERT(q == ring.base + capacity - 50 && s == ring.base);
+    arena_ring_commit(&ring);
+    ASSERT(!arena_ring_release_to(&ring, ring.base + capacity * 2 + 1));
+    ASSERT(arena_ring_release_to(&ring, s + 32));
+    arena_ring_peek(&ring, &available);
+    ASSERT(available == 0);
+
+    // full ring, end lands a whole view past the tail
+    uint8_t *full = arena_ring_alloc(&ring, capacity, 1);
+    ASSERT(full == ring.base + 32);
+    arena_ring_commit(&ring);
+    ASSERT(arena_ring_release_to(&ring, full + capacity));
+    arena_ring_peek(&ring, &available);
+    ASSERT(available == 0);
+
+    arena_ring_destroy(&ring);
+    ASSERT(ring.base == NULL);
+
+    return true;
+}
+
+TEST_CREATE(test_arena_temp_nested)
+{
+    Arena arena = arena_create_ex(arena_config_create(
+        ARENA_CAPACITY_1KB,
+        ARENA_CAPACITY_16KB,
+        ARENA_GROWTH_CONTRACT_CHUNKY,
+        ARENA_GROWTH_FACTOR_CHUNKY_1KB,
+        ARENA_FLAG_NONE
+    ));
+    ASSERT(arena.last_chunk != NULL);
+
+    uint8_t *a = arena_alloc_raw(&arena, 100, ARENA_ALIGN_8B);
+    ASSERT(a != NULL);
+    arena_memset(a, 0xAA, 100);
+    arena_size_t after_a = arena.last_chunk->offset;
+
+    ArenaTemp outer = arena_temp_begin(&arena);
+    uint8_t *b = arena_alloc_raw(&arena, 200, ARENA_ALIGN_8B);
+    ASSERT(b != NULL);
+    arena_memset(b, 0xBB, 200);
+    arena_size_t after_b = arena.last_chunk->offset;
+    arena_size_t reserved = arena.reserved;
+
+    ArenaTemp inner = arena_temp_begin(&arena);
+    uint8_t *c = arena_alloc_raw(&arena, 2000, ARENA_ALIGN_8B);
+    ASSERT(c != NULL);
+    ASSERT(arena.last_chunk != arena.head_chunk);
+    ASSERT(arena.reserved > reserved);
+
+    ASSERT(arena_temp_end(inner));
+    ASSERT(arena.last_chunk == arena.head_chunk);
+    ASSERT(arena.last_chunk->offset == after_b);
+    ASSERT(arena.reserved == reserved);
+    ASSERT(arena.free_chunks != NULL);
+    ASSERT(a[99] == 0xAA && b[199] == 0xBB); // memory before the mark is untouched
+
+    uint8_t *d = arena_alloc_raw(&arena, 2000, ARENA_ALIGN_8B);
+    ASSERT(d == c); // cached chunk reused
+    ASSERT(arena.free_chunks == NULL);
+
+    ASSERT(arena_temp_end(outer));
+    ASSERT(arena.last_chunk->offset == after_a);
+    ASSERT(a[0] == 0xAA);
+
+    {
+        ARENA_TEMP_SCOPE(scope, &arena);
+        ASSERT(arena_alloc_raw(&arena, 512, ARENA_ALIGN_8B) != NULL);
+    }
+    ASSERT(arena.last_chunk->offset == after_a);
+
+    arena_trim(&arena);
+    ASSERT(arena.free_chunks == NULL);
+
+    arena_destroy(&arena);
+    ASSERT(arena.last_chunk == NULL);
+
+    return true;
+}
+
+TEST_CREATE(test_arena_handles)
+{
+    ASSERT(sizeof(ArenaHandle) == 8);
+
+    Arena arena = arena_create_ex(arena_config_create(
+        ARENA_CAPACITY_1KB,
+        ARENA_CAPACITY_64KB,
+        ARENA_GROWTH_CONTRACT_CHUNKY,
+        ARENA_GROWTH_FACTOR_CHUNKY_1KB,
+        ARENA_FLAG_NONE
+    ));
+
+    ArenaHandle handles[64];
+    for (int i = 0; i < 64; ++i) {
+        handles[i] = arena_alloc_handle(&arena, 100, ARENA_ALIGN_8B);
+        ASSERT(handles[i] != ARENA_HANDLE_NULL);
+        *(int*)arena_handle_resolve(&arena, handles[i]) = i;
+    }
+    ASSERT(arena.chunk_count > 1);
+
+    for (int i = 0; i < 64; ++i) {
+        int *p = arena_handle_resolve(&arena, handles[i]);
+        ASSERT(p != NULL && *p == i);
+    }
+
+    ArenaMark mark = arena_mark(&arena);
+    ArenaHandle temp = arena_alloc_handle(&arena, 2000, ARENA_ALIGN_8B);
+    ASSERT(arena_handle_resolve(&arena, temp) != NULL);
+    ASSERT(arena_restore(&arena, mark, false));
+    ASSERT(arena_handle_resolve(&arena, temp) == NULL);
+    ASSERT(arena.error == ARENA_ERROR_INVALID_HANDLE);
+
+    arena_reset(&arena);
+    ASSERT(arena_handle_resolve(&arena, handles[0]) == NULL);
+    ASSERT(arena.error == ARENA_ERROR_EPOCH_MISMATCH);
+    arena_destroy(&arena);
+
+    // handles survive chunk relocation
+    arena = arena_create_ex(arena_config_create(
+        ARENA_CAPACITY_1KB,
+        ARENA_CAPACITY_1MB,
+        ARENA_GROWTH_CONTRACT_REALLOC,
+        ARENA_GROWTH_FACTOR_REALLOC_2X,
+        ARENA_FLAG_NONE
+    ));
+    ArenaHandle h = arena_alloc_handle(&arena, sizeof(int), alignof(int));
+    *(int*)arena_handle_resolve(&arena, h) = 0x1F;
+    ASSERT(arena_alloc_raw(&arena, 0x10000, ARENA_ALIGN_8B) != NULL);
+    ASSERT(*(int*)arena_handle_resolve(&arena, h) == 0x1F);
+    arena_destroy(&arena);
+
+    return true;
+}
+
+TEST_CREATE(test_arena_chunk_directory)
+{
+    Arena arena = arena_create_ex(arena_config_create(
+        ARENA_CAPACITY_1KB,
+        ARENA_CAPACITY_64KB,
+        ARENA_GROWTH_CONTRACT_CHUNKY,
+        ARENA_GROWTH_FACTOR_CHUNKY_1KB,
+        ARENA_FLAG_NONE
+    ));
+
+    int local = 0;
+    ASSERT(!arena_owns(&arena, &local));
+
+    void *ptrs[32];
+    for (int i = 0; i < 32; ++i) {
+        ptrs[i] = arena_alloc_raw(&arena, 300, ARENA_ALIGN_8B);
+        ASSERT(ptrs[i] != NULL);
+    }
+    ASSERT(arena.chunk_count > 8);
+    ASSERT(arena.owned_count == arena.chunk_count);
+
+    for (int i = 0; i < 32; ++i) {
+        ArenaChunk *chunk = arena_chunk_of(&arena, ptrs[i]);
+        ASSERT(chunk != NULL);
+        ASSERT(arena.chunks[chunk->index] == chunk);
+        ASSERT(arena_owns(&arena, (uint8_t*)ptrs[i] + 299));
+
+        ArenaHandle handle = arena_handle_of(&arena, ptrs[i]);
+        ASSERT(arena_handle_resolve(&arena, handle) == ptrs[i]);
+    }
+    ASSERT(!arena_owns(&arena, &local));
+
+    ArenaMark mark = arena_mark(&arena);
+    void *temp = arena_alloc_raw(&arena, 2000, ARENA_ALIGN_8B);
+    ASSERT(arena_owns(&arena, temp));
+    arena_restore(&arena, mark, false);
+    ASSERT(!arena_owns(&arena, temp)); // cached chunk is not in use
+    ASSERT(arena.owned_count == arena.chunk_count + 1);
+
+    arena_trim(&arena);
+    ASSERT(arena.owned_count == arena.chunk_count);
+
+    arena_destroy(&arena);
+    return true;
+}
+
+TEST_CREATE(test_arena_table_compact)
+{
+    ArenaTable table = arena_table_create(arena_config_create(
+        ARENA_CAPACITY_4KB,
+        ARENA_CAPACITY_1MB,
+        ARENA_GROWTH_CONTRACT_CHUNKY,
+        ARENA_GROWTH_FACTOR_CHUNKY_4KB,
+        ARENA_FLAG_NONE
+    ));
+    ASSERT(table.arena.head_chunk != NULL);
+
+    ArenaRef refs[1000];
+    for (int i = 0; i < 1000; ++i) {
+        refs[i] = arena_table_alloc(&table, 64, ARENA_ALIGN_8B);
+        ASSERT(refs[i] != ARENA_REF_NULL);
+        *(int*)arena_table_get(&table, refs[i]) = i;
+    }
+
+    for (int i = 0; i < 1000; ++i) {
+        if (i % 4) ASSERT(arena_table_free(&table, refs[i]));
+    }
+    ASSERT(arena_table_get(&table, refs[1]) == NULL);
+    ASSERT(!arena_table_free(&table, refs[1]));
+    ASSERT(arena_table_fragmentation(&table) > 0.7);
+
+    arena_size_t reserved = table.arena.reserved;
+    ASSERT(arena_compact(&table));
+    ASSERT(table.arena.reserved < reserved / 2);
+    ASSERT(arena_table_fragmentation(&table) == 0.0);
+
+    for (int i = 0; i < 1000; i += 4) {
+        int *p = arena_table_get(&table, refs[i]);
+        ASSERT(p != NULL && *p == i);
+    }
+
+    // freed slot is reused, old ref to it stays dead
+    ArenaRef reused = arena_table_alloc(&table, 16, ARENA_ALIGN_8B);
+    ASSERT(reused != ARENA_REF_NULL);
+    ASSERT((uint32_t)reused == (uint32_t)refs[999]);
+    ASSERT(arena_table_get(&table, refs[999]) == NULL);
+    ASSERT(arena_table_get(&table, reused) != NULL);
+
+    arena_table_destroy(&table);
+    ASSERT(table.entries == NULL);
+
+    return true;
+}
+
+typedef struct TestNode {
+    int             value;
+    struct TestNode *left;
+    struct TestNode *right;
+} TestNode;
+
+static arena_size_t test_node_trace(void *object, size_t *alignment, ArenaVisitFn visit, void *ctx)
+{
+    (void)alignment;
+    TestNode *node = object;
+    if (visit) {
+        visit((void**)&node->left, ctx);
+        visit((void**)&node->right, ctx);
+    }
+    return sizeof(TestNode);
+}
+
+typedef struct TestWide {
+    struct TestWide *next;
+    alignas(64) float lanes[16];
+} TestWide;
+
+static arena_size_t test_wide_trace(void *object, size_t *alignment, ArenaVisitFn visit, void *ctx)
+{
+    TestWide *wide = object;
+    if (alignment) *alignment = alignof(TestWide);
+    if (visit) visit((void**)&wide->next, ctx);
+    return sizeof(TestWide);
+}
+
+TEST_CREATE(test_arena_evacuate)
+{
+    ArenaConfig config = arena_config_create(
+        ARENA_CAPACITY_4KB,
+        ARENA_CAPACITY_1MB,
+        ARENA_GROWTH_CONTRACT_CHUNKY,
+        ARENA_GROWTH_FACTOR_CHUNKY_4KB,
+        ARENA_FLAG_NONE
+    );
+    Arena from = arena_create_ex(config);
+    Arena to   = arena_create_ex(config);
+
+    // list of 100 nodes, garbage between them, every node also points to the shared one
+    TestNode *shared = arena_alloc_struct(&from, TestNode);
+    *shared = (TestNode){ .value = -1 };
+
+    TestNode *head = NULL;
+    for (int i = 0; i < 100; ++i) {
+        TestNode *garbage = arena_alloc_struct(&from, TestNode);
+        ASSERT(garbage != NULL);
+        TestNode *node = arena_alloc_struct(&from, TestNode);
+        *node = (TestNode){ .value = i, .left = head, .right = shared };
+        head = node;
+    }
+    shared->left = head; // cycle
+
+    void *roots[1] = { head };
+    ASSERT(arena_evacuate(&from, &to, roots, 1, test_node_trace));
+
+    TestNode *moved = roots[0];
+    ASSERT(arena_owns(&to, moved));
+    ASSERT(moved->right->left == moved);
+
+    int expected = 99, count = 0;
+    for (TestNode *n = moved; n; n = n->left, --expected, ++count) {
+        ASSERT(arena_owns(&to, n));
+        ASSERT(n->value == expected);
+        ASSERT(n->right == moved->right); // shared node copied once
+    }
+    ASSERT(count == 100);
+
+    arena_reset(&from);
+    ASSERT(moved->left->left->value == 97);
+
+    // copies keep the alignment reported by trace
+    TestWide *wide = NULL;
+    for (int i = 0; i < 10; ++i) {
+        ASSERT(arena_alloc_raw(&from, 24, ARENA_ALIGN_8B) != NULL);
+        TestWide *w = arena_alloc_raw(&from, sizeof(TestWide), alignof(TestWide));
+        *w = (TestWide){ .next = wide, .lanes = { (float)i } };
+        wide = w;
+    }
+    ASSERT(arena_alloc_raw(&to, 24, ARENA_ALIGN_8B) != NULL);
+    roots[0] = wide;
+    ASSERT(arena_evacuate(&from, &to, roots, 1, test_wide_trace));
+
+    expected = 9;
+    for (TestWide *w = roots[0]; w; w = w->next, --expected) {
+        ASSERT(arena_owns(&to, w));
+        ASSERT(((arena_ptr_t)w & (alignof(TestWide) - 1)) == 0);
+        ASSERT(w->lanes[0] == (float)expected);
+    }
+    ASSERT(expected == -1);
+
+    arena_destroy(&from);
+    arena_destroy(&to);
+
+    return true;
+}
+
+TEST_CREATE(test_arena_generations)
+{
+    ArenaGen gen = arena_gen_create(
+        arena_config_create(ARENA_CAPACITY_4KB, ARENA_CAPACITY_64KB, ARENA_GROWTH_CONTRACT_CHUNKY, ARENA_GROWTH_FACTOR_CHUNKY_4KB, ARENA_FLAG_NONE),
+        arena_config_create(ARENA_CAPACITY_4KB, ARENA_CAPACITY_1MB, ARENA_GROWTH_CONTRACT_FIXED, ARENA_GROWTH_FACTOR_CHUNKY_4KB, ARENA_FLAG_NONE)
+    );
+    ASSERT(gen.nursery.head_chunk != NULL && gen.tenured.head_chunk != NULL);
+    ASSERT(gen.tenured.growth_contract == ARENA_GROWTH_CONTRACT_CHUNKY);
+
+    int *survivors[10];
+    TestNode *graph_root = NULL;
+    for (int cycle = 0; cycle < 10; ++cycle) {
+        int *last = NULL;
+        for (int i = 0; i < 100; ++i) {
+            last = arena_gen_alloc(&gen, 64, ARENA_ALIGN_8B);
+            ASSERT(last != NULL);
+            *last = cycle;
+        }
+        ASSERT(gen.nursery.chunk_count > 1);
+
+        survivors[cycle] = arena_gen_promote(&gen, last, 64, ARENA_ALIGN_8B);
+        ASSERT(survivors[cycle] != NULL);
+
+        arena_gen_cycle(&gen);
+        ASSERT(gen.nursery.last_chunk == gen.nursery.head_chunk);
+        ASSERT(gen.nursery.head_chunk->offset == 0);
+    }
+
+    for (int cycle = 0; cycle < 10; ++cycle) ASSERT(*survivors[cycle] == cycle);
+    ASSERT(gen.stats.cycles == 10);
+    ASSERT(gen.stats.promoted_objects == 10);
+    ASSERT(arena_gen_survival_rate(&gen) > 0.009 && arena_gen_survival_rate(&gen) < 0.011);
+
+    TestNode *a = arena_gen_alloc(&gen, sizeof(TestNode), alignof(TestNode));
+    TestNode *b = arena_gen_alloc(&gen, sizeof(TestNode), alignof(TestNode));
+    *a = (TestNode){ .value = 1, .left = b };
+    *b = (TestNode){ .value = 2 };
+    graph_root = a;
+    ASSERT(arena_gen_promote_graph(&gen, (void**)&graph_root, 1, test_node_trace));
+    ASSERT(gen.stats.promoted_objects == 12);
+    arena_gen_cycle(&gen);
+    ASSERT(arena_owns(&gen.tenured, graph_root->left));
+    ASSERT(graph_root->left->value == 2);
+
+    // nursery reset behind the generation's back still ends the cycle clean
+    ASSERT(arena_gen_alloc(&gen, 64, ARENA_ALIGN_8B) != NULL);
+    ASSERT(arena_reset(&gen.nursery));
+    for (int i = 0; i < 100; ++i) ASSERT(arena_gen_alloc(&gen, 64, ARENA_ALIGN_8B) != NULL);
+    ASSERT(gen.nursery.chunk_count > 1);
+    arena_gen_cycle(&gen);
+    ASSERT(gen.nursery.last_chunk == gen.nursery.head_chunk);
+    ASSERT(gen.nursery.head_chunk->offset == 0);
+
+    arena_gen_destroy(&gen);
+    return true;
+}
+
+TEST_CREATE(test_arena_snapshot)
+{
+    const char *path = "/tmp/arena_test_snapshot.bin";
+
+    Arena arena = arena_create_ex(arena_config_create(
+        ARENA_CAPACITY_16KB,
+        ARENA_CAPACITY_1MB,
+        ARENA_GROWTH_CONTRACT_CHUNKY,
+        ARENA_GROWTH_FACTOR_CHUNKY_16KB,
+        ARENA_FLAG_NONE
+    ));
+
+    TestNode *head = NULL;
+    for (int i = 0; i < 2000; ++i) {
+        TestNode *node = arena_alloc_struct(&arena, TestNode);
+        ASSERT(node != NULL);
+        *node = (TestNode){ .value = i, .left = head };
+        head = node;
+    }
+    ASSERT(arena.chunk_count > 2);
+
+    ArenaHandle root = arena_handle_of(&arena, head);
+    uint32_t chunk_count = arena.chunk_count;
+    ASSERT(arena_snapshot_write(&arena, path) == ARENA_ERROR_NONE);
+    arena_destroy(&arena);
+
+    // original addresses are free again, pointers inside must work as is
+    Arena mapped = arena_snapshot_map(path);
+    ASSERT(mapped.head_chunk != NULL);
+    ASSERT(mapped.error == ARENA_ERROR_NONE);
+    ASSERT(mapped.chunk_count == chunk_count);
+    ASSERT(arena_handle_resolve(&mapped, root) == head);
+
+    int expected = 1999;
+    for (TestNode *n = head; n; n = n->left) ASSERT(n->value == expected--);
+    ASSERT(expected == -1);
+
+    // addresses are taken now, second copy is relocated but offsets still work
+    Arena relocated = arena_snapshot_map(path);
+    ASSERT(relocated.head_chunk != NULL);
+    ASSERT(relocated.error == ARENA_ERROR_SNAPSHOT_RELOCATED);
+    TestNode *copy = arena_handle_resolve(&relocated, root);
+    ASSERT(copy != NULL && copy != head && copy->value == 1999);
+
+    // mapped arena keeps working as regular one
+    ASSERT(arena_alloc_raw(&mapped, 0x8000, ARENA_ALIGN_8B) != NULL);
+    ASSERT(head->value == 1999);
+
+    size_t page_size = _arena_get_platform_page_size();
+    off_t head_image = (off_t)(page_size + ((arena_ptr_t)mapped.head_chunk & (page_size - 1)));
+    arena_destroy(&relocated);
+    arena_destroy(&mapped);
+
+    // chunk claiming more used bytes than it has is rejected
+    int fd = open(path, O_RDWR);
+    ASSERT(fd >= 0);
+    arena_size_t used = 0, broken = ARENA_CAPACITY_1GB;
+    ASSERT(pread(fd, &used, sizeof(used), head_image + (off_t)offsetof(ArenaChunk, offset)) == sizeof(used));
+    ASSERT(pwrite(fd, &broken, sizeof(broken), head_image + (off_t)offsetof(ArenaChunk, offset)) == sizeof(broken));
+    Arena corrupt = arena_snapshot_map(path);
+    ASSERT(corrupt.head_chunk == NULL && corrupt.error == ARENA_ERROR_SNAPSHOT_INVALID);
+    ASSERT(pwrite(fd, &used, sizeof(used), head_image + (off_t)offsetof(ArenaChunk, offset)) == sizeof(used));
+
+    // truncated file would SIGBUS on the first write into missing pages
+    ASSERT(ftruncate(fd, 8192) == 0);
+    close(fd);
+    Arena truncated = arena_snapshot_map(path);
+    ASSERT(truncated.head_chunk == NULL && truncated.error == ARENA_ERROR_SNAPSHOT_INVALID);
+    unlink(path);
+
+    Arena missing = arena_snapshot_map(path);
+    ASSERT(missing.head_chunk == NULL && missing.error == ARENA_ERROR_IO);
+
+    return true;
+}
+
+TEST_CREATE(test_arena_file_backed)
+{
+    const char *path = "/tmp/arena_test_file.bin";
+
+    Arena arena = arena_create_file(path, arena_config_create(
+        ARENA_CAPACITY_16KB,
+        ARENA_CAPACITY_1MB,
+        ARENA_GROWTH_CONTRACT_CHUNKY,
+        ARENA_GROWTH_FACTOR_CHUNKY_16KB,
+        ARENA_FLAG_NONE
+    ));
+    ASSERT(arena.head_chunk != NULL);
+    ASSERT(arena.error == ARENA_ERROR_NONE);
+
+    ArenaHandle handles[64];
+    for (int i = 0; i < 64; ++i) {
+        handles[i] = arena_alloc_handle(&arena, 1024, ARENA_ALIGN_8B);
+        ASSERT(handles[i] != ARENA_HANDLE_NULL);
+        arena_memset(arena_handle_resolve(&arena, handles[i]), i, 1024);
+    }
+    ASSERT(arena.chunk_count > 2);
+
+    uint32_t chunk_count = arena.chunk_count;
+    ASSERT(arena_sync(&arena));
+    arena_destroy(&arena);
+
+    // chunks are mapped elsewhere, handles still resolve
+    Arena reopened = arena_open_file(path);
+    ASSERT(reopened.head_chunk != NULL);
+    ASSERT(reopened.error == ARENA_ERROR_NONE);
+    ASSERT(reopened.chunk_count == chunk_count);
+    for (int i = 0; i < 64; ++i) {
+        uint8_t *data = arena_handle_resolve(&reopened, handles[i]);
+        ASSERT(data != NULL && data[0] == i && data[1023] == i);
+    }
+
+    // grows the file, restore leaves cached chunk that must survive reopen
+    ArenaMark mark = arena_mark(&reopened);
+    ArenaHandle extra = arena_alloc_handle(&reopened, 0x8000, ARENA_ALIGN_8B);
+    ASSERT(extra != ARENA_HANDLE_NULL);
+    ASSERT(reopened.chunk_count == chunk_count + 1);
+    ASSERT(arena_restore(&reopened, mark, false));
+    ASSERT(reopened.free_chunks != NULL);
+    uint32_t owned_count = reopened.owned_count;
+    arena_destroy(&reopened);
+
+    Arena again = arena_open_file(path);
+    ASSERT(again.head_chunk != NULL);
+    ASSERT(again.chunk_count == chunk_count);
+    ASSERT(again.owned_count == owned_count);
+    ASSERT(again.free_chunks != NULL);
+    ASSERT(((uint8_t*)arena_handle_resolve(&again, handles[63]))[0] == 63);
+    arena_destroy(&again);
+    unlink(path);
+
+    Arena realloc_arena = arena_create_file(path, arena_config_create(
+        ARENA_CAPACITY_16KB, ARENA_CAPACITY_1MB, ARENA_GROWTH_CONTRACT_REALLOC, ARENA_GROWTH_FACTOR_REALLOC_2X, ARENA_FLAG_NONE
+    ));
+    ASSERT(realloc_arena.head_chunk == NULL && realloc_arena.error == ARENA_ERROR_GROWTH_FORBIDDEN);
+
+    Arena missing = arena_open_file(path);
+    ASSERT(missing.head_chunk == NULL && missing.error == ARENA_ERROR_IO);
+
+    return true;
+}
+
+TEST_CREATE(test_arena_shared)
+{
+    enum { BLOCKS = 2000, BLOCK_SIZE = 48 };
+    char name[64];
+    snprintf(name, sizeof(name), "/arena_test_shared_%d", (int)getpid());
+
+    Arena arena = arena_create_shared(name, arena_config_create(
+        ARENA_CAPACITY_1MB, ARENA_CAPACITY_1MB, ARENA_GROWTH_CONTRACT_FIXED, ARENA_GROWTH_FACTOR_NONE, ARENA_FLAG_NONE
+    ));
+    ASSERT(arena.head_chunk != NULL);
+    ASSERT(arena.flags & ARENA_FLAG_SHARED);
+
+    // child reports its handles through the arena itself
+    ArenaHandle table = arena_alloc_handle(&arena, sizeof(ArenaHandle) * BLOCKS, ARENA_ALIGN_8B);
+    ASSERT(table != ARENA_HANDLE_NULL);
+
+    pid_t pid = fork();
+    ASSERT(pid >= 0);
+    if (pid == 0) {
+        Arena attached = arena_attach_shared(name);
+        ArenaHandle *handles = arena_handle_resolve(&attached, table);
+        if (!handles) _exit(1);
+        for (int i = 0; i < BLOCKS; ++i) {
+            handles[i] = arena_alloc_handle(&attached, BLOCK_SIZE, ARENA_ALIGN_16B);
+            uint8_t *block = arena_handle_resolve(&attached, handles[i]);
+            if (!block) _exit(2);
+            arena_memset(block, 'c', BLOCK_SIZE);
+        }
+        arena_destroy(&attached);
+        _exit(0);
+    }
+
+    uint8_t *mine[BLOCKS];
+    for (int i = 0; i < BLOCKS; ++i) {
+        mine[i] = arena_alloc_raw(&arena, BLOCK_SIZE, ARENA_ALIGN_16B);
+        ASSERT(mine[i] != NULL);
+        arena_memset(mine[i], 'p', BLOCK_SIZE);
+    }
+
+    int status = 0;
+    ASSERT(waitpid(pid, &status, 0) == pid);
+    ASSERT(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+    // concurrent bumps never overlapped
+    ArenaHandle *handles = arena_handle_resolve(&arena, table);
+    ASSERT(handles != NULL);
+    for (int i = 0; i < BLOCKS; ++i) {
+        uint8_t *theirs = arena_handle_resolve(&arena, handles[i]);
+        ASSERT(theirs != NULL);
+        for (int b = 0; b < BLOCK_SIZE; ++b) ASSERT(theirs[b] == 'c' && mine[i][b] == 'p');
+    }
+
+    // reset in another process invalidates handles here
+    Arena other = arena_attach_shared(name);
+    ASSERT(other.head_chunk != NULL && other.head_chunk != arena.head_chunk);
+    ASSERT(arena_reset(&other));
+    ASSERT(arena_handle_resolve(&arena, handles[0]) == NULL);
+    ASSERT(arena.error == ARENA_ERROR_EPOCH_MISMATCH);
+    ASSERT(arena_alloc_raw(&arena, BLOCK_SIZE, ARENA_ALIGN_16B) == arena.head_chunk->base);
+
+    arena_destroy(&other);
+
+    // object shrunk below the size its header claims
+    int fd = shm_open(name, O_RDWR, 0600);
+    ASSERT(fd >= 0);
+    ASSERT(ftruncate(fd, (off_t)(2 * _arena_get_platform_page_size())) == 0);
+    close(fd);
+    Arena shrunk = arena_attach_shared(name);
+    ASSERT(shrunk.head_chunk == NULL && shrunk.error == ARENA_ERROR_SHARED_INVALID);
+
+    ASSERT(arena_shared_unlink(name));
+    Arena gone = arena_attach_shared(name);
+    ASSERT(gone.head_chunk == NULL && gone.error == ARENA_ERROR_IO);
+    arena_destroy(&arena); // only the header page and chunk header are still backed
+
+    Arena chunky = arena_create_shared(NULL, arena_config_create(
+        ARENA_CAPACITY_16KB, ARENA_CAPACITY_1MB, ARENA_GROWTH_CONTRACT_CHUNKY, ARENA_GROWTH_FACTOR_CHUNKY_16KB, ARENA_FLAG_NONE
+    ));
+    ASSERT(chunky.head_chunk == NULL && chunky.error == ARENA_ERROR_GROWTH_FORBIDDEN);
+
+    return true;
+}
+
+typedef struct RelNode {
+    int           value;
+    ArenaRelPtr32 next;
+    ArenaRelPtr64 prev;
+} RelNode;
+
+TEST_CREATE(test_arena_relptr)
+{
+    Arena arena = arena_create_ex(arena_config_create(
+        ARENA_CAPACITY_4KB,
+        ARENA_CAPACITY_1MB,
+        ARENA_GROWTH_CONTRACT_REALLOC,
+        ARENA_GROWTH_FACTOR_REALLOC_2X,
+        ARENA_FLAG_NONE
+    ));
+
+    ArenaChunk *original = arena.head_chunk;
+    ArenaHandle first = ARENA_HANDLE_NULL;
+    ArenaHandle tail  = ARENA_HANDLE_NULL;
+    for (int i = 0; i < 4000; ++i) {
+        RelNode *node = arena_alloc_struct(&arena, RelNode);
+        ASSERT(node != NULL);
+        *node = (RelNode){ .value = i };
+
+        RelNode *prev = arena_handle_resolve(&arena, tail); // chunk may have moved with this alloc
+        if (!prev) first = arena_handle_of(&arena, node);
+        else {
+            ASSERT(arena_relptr_set(&prev->next, node));
+            ASSERT(arena_relptr_set(&node->prev, prev));
+        }
+        tail = arena_handle_of(&arena, node);
+    }
+    ASSERT(arena.head_chunk != original); // realloc moved everything at least once
+
+    // no fix-ups, links work from new location
+    int expected = 0;
+    RelNode *last = NULL;
+    for (RelNode *n = arena_handle_resolve(&arena, first); n; n = arena_relptr_get_as(&n->next, RelNode)) {
+        ASSERT(n->value == expected++);
+        last = n;
+    }
+    ASSERT(expected == 4000);
+
+    // plain copy of the block is as good as the original
+    size_t used = arena_used_bytes(&arena);
+    uint8_t *copy = malloc(used);
+    arena_memcpy(copy, arena.head_chunk->base, used);
+    RelNode *copied_last = (RelNode*)(copy + ((uint8_t*)last - arena.head_chunk->base));
+    arena_destroy(&arena);
+
+    expected = 3999;
+    for (RelNode *n = copied_last; n; n = arena_relptr_get_as(&n->prev, RelNode)) ASSERT(n->value == expected--);
+    ASSERT(expected == -1);
+    free(copy);
+
+    ArenaRelPtr32 far = {0};
+    ASSERT(arena_relptr_get(&far) == NULL);
+    ASSERT(!arena_relptr32_set(&far, (uint8_t*)&far + ((intptr_t)1 << 40)));
+    ASSERT(far.offset == 0);
+
+    return true;
+}
+
+typedef struct CNode {
+    ArenaCPtr left, right;
+    int       value;
+} CNode;
+
+TEST_CREATE(test_arena_reserve_cptr)
+{
+    Arena arena = arena_create_ex(arena_config_create(
+        ARENA_CAPACITY_4KB,
+        ARENA_CAPACITY_64MB,
+        ARENA_GROWTH_CONTRACT_RESERVE,
+        ARENA_GROWTH_FACTOR_CHUNKY_64KB,
+        ARENA_FLAG_NONE
+    ));
+    ASSERT(arena.head_chunk != NULL);
+    ASSERT(sizeof(CNode) == 12);
+
+    ArenaChunk *head = arena.head_chunk;
+    arena_size_t committed = arena.reserved;
+
+    // degenerate tree: every node points to the previous one
+    CNode *first = NULL, *prev = NULL;
+    for (int i = 0; i < 100000; ++i) {
+        CNode *node = arena_alloc_raw(&arena, sizeof(CNode), 1 << ARENA_CPTR_SHIFT);
+        ASSERT(node != NULL);
+        *node = (CNode){ .left = arena_cptr_encode(&arena, prev), .right = ARENA_CPTR_NULL, .value = i };
+        if (!first) first = node;
+        prev = node;
+    }
+
+    // grew in place, pages committed on demand
+    ASSERT(arena.head_chunk == head);
+    ASSERT(arena.reserved > committed && arena.reserved < ARENA_CAPACITY_64MB);
+    ASSERT(first->value == 0 && arena_cptr_decode(&arena, first->left) == NULL);
+
+    int expected = 99999;
+    for (CNode *n = prev; n; n = arena_cptr_decode(&arena, n->left)) ASSERT(n->value == expected--);
+    ASSERT(expected == -1);
+
+    // reset keeps committed pages
+    arena_size_t reserved = arena.reserved;
+    ASSERT(arena_reset(&arena));
+    ASSERT(arena.reserved == reserved);
+    ASSERT(arena_alloc_raw(&arena, 8, 8) == head->base);
+
+    // reservation is the hard limit
+    ASSERT(arena_alloc_raw(&arena, ARENA_CAPACITY_64MB, 8) == NULL);
+    ASSERT(arena.error == ARENA_ERROR_MAX_CAPACITY_REACHED);
+    ASSERT(arena_alloc_raw(&arena, ARENA_CAPACITY_32MB, 8) != NULL);
+
+    arena_destroy(&arena);
+    return true;
+}
+
+TEST_CREATE(test_arena_fork)
+{
+    Arena parent = arena_create_file(NULL, arena_config_create(
+        ARENA_CAPACITY_16KB,
+        ARENA_CAPACITY_1MB,
+        ARENA_GROWTH_CONTRACT_CHUNKY,
+        ARENA_GROWTH_FACTOR_CHUNKY_16KB,
+        ARENA_FLAG_NONE
+    ));
+    ASSERT(parent.head_chunk != NULL);
+
+    ArenaHandle handles[64];
+    for (int i = 0; i < 64; ++i) {
+        handles[i] = arena_alloc_handle(&parent, 1024, ARENA_ALIGN_8B);
+        arena_memset(arena_handle_resolve(&parent, handles[i]), i, 1024);
+    }
+    uint32_t chunk_count = parent.chunk_count;
+    ASSERT(chunk_count > 2);
+
+    // discarded trial leaves parent untouched
+    Arena trial = arena_fork(&parent);
+    ASSERT(trial.head_chunk != NULL && trial.head_chunk != parent.head_chunk);
+    ASSERT(trial.chunk_count == chunk_count);
+    uint8_t *block = arena_handle_resolve(&trial, handles[5]);
+    ASSERT(block != NULL && block[0] == 5);
+    arena_memset(block, 0xAA, 1024);
+    ASSERT(((uint8_t*)arena_handle_resolve(&parent, handles[5]))[0] == 5);
+    arena_destroy(&trial);
+    ASSERT(((uint8_t*)arena_handle_resolve(&parent, handles[5]))[0] == 5);
+
+    // committed trial: dirty page, new chunks of its own
+    trial = arena_fork(&parent);
+    arena_memset(arena_handle_resolve(&trial, handles[40]), 0xBB, 1024);
+    ArenaHandle extra = arena_alloc_handle(&trial, 0x8000, ARENA_ALIGN_8B);
+    ASSERT(extra != ARENA_HANDLE_NULL);
+    arena_memset(arena_handle_resolve(&trial, extra), 0xCC, 0x8000);
+    ASSERT(trial.chunk_count == chunk_count + 1);
+
+    ASSERT(arena_fork_commit(&parent, &trial));
+    ASSERT(trial.head_chunk == NULL);
+    ASSERT(parent.chunk_count == chunk_count + 1);
+    for (int i = 0; i < 64; ++i) {
+        uint8_t *data = arena_handle_resolve(&parent, handles[i]);
+        ASSERT(data != NULL && data[0] == (i == 40 ? 0xBB : i) && data[1023] == data[0]);
+    }
+    uint8_t *big = arena_handle_resolve(&parent, extra);
+    ASSERT(big != NULL && big[0] == 0xCC && big[0x7FFF] == 0xCC);
+
+    // trial that shrinks the chain, dropped parent chunks end up cached
+    trial = arena_fork(&parent);
+    ASSERT(arena_reset(&trial));
+    ASSERT(arena_alloc_raw(&trial, 16, ARENA_ALIGN_8B) != NULL);
+    ASSERT(arena_fork_commit(&parent, &trial));
+    ASSERT(parent.chunk_count == 1 && parent.free_chunks != NULL);
+    ASSERT(arena_handle_resolve(&parent, handles[0]) == NULL); // epoch moved with reset
+    ASSERT(arena_used_bytes(&parent) == 16);
+
+    // parent changed under the fork
+    trial = arena_fork(&parent);
+    ASSERT(arena_alloc_raw(&parent, 16, ARENA_ALIGN_8B) != NULL);
+    ASSERT(!arena_fork_commit(&parent, &trial));
+    ASSERT(parent.error == ARENA_ERROR_FORK_STALE);
+    arena_destroy(&trial);
+    arena_destroy(&parent);
+
+    Arena plain = arena_create(ARENA_CAPACITY_4KB);
+    Arena nope = arena_fork(&plain);
+    ASSERT(nope.head_chunk == NULL && nope.error == ARENA_ERROR_UNSUPPORTED);
+    arena_destroy(&plain);
+
+    return true;
+}
+
+static void test_relocate_visit(void **slot, void *ctx)
+{
+    *slot = arena_relocate_ptr((const ArenaRelocMap*)ctx, *slot);
+}
+
+TEST_CREATE(test_arena_flatten)
+{
+    Arena arena = arena_create_ex(arena_config_create(
+        ARENA_CAPACITY_1KB,
+        ARENA_CAPACITY_1MB,
+        ARENA_GROWTH_CONTRACT_CHUNKY,
+        ARENA_GROWTH_FACTOR_CHUNKY_1KB,
+        ARENA_FLAG_NONE
+    ));
+
+    TestNode *head = NULL;
+    void *aligned = NULL;
+    for (int i = 0; i < 500; ++i) {
+        TestNode *node = arena_alloc_struct(&arena, TestNode);
+        ASSERT(node != NULL);
+        *node = (TestNode){ .value = i, .left = head };
+        head = node;
+        if (i == 250) aligned = arena_alloc_raw(&arena, 100, ARENA_ALIGN_SIMD_AVX512);
+    }
+    arena_memset(aligned, 0x5A, 100);
+    ASSERT(arena.chunk_count > 10);
+    arena_size_t used = arena_used_bytes(&arena);
+
+    ArenaRelocMap map = {0};
+    ASSERT(arena_flatten(&arena, &map, true));
+    ASSERT(arena.chunk_count == 1 && arena.owned_count == 1);
+    ASSERT(arena_used_bytes(&arena) >= used);
+    ASSERT(arena_used_bytes(&arena) < used + (arena_size_t)_arena_get_platform_page_size() * map.count);
+
+    // fix up raw pointers, nodes are still in the same order
+    head = arena_relocate_ptr(&map, head);
+    ASSERT(arena_owns(&arena, head));
+    for (TestNode *n = head; n; n = n->left) test_node_trace(n, NULL, test_relocate_visit, &map);
+
+    int expected = 499;
+    for (TestNode *n = head; n; n = n->left) ASSERT(arena_owns(&arena, n) && n->value == expected--);
+    ASSERT(expected == -1);
+
+    uint8_t *moved = arena_relocate_ptr(&map, aligned);
+    ASSERT(((arena_ptr_t)moved & (ARENA_ALIGN_SIMD_AVX512 - 1)) == 0);
+    ASSERT(moved[0] == 0x5A && moved[99] == 0x5A);
+    ASSERT(arena_relocate_ptr(&map, &map) == NULL);
+
+    // still chunky, keeps growing after flatten
+    ASSERT(arena_alloc_raw(&arena, ARENA_CAPACITY_16KB, ARENA_ALIGN_8B) != NULL);
+    ASSERT(arena.chunk_count == 2);
+
+    arena_reloc_map_destroy(&map);
+    arena_destroy(&arena);
+    return true;
+}
+
+TEST_CREATE(test_arena_freeze)
+{
+    Arena arena = arena_create_ex(arena_config_create(
+        ARENA_CAPACITY_64KB,
+        ARENA_CAPACITY_1MB,
+        ARENA_GROWTH_CONTRACT_CHUNKY,
+        ARENA_GROWTH_FACTOR_CHUNKY_64KB,
+        ARENA_FLAG_NONE
+    ));
+    ASSERT(arena.alloc_type == ARENA_ALLOC_TYPE_BIG);
+
+    // lookup table spread over a few chunks
+    uint32_t *tables[4];
+    for (int t = 0; t < 4; ++t) {
+        tables[t] = arena_alloc_array(&arena, 10000, uint32_t);
+        ASSERT(tables[t] != NULL);
+        for (uint32_t i = 0; i < 10000; ++i) tables[t][i] = i * (t + 1);
+    }
+    ASSERT(arena.chunk_count > 1);
+
+    ASSERT(arena_freeze(&arena, true));
+    ASSERT(arena_alloc_raw(&arena, 16, ARENA_ALIGN_8B) == NULL);
+    ASSERT(arena.error == ARENA_ERROR_FROZEN);
+    ASSERT(!arena_reset(&arena));
+    ASSERT(tables[3][9999] == 9999 * 4);
+
+    // workers read shared pages, stray write is caught
+    pid_t reader = fork();
+    ASSERT(reader >= 0);
+    if (reader == 0) {
+        for (int t = 0; t < 4; ++t) {
+            for (uint32_t i = 0; i < 10000; ++i) if (tables[t][i] != i * (t + 1)) _exit(1);
+        }
+        _exit(0);
+    }
+    pid_t writer = fork();
+    ASSERT(writer >= 0);
+    if (writer == 0) {
+        signal(SIGSEGV, SIG_DFL);
+        *(volatile uint32_t*)&tables[1][5] = 42;
+        _exit(0);
+    }
+
+    int status = 0;
+    ASSERT(waitpid(reader, &status, 0) == reader && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    ASSERT(waitpid(writer, &status, 0) == writer && WIFSIGNALED(status) && WTERMSIG(status) == SIGSEGV);
+
+    ASSERT(arena_thaw(&arena));
+    tables[1][5] = 42;
+    ASSERT(tables[1][5] == 42 && tables[1][6] == 12);
+    ASSERT(arena_alloc_raw(&arena, 16, ARENA_ALIGN_8B) != NULL);
+    arena_destroy(&arena);
+
+    Arena small = arena_create(ARENA_CAPACITY_1KB);
+    ASSERT(!arena_freeze(&small, false));
+    ASSERT(small.error == ARENA_ERROR_UNSUPPORTED);
+    arena_destroy(&small);
+
+    return true;
+}
+
+TEST_CREATE(test_arena_freeze_guards)
+{
+    ArenaConfig config = arena_config_create(
+        ARENA_CAPACITY_16KB,
+        ARENA_CAPACITY_1MB,
+        ARENA_GROWTH_CONTRACT_CHUNKY,
+        ARENA_GROWTH_FACTOR_CHUNKY_16KB,
+        ARENA_FLAG_NONE
+    );
+
+    // file arena with cached chunks: header writes and trim must not touch protected chunk headers
+    Arena file = arena_create_file(NULL, config);
+    ASSERT(file.head_chunk != NULL);
+    ArenaMark mark = arena_mark(&file);
+    for (int i = 0; i < 8; ++i) ASSERT(arena_alloc_raw(&file, 8000, ARENA_ALIGN_8B) != NULL);
+    ASSERT(file.chunk_count > 2);
+    ASSERT(arena_restore(&file, mark, false) && file.free_chunks != NULL);
+    ASSERT(arena_alloc_raw(&file, 64, ARENA_ALIGN_8B) != NULL);
+
+    Arena trial = arena_fork(&file);
+    ASSERT(trial.head_chunk != NULL && !(trial.flags & ARENA_FLAG_FROZEN));
+    ASSERT(arena_alloc_raw(&trial, 64, ARENA_ALIGN_8B) != NULL);
+
+    ASSERT(arena_freeze(&file, false));
+    ASSERT(arena_sync(&file));
+    ASSERT(!arena_fork_commit(&file, &trial) && file.error == ARENA_ERROR_FROZEN);
+    Arena refused = arena_fork(&file);
+    ASSERT(refused.head_chunk == NULL && refused.error == ARENA_ERROR_FROZEN);
+    arena_trim(&file);
+    ASSERT(file.free_chunks == NULL && (file.flags & ARENA_FLAG_FROZEN));
+
+    ASSERT(arena_thaw(&file));
+    ASSERT(arena_fork_commit(&file, &trial));
+    ASSERT(arena_used_bytes(&file) == 128);
+    ASSERT(arena_freeze(&file, false));
+    arena_destroy(&file);
+
+    // flatten would hand out a writable chunk under the frozen flag
+    Arena chunky = arena_create_ex(config);
+    for (int i = 0; i < 8; ++i) ASSERT(arena_alloc_raw(&chunky, 8000, ARENA_ALIGN_8B) != NULL);
+    uint32_t chunk_count = chunky.chunk_count;
+    ASSERT(arena_freeze(&chunky, false));
+    ASSERT(!arena_flatten(&chunky, NULL, false) && chunky.error == ARENA_ERROR_FROZEN);
+    ASSERT(chunky.chunk_count == chunk_count && (chunky.flags & ARENA_FLAG_FROZEN));
+    ASSERT(arena_thaw(&chunky) && arena_flatten(&chunky, NULL, false));
+    arena_destroy(&chunky);
+
+    // compaction would swap the storage for a writable one
+    ArenaTable table = arena_table_create(config);
+    ArenaRef refs[4];
+    for (int i = 0; i < 4; ++i) ASSERT((refs[i] = arena_table_alloc(&table, 256, ARENA_ALIGN_8B)) != ARENA_REF_NULL);
+    ASSERT(arena_table_free(&table, refs[0]));
+    ASSERT(arena_freeze(&table.arena, false));
+    ArenaChunk *storage = table.arena.head_chunk;
+    ASSERT(!arena_compact(&table) && table.arena.error == ARENA_ERROR_FROZEN);
+    ASSERT(table.arena.head_chunk == storage && (table.arena.flags & ARENA_FLAG_FROZEN));
+    ASSERT(arena_table_get(&table, refs[3]) != NULL);
+    ASSERT(arena_thaw(&table.arena) && arena_compact(&table));
+    arena_table_destroy(&table);
+
+    return true;
+}
+
+TEST_CREATE(test_arena_iovec)
+{
+    Arena arena = arena_create_ex(arena_config_create(
+        ARENA_CAPACITY_1KB,
+        ARENA_CAPACITY_1MB,
+        ARENA_GROWTH_CONTRACT_CHUNKY,
+        ARENA_GROWTH_FACTOR_CHUNKY_1KB,
+        ARENA_FLAG_NONE
+    ));
+
+    // response assembled in pieces, shipped without gluing
+    size_t expected_size = 0;
+    for (int i = 0; i < 300; ++i) {
+        char *line = arena_alloc_array(&arena, 16, char);
+        ASSERT(line != NULL);
+        arena_memset(line, 'a' + i % 26, 16);
+        expected_size += 16;
+    }
+    size_t count = arena_to_iovec(&arena, NULL, 0);
+    ASSERT(count == arena.chunk_count && count > 2);
+
+    struct iovec iov[16];
+    ASSERT(count <= 16 && arena_to_iovec(&arena, iov, 16) == count);
+
+    int fds[2];
+    ASSERT(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+    ASSERT(writev(fds[0], iov, (int)count) == (ssize_t)expected_size);
+    shutdown(fds[0], SHUT_WR);
+
+    // receiver reads straight into its own chunks
+    Arena received = arena_create_ex(arena_config_create(
+        ARENA_CAPACITY_1KB,
+        ARENA_CAPACITY_1MB,
+        ARENA_GROWTH_CONTRACT_CHUNKY,
+        ARENA_GROWTH_FACTOR_CHUNKY_2KB,
+        ARENA_FLAG_NONE
+    ));
+    ArenaMark start = arena_mark(&received);
+    ASSERT(arena_readv_into(&received, fds[1], ARENA_CAPACITY_1MB) == expected_size);
+    ASSERT(received.chunk_count > 1);
+    ASSERT(start.chunk == received.head_chunk && start.offset == 0);
+    close(fds[0]);
+    close(fds[1]);
+
+    struct iovec got[16];
+    size_t got_count = arena_to_iovec(&received, got, 16);
+    size_t at = 0;
+    for (size_t i = 0; i < got_count; ++i) {
+        const char *p = got[i].iov_base;
+        for (size_t b = 0; b < got[i].iov_len; ++b, ++at) ASSERT(p[b] == 'a' + (int)(at / 16) % 26);
+    }
+    ASSERT(at == expected_size);
+
+    // fixed arena reads what fits
+    Arena fixed = arena_create(ARENA_CAPACITY_1KB);
+    ASSERT(pipe(fds) == 0);
+    ASSERT(writev(fds[1], iov, (int)count) == (ssize_t)expected_size);
+    close(fds[1]);
+    ASSERT(arena_readv_into(&fixed, fds[0], ARENA_CAPACITY_1MB) == fixed.head_chunk->capacity);
+    ASSERT(fixed.error == ARENA_ERROR_GROWTH_FORBIDDEN);
+    close(fds[0]);
+
+    // small reads fill the tail before growing, the writer trickles data in so reads come back short
+    Arena stream = arena_create_ex(arena_config_create(
+        ARENA_CAPACITY_4KB,
+        ARENA_CAPACITY_1MB,
+        ARENA_GROWTH_CONTRACT_CHUNKY,
+        ARENA_GROWTH_FACTOR_CHUNKY_4KB,
+        ARENA_FLAG_NONE
+    ));
+    ASSERT(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+    pid_t writer = fork();
+    ASSERT(writer >= 0);
+    if (writer == 0) {
+        close(fds[1]);
+        char packet[100];
+        for (int i = 0; i < 400; ++i) {
+            memset(packet, 'a' + i % 26, sizeof(packet));
+            if (write(fds[0], packet, sizeof(packet)) != (ssize_t)sizeof(packet)) _exit(1);
+            if (i % 8 == 0) usleep(100);
+        }
+        _exit(0);
+    }
+    close(fds[0]);
+    ASSERT(arena_readv_into(&stream, fds[1], 400000) == 40000);
+    ASSERT(stream.error == ARENA_ERROR_NONE);
+    ASSERT(stream.reserved < 40000 + ARENA_CAPACITY_8KB);
+    close(fds[1]);
+    int status = 0;
+    ASSERT(waitpid(writer, &status, 0) == writer && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    arena_destroy(&stream);
+
+    arena_destroy(&fixed);
+    arena_destroy(&received);
+    arena_destroy(&arena);
+    return true;
+}
+
+TEST_CREATE(test_arena_load_file)
+{
+    const char *path = "/tmp/arena_test_load.bin";
+    const size_t file_size = 3 * 4096 + 123; // last page partially used
+    FILE *file = fopen(path, "wb");
+    ASSERT(file != NULL);
+    for (size_t i = 0; i < file_size; ++i) fputc('A' + (int)(i % 23), file);
+    fclose(file);
+
+    Arena arena = arena_create_ex(arena_config_create(
+        ARENA_CAPACITY_4KB,
+        ARENA_CAPACITY_1MB,
+        ARENA_GROWTH_CONTRACT_CHUNKY,
+        ARENA_GROWTH_FACTOR_CHUNKY_16KB,
+        ARENA_FLAG_NONE
+    ));
+
+    // small file is copied, page aligned, writable and zero padded
+    ArenaSpan copy = arena_load_file(&arena, path, ARENA_LOAD_DEFAULT);
+    ASSERT(copy.data != NULL && copy.size == file_size && !copy.mapped);
+    ASSERT(((arena_ptr_t)copy.data & 4095) == 0);
+    ASSERT(arena_owns(&arena, copy.data));
+    for (size_t i = 0; i < file_size; ++i) ASSERT(copy.data[i] == 'A' + (int)(i % 23));
+    for (size_t i = 0; i < ARENA_LOAD_PADDING; ++i) ASSERT(copy.data[file_size + i] == 0);
+    copy.data[0] = 'z';
+
+    // forced mapping: read only, outside of the chain, survives reset
+    arena_size_t used = arena_used_bytes(&arena);
+    ArenaSpan mapped = arena_load_file(&arena, path, ARENA_LOAD_MMAP);
+    ASSERT(mapped.data != NULL && mapped.size == file_size && mapped.mapped);
+    ASSERT(((arena_ptr_t)mapped.data & 4095) == 0);
+    ASSERT(!arena_owns(&arena, mapped.data));
+    ASSERT(arena_used_bytes(&arena) == used);
+    for (size_t i = 0; i < ARENA_LOAD_PADDING; ++i) ASSERT(mapped.data[file_size + i] == 0);
+    ASSERT(memcmp(mapped.data + 1, copy.data + 1, file_size - 1) == 0);
+
+    // O_DIRECT copy (or plain read where filesystem refuses it)
+    ArenaSpan direct = arena_load_file(&arena, path, ARENA_LOAD_DIRECT);
+    ASSERT(direct.data != NULL && direct.size == file_size && !direct.mapped);
+    ASSERT(((arena_ptr_t)direct.data & (ARENA_LOAD_DIRECT_ALIGN - 1)) == 0);
+    ASSERT(memcmp(direct.data, mapped.data, file_size + ARENA_LOAD_PADDING) == 0);
+
+    arena_reset(&arena);
+    ASSERT(mapped.data[0] == 'A' && mapped.data[file_size - 1] == 'A' + (int)((file_size - 1) % 23));
+
+    // flatten keeps the mapping owned and copies page aligned
+    ASSERT(arena_alloc_raw(&arena, 64, 8) != NULL);
+    direct = arena_load_file(&arena, path, ARENA_LOAD_DIRECT);
+    ASSERT(direct.data != NULL && arena.chunk_count > 1);
+    ArenaRelocMap map = {0};
+    ASSERT(arena_flatten(&arena, &map, false));
+    ASSERT(arena.owned_count == 2);
+    ASSERT(mapped.data[1] == 'B');
+    uint8_t *moved = arena_relocate_ptr(&map, direct.data);
+    ASSERT(((arena_ptr_t)moved & (ARENA_LOAD_DIRECT_ALIGN - 1)) == 0);
+    ASSERT(memcmp(moved, mapped.data, file_size + ARENA_LOAD_PADDING) == 0);
+    arena_reloc_map_destroy(&map);
+
+    // fixed arenas can only copy
+    Arena fixed = arena_create(ARENA_CAPACITY_64KB);
+    ArenaSpan refused = arena_load_file(&fixed, path, ARENA_LOAD_MMAP);
+    ASSERT(refused.data == NULL && fixed.error == ARENA_ERROR_UNSUPPORTED);
+    ArenaSpan fixed_copy = arena_load_file(&fixed, path, ARENA_LOAD_DEFAULT);
+    ASSERT(fixed_copy.data != NULL && !fixed_copy.mapped && fixed_copy.data[file_size] == 0);
+
+    ArenaSpan missing = arena_load_file(&fixed, "/tmp/arena_test_load_missing.bin", ARENA_LOAD_DEFAULT);
+    ASSERT(missing.data == NULL && fixed.error == ARENA_ERROR_IO);
+
+    arena_destroy(&fixed);
+    arena_destroy(&arena);
+    unlink(path);
+    return true;
+}
+
+TEST_CREATE(test_arena_uring)
+{
+    ArenaUring ring = arena_uring_create(8);
+    if (ring.error == ARENA_ERROR_UNSUPPORTED) return true; // io_uring not available here
+    ASSERT(ring.error == ARENA_ERROR_NONE && ring.sq_entries == 8);
+
+    Arena arena = arena_create_ex(arena_config_create(
+        ARENA_CAPACITY_64KB,
+        ARENA_CAPACITY_1MB,
+        ARENA_GROWTH_CONTRACT_CHUNKY,
+        ARENA_GROWTH_FACTOR_CHUNKY_64KB,
+        ARENA_FLAG_NONE
+    ));
+    ASSERT(arena.alloc_type == ARENA_ALLOC_TYPE_BIG);
+    ASSERT(arena_uring_register(&ring, &arena));
+    ASSERT(ring.buffer_count == 1);
+
+    Arena records = arena_create(ARENA_CAPACITY_4KB);
+    size_t count = 0;
+    ASSERT(arena_uring_reap(&ring, &records, &count) == NULL && count == 0);
+
+    const char *path = "/tmp/arena_test_uring.bin";
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0600);
+    ASSERT(fd >= 0);
+
+    char *out = arena_alloc_array(&arena, 4096, char);
+    for (int i = 0; i < 4096; ++i) out[i] = 'a' + i % 26;
+    ASSERT(arena_uring_write(&ring, fd, out, 4096, 0, 1));
+    ASSERT(arena_uring_submit(&ring, 1) == 1);
+    ArenaUringCompletion *done = arena_uring_reap(&ring, &records, &count);
+    ASSERT(count == 1 && done[0].user_data == 1 && done[0].result == 4096);
+
+    // small reads into the registered chunk plus one into plain heap memory
+    char *in[4];
+    for (int i = 0; i < 4; ++i) {
+        in[i] = arena_alloc_array(&arena, 1024, char);
+        ASSERT(arena_uring_read(&ring, fd, in[i], 1024, (uint64_t)i * 1024, 10 + i));
+    }
+    char *heap = malloc(100);
+    ASSERT(arena_uring_read(&ring, fd, heap, 100, 26, 99));
+    ASSERT(arena_uring_submit(&ring, 5) == 5);
+
+    done = arena_uring_reap(&ring, &records, &count);
+    ASSERT(count == 5);
+    for (size_t i = 0; i < count; ++i) {
+        if (done[i].user_data == 99) ASSERT(done[i].result == 100);
+        else ASSERT(done[i].user_data >= 10 && done[i].user_data < 14 && done[i].result == 1024);
+    }
+    ASSERT(memcmp(in[0], out, 1024) == 0 && memcmp(in[3], out + 3072, 1024) == 0);
+    ASSERT(memcmp(heap, out, 100) == 0);
+
+    // chunk added after registration falls back to plain read
+    char *late = arena_alloc_array(&arena, 60000, char);
+    ASSERT(late != NULL && arena.chunk_count == 2);
+    ASSERT(arena_uring_read(&ring, fd, late, 4096, 0, 7));
+    ASSERT(arena_uring_submit(&ring, 1) == 1);
+    done = arena_uring_reap(&ring, &records, &count);
+    ASSERT(count == 1 && done[0].result == 4096 && memcmp(late, out, 4096) == 0);
+    ASSERT(arena_uring_register(&ring, &arena) && ring.buffer_count == 2);
+
+    // submission queue holds `entries` operations
+    for (int i = 0; i < 8; ++i) ASSERT(arena_uring_read(&ring, fd, in[0], 16, 0, i));
+    ASSERT(!arena_uring_read(&ring, fd, in[0], 16, 0, 8) && ring.error == ARENA_ERROR_RING_FULL);
+    ASSERT(arena_uring_submit(&ring, 8) == 8);
+    done = arena_uring_reap(&ring, &records, &count);
+    ASSERT(count == 8);
+
+    // trimmed chunk is unmapped, nothing uses the stale registration until it is renewed
+    #define LAST_OPCODE() (((_ArenaUringSqe*)ring.sqes)[(*ring.sq_tail - 1) & ring.sq_mask].opcode)
+    arena_reset(&arena);
+    arena_trim(&arena);
+    ASSERT(arena_uring_read(&ring, fd, arena.head_chunk->base, 16, 0, 20));
+    ASSERT(LAST_OPCODE() == _ARENA_URING_OP_READ);
+    ASSERT(arena_uring_submit(&ring, 1) == 1);
+    done = arena_uring_reap(&ring, &records, &count);
+    ASSERT(count == 1 && done[0].result == 16);
+
+    ASSERT(arena_uring_register(&ring, &arena) && ring.buffer_count == 1);
+    ASSERT(arena_uring_read(&ring, fd, arena.head_chunk->base, 16, 0, 21));
+    ASSERT(LAST_OPCODE() == _ARENA_URING_OP_READ_FIXED);
+    #undef LAST_OPCODE
+    ASSERT(arena_uring_submit(&ring, 1) == 1);
+    done = arena_uring_reap(&ring, &records, &count);
+    ASSERT(count == 1 && done[0].result == 16);
+
+    free(heap);
+    close(fd);
+    unlink(path);
+    arena_uring_destroy(&ring);
+    arena_destroy(&records);
+    arena_destroy(&arena);
+    return true;
+}
+
+TEST_CREATE(test_arena_spill)
+{
+    Arena arena = arena_create_ex(arena_config_create(
+        ARENA_CAPACITY_64KB,
+        ARENA_CAPACITY_8MB,
+        ARENA_GROWTH_CONTRACT_CHUNKY,
+        ARENA_GROWTH_FACTOR_CHUNKY_64KB,
+        ARENA_FLAG_NONE
+    ));
+    ASSERT(arena.alloc_type == ARENA_ALLOC_TYPE_BIG);
+
+    uint32_t *blocks[32];
+    blocks[0] = arena_alloc_array(&arena, 15000, uint32_t);
+    for (uint32_t i = 0; i < 15000; ++i) blocks[0][i] = i;
+
+    // budget below what the arena holds already spills right away
+    ASSERT(arena_spill_enable(&arena, ARENA_CAPACITY_64KB, NULL));
+    ASSERT(arena.head_chunk->backing == ARENA_CHUNK_BACKING_DEFAULT); // only chunk, still filled
+
+    for (int b = 1; b < 32; ++b) {
+        blocks[b] = arena_alloc_array(&arena, 15000, uint32_t);
+        ASSERT(blocks[b] != NULL);
+        for (uint32_t i = 0; i < 15000; ++i) blocks[b][i] = i * (uint32_t)b;
+    }
+    ASSERT(arena.chunk_count == 32);
+
+    arena_size_t resident = 0;
+    for (ArenaChunk *chunk = arena.head_chunk; chunk; chunk = chunk->next) {
+        if (chunk->backing == ARENA_CHUNK_BACKING_DEFAULT) resident += chunk->capacity;
+    }
+    ASSERT(resident <= ARENA_CAPACITY_64KB + 4096);
+    ASSERT(arena.head_chunk->backing == ARENA_CHUNK_BACKING_SPILLED);
+    ASSERT(arena.last_chunk->backing == ARENA_CHUNK_BACKING_DEFAULT);
+
+    // spilled memory is the same memory
+    ASSERT(blocks[0][14999] == 14999);
+    for (int b = 1; b < 32; ++b) ASSERT(blocks[b][7] == 7u * (uint32_t)b && blocks[b][14999] == 14999u * (uint32_t)b);
+    blocks[3][0] = 12345;
+    ASSERT(blocks[3][0] == 12345);
+    ASSERT(arena_owns(&arena, blocks[3]));
+
+    // reuse after reset
+    ASSERT(arena_reset(&arena));
+    uint32_t *again = arena_alloc_array(&arena, 100, uint32_t);
+    ASSERT(again != NULL);
+    again[99] = 99;
+
+    Arena fixed = arena_create(ARENA_CAPACITY_64KB);
+    ASSERT(!arena_spill_enable(&fixed, ARENA_CAPACITY_4KB, NULL) && fixed.error == ARENA_ERROR_UNSUPPORTED);
+    arena_destroy(&fixed);
+
+    arena_destroy(&arena);
+    ASSERT(arena.spill_budget == 0);
+    return true;
+}
+
+typedef struct TestBufPoint { float x, y; } TestBufPoint;
+typedef struct TestBufMessage {
+    uint64_t       id;
+    ArenaBufOffset name;    // string
+    ArenaBufOffset points;  // vector of TestBufPoint
+    ArenaBufOffset tags;    // vector of string offsets
+    uint32_t       flags;
+} TestBufMessage;
+
+TEST_CREATE(test_arena_buf)
+{
+    ArenaBufBuilder builder = arena_buf_builder_create(ARENA_CAPACITY_512B);
+    ASSERT(builder.error == ARENA_ERROR_NONE);
+
+    // children first, parent links them by offset
+    ArenaBufOffset name = arena_buf_add_string(&builder, "sensor-7", 8);
+    TestBufPoint points[100];
+    for (int i = 0; i < 100; ++i) points[i] = (TestBufPoint){ (float)i, (float)-i };
+    ArenaBufOffset point_vec = arena_buf_add_vector(&builder, points, 100, sizeof(TestBufPoint), alignof(TestBufPoint));
+    ArenaBufOffset tag_strs[3] = {
+        arena_buf_add_string(&builder, "a", 1),
+        arena_buf_add_string(&builder, "bb", 2),
+        arena_buf_add_string(&builder, "", 0),
+    };
+    ArenaBufOffset tags = arena_buf_add_vector(&builder, tag_strs, 3, sizeof(ArenaBufOffset), alignof(ArenaBufOffset));
+    TestBufMessage message = { .id = 0x1122334455667788ull, .name = name, .points = point_vec, .tags = tags, .flags = 5 };
+    ArenaBufOffset root = arena_buf_add(&builder, TestBufMessage, &message);
+    ASSERT(name && point_vec && tags && root);
+    ASSERT(root % alignof(TestBufMessage) == 0);
+    ASSERT(builder.arena.last_chunk->capacity > ARENA_CAPACITY_512B); // grew by realloc
+
+    // patch in place before finishing
+    TestBufMessage *patch = arena_buf_at(&builder, root);
+    patch->flags |= 0x100;
+
+    ArenaSpan buffer = arena_buf_finish(&builder, root);
+    ASSERT(buffer.data != NULL && buffer.size == builder.arena.last_chunk->offset);
+
+    // reader works on the bytes as they come, here through a file mapping
+    const char *path = "/tmp/arena_test_buf.bin";
+    FILE *file = fopen(path, "wb");
+    ASSERT(file != NULL && fwrite(buffer.data, 1, buffer.size, file) == buffer.size);
+    fclose(file);
+
+    Arena io = arena_create_ex(arena_config_create(
+        ARENA_CAPACITY_4KB,
+        ARENA_CAPACITY_1MB,
+        ARENA_GROWTH_CONTRACT_CHUNKY,
+        ARENA_GROWTH_FACTOR_CHUNKY_16KB,
+        ARENA_FLAG_NONE
+    ));
+    ArenaSpan loaded = arena_load_file(&io, path, ARENA_LOAD_MMAP);
+    ASSERT(loaded.mapped);
+
+    ArenaBufView view = arena_buf_view(loaded.data, loaded.size);
+    ASSERT(view.error == ARENA_ERROR_NONE);
+    const TestBufMessage *read = arena_buf_get(&view, view.root, TestBufMessage);
+    ASSERT(read != NULL && read->id == 0x1122334455667788ull && read->flags == 0x105);
+
+    uint32_t length = 0;
+    const char *read_name = arena_buf_string(&view, read->name, &length);
+    ASSERT(read_name != NULL && length == 8 && strcmp(read_name, "sensor-7") == 0);
+
+    uint32_t count = 0;
+    const TestBufPoint *read_points = arena_buf_get_array(&view, read->points, TestBufPoint, &count);
+    ASSERT(read_points != NULL && count == 100 && read_points[99].x == 99.0f && read_points[99].y == -99.0f);
+
+    const ArenaBufOffset *read_tags = arena_buf_get_array(&view, read->tags, ArenaBufOffset, &count);
+    ASSERT(read_tags != NULL && count == 3);
+    ASSERT(strcmp(arena_buf_string(&view, read_tags[1], NULL), "bb") == 0);
+    ASSERT(arena_buf_string(&view, read_tags[2], &length) != NULL && length == 0);
+
+    // corrupted offsets and sizes are caught by the accessors
+    ASSERT(arena_buf_get(&view, view.size - 4, TestBufMessage) == NULL);
+    ASSERT(arena_buf_get(&view, 0, TestBufMessage) == NULL);
+    ASSERT(arena_buf_get(&view, read->name + 1, TestBufMessage) == NULL); // misaligned
+    ASSERT(arena_buf_get_array(&view, view.size - 4, TestBufPoint, &count) == NULL && count == 0);
+    ASSERT(arena_buf_view(loaded.data, sizeof(ArenaBufHeader) - 1).error == ARENA_ERROR_BUFFER_INVALID);
+    ASSERT(arena_buf_view(loaded.data, view.size - 1).error == ARENA_ERROR_BUFFER_INVALID);
+
+    uint8_t *copy = arena_alloc_array(&io, buffer.size, uint8_t);
+    memcpy(copy, buffer.data, buffer.size);
+    uint32_t bad_count = 0xFFFFFFF0u;
+    memcpy(copy + point_vec, &bad_count, sizeof(bad_count));
+    ArenaBufView bad = arena_buf_view(copy, buffer.size);
+    ASSERT(bad.error == ARENA_ERROR_NONE);
+    ASSERT(arena_buf_get_array(&bad, point_vec, TestBufPoint, &count) == NULL);
+    copy[0] ^= 0xFF;
+    ASSERT(arena_buf_view(copy, buffer.size).error == ARENA_ERROR_BUFFER_INVALID);
+
+    // builder is reusable for the next message
+    ASSERT(arena_buf_builder_reset(&builder));
+    ArenaBufOffset small = arena_buf_add_string(&builder, "x", 1);
+    ASSERT(small == sizeof(ArenaBufHeader));
+    ArenaSpan next = arena_buf_finish(&builder, small);
+    ArenaBufView next_view = arena_buf_view(next.data, next.size);
+    ASSERT(strcmp(arena_buf_string(&next_view, next_view.root, NULL), "x") == 0);
+
+    arena_destroy(&io);
+    arena_buf_builder_destroy(&builder);
+    unlink(path);
+    return true;
+}
+
+typedef struct TestDeferLog {
+    int order[64];
+    int count;
+} TestDeferLog;
+
+typedef struct TestDeferItem {
+    TestDeferLog *log;
+    int          id;
+} TestDeferItem;
+
+static void test_defer_record(void *ctx)
+{
+    TestDeferItem *item = (TestDeferItem*)ctx;
+    item->log->order[item->log->count++] = item->id;
+}
+
+static TestDeferItem *test_defer_push(Arena *arena, TestDeferLog *log, int id)
+{
+    TestDeferItem *item = arena_alloc_struct(arena, TestDeferItem);
+    if (!item) return NULL;
+    *item = (TestDeferItem){ .log = log, .id = id };
+    return arena_defer(arena, test_defer_record, item) ? item : NULL;
+}
+
+TEST_CREATE(test_arena_internal_flags)
+{
+    // library owned flags from user config are dropped, not trusted
+    Arena arena = arena_create_ex(arena_config_create(
+        ARENA_CAPACITY_4KB,
+        ARENA_CAPACITY_4KB,
+        ARENA_GROWTH_CONTRACT_FIXED,
+        ARENA_GROWTH_FACTOR_NONE,
+        (ArenaFlag)(ARENA_FLAG_SHARED | ARENA_FLAG_FROZEN | ARENA_FLAG_DEBUG)
+    ));
+    ASSERT(arena.head_chunk != NULL);
+    ASSERT(arena.flags == ARENA_FLAG_DEBUG);
+    ASSERT(arena_alloc_raw(&arena, 64, ARENA_ALIGN_8B) != NULL);
+    ASSERT(arena_reset(&arena) && arena_used_bytes(&arena) == 0);
+    arena_destroy(&arena);
+
+    // nor restored from files: snapshot of a shared arena maps back as a private one
+    const char *path = "/tmp/arena_test_internal_flags.bin";
+    Arena shared = arena_create_shared(NULL, arena_config_create(
+        ARENA_CAPACITY_16KB, ARENA_CAPACITY_16KB, ARENA_GROWTH_CONTRACT_FIXED, ARENA_GROWTH_FACTOR_NONE, ARENA_FLAG_NONE
+    ));
+    ASSERT(shared.head_chunk != NULL && (shared.flags & ARENA_FLAG_SHARED));
+    ASSERT(arena_alloc_raw(&shared, 64, ARENA_ALIGN_8B) != NULL);
+    ASSERT(arena_snapshot_write(&shared, path) == ARENA_ERROR_NONE);
+    arena_destroy(&shared);
+
+    Arena mapped = arena_snapshot_map(path);
+    ASSERT(mapped.head_chunk != NULL && !(mapped.flags & ARENA_FLAG_SHARED));
+    ASSERT(arena_alloc_raw(&mapped, 64, ARENA_ALIGN_8B) != NULL);
+    ASSERT(arena_used_bytes(&mapped) >= 128);
+    arena_destroy(&mapped);
+
+    // and a file arena closed while frozen reopens writable
+    Arena file = arena_create_file(path, arena_config_create(
+        ARENA_CAPACITY_16KB, ARENA_CAPACITY_1MB, ARENA_GROWTH_CONTRACT_CHUNKY, ARENA_GROWTH_FACTOR_CHUNKY_16KB, ARENA_FLAG_NONE
+    ));
+    ASSERT(file.head_chunk != NULL && arena_freeze(&file, false));
+    arena_destroy(&file);
+    file = arena_open_file(path);
+    ASSERT(file.head_chunk != NULL && !(file.flags & ARENA_FLAG_FROZEN));
+    ASSERT(arena_alloc_raw(&file, 64, ARENA_ALIGN_8B) != NULL);
+    arena_destroy(&file);
+    unlink(path);
+
+    return true;
+}
+
+TEST_CREATE(test_arena_defer)
+{
+    TestDeferLog log = {0};
+
+    // reset runs newest first, once
+    Arena arena = arena_create(ARENA_CAPACITY_4KB);
+    for (int i = 0; i < 3; ++i) ASSERT(test_defer_push(&arena, &log, i));
+    ASSERT(arena_reset(&arena));
+    ASSERT(log.count == 3 && log.order[0] == 2 && log.order[1] == 1 && log.order[2] == 0);
+    ASSERT(arena_reset(&arena) && log.count == 3);
+
+    // restore only unwinds what came after the mark, destroy the rest
+    log.count = 0;
+    ASSERT(test_defer_push(&arena, &log, 10));
+    ArenaMark mark = arena_mark(&arena);
+    ASSERT(test_defer_push(&arena, &log, 11));
+    ASSERT(test_defer_push(&arena, &log, 12));
+    ASSERT(arena_restore(&arena, mark, false));
+    ASSERT(log.count == 2 && log.order[0] == 12 && log.order[1] == 11);
+    arena_destroy(&arena);
+    ASSERT(log.count == 3 && log.order[2] == 10);
+
+    // records follow realloc moves (ctx itself must live outside a moving arena)
+    log.count = 0;
+    TestDeferItem items[40];
+    Arena moving = arena_create_ex(arena_config_create(
+        ARENA_CAPACITY_512B,
+        ARENA_CAPACITY_1MB,
+        ARENA_GROWTH_CONTRACT_REALLOC,
+        ARENA_GROWTH_FACTOR_REALLOC_2X,
+        ARENA_FLAG_NONE
+    ));
+    for (int i = 0; i < 40; ++i) {
+        items[i] = (TestDeferItem){ .log = &log, .id = i };
+        ASSERT(arena_defer(&moving, test_defer_record, &items[i]));
+        ASSERT(arena_alloc_raw(&moving, 200, ARENA_ALIGN_8B) != NULL);
+    }
+    ASSERT(moving.last_chunk->capacity > ARENA_CAPACITY_512B);
+    arena_destroy(&moving);
+    ASSERT(log.count == 40);
+    for (int i = 0; i < 40; ++i) ASSERT(log.order[i] == 39 - i);
+
+    // flatten would move objects (ctx) under pending callbacks, so it refuses
+    log.count = 0;
+    Arena chunky = arena_create_ex(arena_config_create(
+        ARENA_CAPACITY_1KB,
+        ARENA_CAPACITY_1MB,
+        ARENA_GROWTH_CONTRACT_CHUNKY,
+        ARENA_GROWTH_FACTOR_CHUNKY_1KB,
+        ARENA_FLAG_NONE
+    ));
+    for (int i = 0; i < 30; ++i) {
+        ASSERT(test_defer_push(&chunky, &log, i));
+        ASSERT(arena_alloc_raw(&chunky, 400, ARENA_ALIGN_8B) != NULL);
+    }
+    ASSERT(chunky.chunk_count > 5);
+    ASSERT(!arena_flatten(&chunky, NULL, false) && chunky.error == ARENA_ERROR_UNSUPPORTED);
+    ASSERT(chunky.chunk_count > 5 && log.count == 0);
+    arena_destroy(&chunky);
+    ASSERT(log.count == 30);
+    for (int i = 0; i < 30; ++i) ASSERT(log.order[i] == 29 - i);
+
+    // compaction would release the storage and run callbacks of live objects
+    log.count = 0;
+    ArenaTable table = arena_table_create(arena_config_create(
+        ARENA_CAPACITY_4KB,
+        ARENA_CAPACITY_1MB,
+        ARENA_GROWTH_CONTRACT_CHUNKY,
+        ARENA_GROWTH_FACTOR_CHUNKY_4KB,
+        ARENA_FLAG_NONE
+    ));
+    ArenaRef refs[4];
+    for (int i = 0; i < 4; ++i) ASSERT((refs[i] = arena_table_alloc(&table, 64, ARENA_ALIGN_8B)) != ARENA_REF_NULL);
+    ASSERT(test_defer_push(&table.arena, &log, 7));
+    ASSERT(arena_table_free(&table, refs[1]) && arena_table_free(&table, refs[2]));
+    ASSERT(!arena_compact(&table) && table.arena.error == ARENA_ERROR_UNSUPPORTED);
+    ASSERT(log.count == 0 && arena_table_get(&table, refs[3]) != NULL);
+    arena_table_destroy(&table);
+    ASSERT(log.count == 1 && log.order[0] == 7);
+
+    return true;
+}
+
 int main(void)
 {
     randinit();
@@ -352,9 +1997,33 @@ int main(void)
     TEST_RUN(test_arena_overflow);
     TEST_RUN(test_arena_reset);
     TEST_RUN(test_arena_reset_chunky);
+    TEST_RUN(test_arena_reset_chunky_cycles);
     TEST_RUN(test_arena_grow_chunky);
     TEST_RUN(test_arena_memory_resolve);
     TEST_RUN(test_arena_error);
     TEST_RUN(test_arena_stress_no_grow);
+    TEST_RUN(test_arena_ring_wrap);
+    TEST_RUN(test_arena_temp_nested);
+    TEST_RUN(test_arena_handles);
+    TEST_RUN(test_arena_chunk_directory);
+    TEST_RUN(test_arena_table_compact);
+    TEST_RUN(test_arena_evacuate);
+    TEST_RUN(test_arena_generations);
+    TEST_RUN(test_arena_snapshot);
+    TEST_RUN(test_arena_file_backed);
+    TEST_RUN(test_arena_shared);
+    TEST_RUN(test_arena_relptr);
+    TEST_RUN(test_arena_reserve_cptr);
+    TEST_RUN(test_arena_fork);
+    TEST_RUN(test_arena_flatten);
+    TEST_RUN(test_arena_freeze);
+    TEST_RUN(test_arena_freeze_guards);
+    TEST_RUN(test_arena_iovec);
+    TEST_RUN(test_arena_load_file);
+    TEST_RUN(test_arena_uring);
+    TEST_RUN(test_arena_spill);
+    TEST_RUN(test_arena_buf);
+    TEST_RUN(test_arena_internal_flags);
+    TEST_RUN(test_arena_defer);
     return 0;
 }
\ No newline at end of file
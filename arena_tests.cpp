@@ -0,0 +1,351 @@
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <memory_resource>
+#include <stdexcept>
+
+#include "arena.hpp"
+
+#define TEST_CREATE(name) static bool name(void)
+#define TEST_RUN(test)                                             \
+do {                                                               \
+    printf("[TEST] %-32s ... %s\n", #test, test() ? "OK" : "FAIL");\
+} while (0)
+
+#define ASSERT(cond)                                                       \
+do {                                                                      \
+    if (!(cond)) {                                                          \
+        printf("!\tAssertion failed: %s (%s:%d)\n", #cond, __FILE__, __LINE__);\
+        return false;                                                     \
+    }                                                                     \
+} while (0)
+
+TEST_CREATE(test_arena_resource)
+{
+    ArenaResource resource(arena_config_create(
+        ARENA_CAPACITY_4KB,
+        ARENA_CAPACITY_1MB,
+        ARENA_GROWTH_CONTRACT_CHUNKY,
+        ARENA_GROWTH_FACTOR_CHUNKY_4KB,
+        ARENA_FLAG_NONE
+    ));
+    Arena *arena = resource.arena();
+
+    {
+        std::pmr::vector<int> values(&resource);
+        for (int i = 0; i < 10000; ++i) values.push_back(i);
+        ASSERT(arena_owns(arena, values.data()));
+        ASSERT(values[9999] == 9999);
+
+        std::pmr::unordered_map<int, std::pmr::string> names(&resource);
+        for (int i = 0; i < 500; ++i) names.emplace(i, std::pmr::string(64, (char)('a' + i % 26)));
+        ASSERT(names.size() == 500 && names.at(27)[0] == 'b');
+        ASSERT(arena_owns(arena, names.at(499).data()));
+    }
+    ASSERT(arena->chunk_count > 1);
+
+    // last block goes back in place
+    size_t top = arena->last_chunk->offset;
+    void *p = resource.allocate(128, 16);
+    ASSERT(arena->last_chunk->offset >= top + 128);
+    resource.deallocate(p, 128, 16);
+    ASSERT(arena->last_chunk->offset == (arena_size_t)((arena_ptr_t)p - (arena_ptr_t)arena->last_chunk->base));
+    void *q = resource.allocate(64, 8);
+    void *r = resource.allocate(64, 8);
+    resource.deallocate(q, 64, 8); // not on top, stays
+    ASSERT((arena_ptr_t)arena->last_chunk->base + arena->last_chunk->offset == (arena_ptr_t)r + 64);
+
+    ASSERT(resource.is_equal(resource));
+    std::pmr::monotonic_buffer_resource other;
+    ASSERT(!resource.is_equal(other));
+
+    ASSERT(resource.reset() && arena_used_bytes(arena) == 0);
+
+    Arena moving = arena_create_ex(arena_config_create(
+        ARENA_CAPACITY_1KB, ARENA_CAPACITY_1MB, ARENA_GROWTH_CONTRACT_REALLOC, ARENA_GROWTH_FACTOR_REALLOC_2X, ARENA_FLAG_NONE
+    ));
+    bool rejected = false;
+    try {
+        ArenaResource bad(&moving);
+    } catch (const std::invalid_argument&) {
+        rejected = true;
+    }
+    ASSERT(rejected);
+    arena_destroy(&moving);
+
+    return true;
+}
+
+TEST_CREATE(test_arena_allocator)
+{
+    Arena arena = arena_create_ex(arena_config_create(
+        ARENA_CAPACITY_4KB,
+        ARENA_CAPACITY_1MB,
+        ARENA_GROWTH_CONTRACT_CHUNKY,
+        ARENA_GROWTH_FACTOR_CHUNKY_4KB,
+        ARENA_FLAG_NONE
+    ));
+
+    {
+        ArenaAllocator<double> alloc(&arena);
+        std::vector<double, ArenaAllocator<double>> values(alloc);
+        for (int i = 0; i < 1000; ++i) values.push_back(i * 0.5);
+        ASSERT(arena_owns(&arena, values.data()) && values[999] == 499.5);
+
+        // rebinding keeps the arena
+        using Map = std::unordered_map<int, int, std::hash<int>, std::equal_to<int>, ArenaAllocator<std::pair<const int, int>>>;
+        Map map(16, std::hash<int>(), std::equal_to<int>(), ArenaAllocator<std::pair<const int, int>>(alloc));
+        for (int i = 0; i < 200; ++i) map[i] = i * i;
+        ASSERT(map.at(15) == 225 && map.get_allocator() == alloc);
+
+        Arena other = arena_create(ARENA_CAPACITY_4KB);
+        ASSERT(alloc != ArenaAllocator<int>(&other));
+        arena_destroy(&other);
+    }
+
+    // growth in place: vector grows its top-of-arena buffer without leaving holes behind
+    arena_reset(&arena);
+    {
+        ArenaAllocator<char> alloc(&arena);
+        char *a = alloc.allocate(100);
+        alloc.deallocate(a, 100);
+        char *b = alloc.allocate(100);
+        ASSERT(a == b);
+    }
+
+    arena_destroy(&arena);
+    return true;
+}
+
+TEST_CREATE(test_arena_scope)
+{
+    Arena arena = arena_create_ex(arena_config_create(
+        ARENA_CAPACITY_1KB,
+        ARENA_CAPACITY_1MB,
+        ARENA_GROWTH_CONTRACT_CHUNKY,
+        ARENA_GROWTH_FACTOR_CHUNKY_1KB,
+        ARENA_FLAG_NONE
+    ));
+    ASSERT(arena_alloc_raw(&arena, 100, ARENA_ALIGN_8B) != NULL);
+    arena_size_t used = arena_used_bytes(&arena);
+
+    {
+        ArenaScope outer(&arena);
+        ASSERT(arena_alloc_raw(&arena, 4000, ARENA_ALIGN_8B) != NULL);
+        {
+            ArenaScope inner(&arena);
+            ArenaResource resource(&arena);
+            std::pmr::vector<int> values(&resource);
+            values.resize(2000);
+            ASSERT(arena.chunk_count > 2);
+        }
+        ASSERT(arena_used_bytes(&arena) >= used + 4000);
+    }
+    ASSERT(arena_used_bytes(&arena) == used && arena.chunk_count == 1);
+
+    arena_destroy(&arena);
+    return true;
+}
+
+static int tracked_alive = 0;
+static int tracked_order[16];
+static int tracked_destroyed = 0;
+
+struct Tracked {
+    std::string name; // long enough to live on the heap, leaks without the destructor
+    int         id;
+
+    Tracked() : name(40, 'x'), id(-1) { tracked_alive++; }
+    Tracked(int id_, const char *name_) : name(name_), id(id_) { tracked_alive++; }
+    ~Tracked()
+    {
+        tracked_alive--;
+        if (tracked_destroyed < 16) tracked_order[tracked_destroyed] = id;
+        tracked_destroyed++;
+    }
+};
+
+struct Throwing {
+    std::string payload;
+    explicit Throwing(bool fail) : payload(64, 'p') { if (fail) throw std::runtime_error("nope"); }
+};
+
+struct Plain {
+    float x, y, z;
+};
+
+TEST_CREATE(test_arena_make)
+{
+    ArenaResource resource(arena_config_create(
+        ARENA_CAPACITY_4KB,
+        ARENA_CAPACITY_1MB,
+        ARENA_GROWTH_CONTRACT_CHUNKY,
+        ARENA_GROWTH_FACTOR_CHUNKY_4KB,
+        ARENA_FLAG_NONE
+    ));
+    Arena *arena = resource.arena();
+
+    // trivial types: plain bump, nothing registered
+    Plain *plain = resource.make<Plain>(1.0f, 2.0f, 3.0f);
+    ASSERT(plain->y == 2.0f && (arena_ptr_t)plain % alignof(Plain) == 0);
+    int *ints = resource.make_array<int>(100);
+    ASSERT(arena_owns(arena, ints) && arena_owns(arena, ints + 99));
+    ASSERT(arena->defer == ARENA_HANDLE_NULL);
+
+    // non-trivial types: destructors run on reset, newest first
+    tracked_destroyed = 0;
+    for (int i = 0; i < 3; ++i) ASSERT(resource.make<Tracked>(i, "a name that does not fit into small string buffer")->id == i);
+    Tracked *array = resource.make_array<Tracked>(4);
+    ASSERT(array[3].name.size() == 40 && tracked_alive == 7);
+    ASSERT(resource.reset());
+    ASSERT(tracked_alive == 0 && tracked_destroyed == 7);
+    ASSERT(tracked_order[4] == 2 && tracked_order[5] == 1 && tracked_order[6] == 0);
+
+    // scope end destroys only what was made inside it
+    tracked_destroyed = 0;
+    resource.make<Tracked>(10, "outer");
+    {
+        ArenaScope scope(resource);
+        resource.make<Tracked>(11, "inner");
+        resource.make<Tracked>(12, "inner");
+    }
+    ASSERT(tracked_alive == 1 && tracked_destroyed == 2 && tracked_order[0] == 12 && tracked_order[1] == 11);
+
+    // constructor failure leaves nothing behind
+    arena_size_t used = arena_used_bytes(arena);
+    bool thrown = false;
+    try {
+        resource.make<Throwing>(true);
+    } catch (const std::runtime_error&) {
+        thrown = true;
+    }
+    ASSERT(thrown && arena_used_bytes(arena) == used);
+    ASSERT(resource.make<Throwing>(false)->payload.size() == 64);
+
+    // containers made on the arena release their nodes before the arena goes away
+    auto *names = resource.make<std::pmr::vector<std::pmr::string>>(&resource);
+    for (int i = 0; i < 100; ++i) names->emplace_back(50, 'n');
+    ASSERT(arena_owns(arena, names->data()));
+
+    return tracked_alive == 1; // "outer", destroyed with the resource
+}
+
+TEST_CREATE(test_arena_make_destroy)
+{
+    {
+        ArenaResource resource(arena_config_create(
+            ARENA_CAPACITY_1KB, ARENA_CAPACITY_1MB, ARENA_GROWTH_CONTRACT_CHUNKY, ARENA_GROWTH_FACTOR_CHUNKY_1KB, ARENA_FLAG_NONE
+        ));
+        for (int i = 0; i < 100; ++i) resource.make<Tracked>(i, "spread over many chunks of a small arena");
+        ASSERT(tracked_alive == 100 && resource.arena()->chunk_count > 1);
+        // objects with destructors can not be moved by flatten, it refuses and they stay valid
+        ASSERT(!arena_flatten(resource.arena(), NULL, false));
+        ASSERT(resource.arena()->error == ARENA_ERROR_UNSUPPORTED);
+    }
+    ASSERT(tracked_alive == 0);
+    return true;
+}
+
+#ifdef __cpp_impl_coroutine
+struct TestGenerator {
+    struct promise_type : ArenaPromise {
+        int value = 0;
+
+        TestGenerator get_return_object() { return TestGenerator{std::coroutine_handle<promise_type>::from_promise(*this)}; }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        std::suspend_always yield_value(int v) noexcept { value = v; return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() { throw; }
+    };
+
+    std::coroutine_handle<promise_type> handle;
+
+    explicit TestGenerator(std::coroutine_handle<promise_type> h) : handle(h) {}
+    TestGenerator(TestGenerator &&other) noexcept : handle(other.handle) { other.handle = nullptr; }
+    ~TestGenerator() { if (handle) handle.destroy(); }
+
+    bool next() { handle.resume(); return !handle.done(); }
+    int  value() const { return handle.promise().value; }
+};
+
+static TestGenerator test_count(int n)
+{
+    for (int i = 0; i < n; ++i) co_yield i;
+}
+
+static TestGenerator test_count_on(Arena *, int n)
+{
+    for (int i = 0; i < n; ++i) co_yield i * 2;
+}
+
+TEST_CREATE(test_arena_coroutine)
+{
+    Arena arena = arena_create_ex(arena_config_create(
+        ARENA_CAPACITY_4KB,
+        ARENA_CAPACITY_1MB,
+        ARENA_GROWTH_CONTRACT_CHUNKY,
+        ARENA_GROWTH_FACTOR_CHUNKY_4KB,
+        ARENA_FLAG_NONE
+    ));
+    arena_size_t used = arena_used_bytes(&arena);
+
+    {
+        ArenaFrameScope scope(&arena);
+        TestGenerator outer = test_count(3);
+        TestGenerator inner = test_count(5);
+        ASSERT(arena_owns(&arena, outer.handle.address()) && arena_owns(&arena, inner.handle.address()));
+
+        int sum = 0;
+        while (inner.next()) sum += inner.value();
+        while (outer.next()) sum += outer.value();
+        ASSERT(sum == 10 + 3);
+    }
+    // destroyed in reverse order of creation, bytes went back in place
+    ASSERT(arena_used_bytes(&arena) == used);
+
+    // no scope: heap, explicit arena parameter: that arena
+    {
+        TestGenerator heap = test_count(1);
+        ASSERT(!arena_owns(&arena, heap.handle.address()));
+        TestGenerator scoped = test_count_on(&arena, 4);
+        ASSERT(arena_owns(&arena, scoped.handle.address()));
+        int last = -1;
+        while (scoped.next()) last = scoped.value();
+        ASSERT(last == 6);
+    }
+
+    // frames outlive their scope, bulk release when the whole tree is done
+    {
+        ArenaScope bulk(&arena);
+        TestGenerator *tree[8];
+        {
+            ArenaFrameScope scope(&arena);
+            for (int i = 0; i < 8; ++i) tree[i] = new TestGenerator(test_count(i + 1));
+        }
+        for (int i = 0; i < 8; ++i) {
+            while (tree[i]->next()) {}
+            ASSERT(tree[i]->value() == i);
+        }
+        for (int i = 0; i < 8; ++i) delete tree[i]; // creation order, only the last frame shrinks in place
+    }
+    ASSERT(arena_used_bytes(&arena) == used);
+
+    arena_destroy(&arena);
+    return true;
+}
+#endif
+
+int main(void)
+{
+    TEST_RUN(test_arena_resource);
+    TEST_RUN(test_arena_allocator);
+    TEST_RUN(test_arena_scope);
+    TEST_RUN(test_arena_make);
+    TEST_RUN(test_arena_make_destroy);
+#ifdef __cpp_impl_coroutine
+    TEST_RUN(test_arena_coroutine);
+#endif
+    return 0;
+}
@@ -75,7 +75,7 @@ static Arena FILE_ARENA = {0};
 typedef struct JsonFile {
     char filename[MAX_FILENAME];
     size_t length;
-    char buffer[];
+    char *buffer; // NUL terminated, read only when file got mapped
 } JsonFile;
 
 JsonValue *json_value_alloc(JsonType type);
@@ -98,25 +98,18 @@ JsonFile *json_read_file(const char *filename)
 {
     if (!filename) return NULL;
 
-    FILE *file = fopen(filename, "r");
-    if (!file) return NULL;
-
-    fseek(file, 0, SEEK_END);
-    long file_size = ftell(file);
-    fseek(file, 0, SEEK_SET);
-
-    LOG("File size: %d | File name: %s\n", file_size, filename);
-
-    JsonFile *json = (JsonFile*)arena_alloc_raw(&FILE_ARENA, sizeof(JsonFile)+file_size+1, ARENA_ALIGN_8B);
+    JsonFile *json = arena_alloc_struct(&FILE_ARENA, JsonFile);
     if (!json) return NULL;
 
-    strncpy(json->filename, filename, strlen(filename));
-    fread(json->buffer, 1, file_size, file);
-    
-    json->length = file_size;
-    json->buffer[file_size] = '\0';
+    // big files are mapped, small ones copied, any size fits
+    ArenaSpan span = arena_load_file(&FILE_ARENA, filename, ARENA_LOAD_DEFAULT);
+    if (!span.data) return NULL;
 
-    fclose(file);
+    LOG("File size: %zu | File name: %s | Mapped: %d\n", (size_t)span.size, filename, span.mapped);
+
+    snprintf(json->filename, MAX_FILENAME, "%s", filename);
+    json->length = span.size;
+    json->buffer = (char*)span.data;
     return json;
 }
 
@@ -523,10 +516,10 @@ int main(void)
     ));
 
     FILE_ARENA = arena_create_ex(arena_config_create(
-        ARENA_CAPACITY_1MB,
-        ARENA_CAPACITY_1MB,
-        ARENA_GROWTH_CONTRACT_FIXED,
-        0,
+        ARENA_CAPACITY_4KB,
+        ARENA_CAPACITY_1GB,
+        ARENA_GROWTH_CONTRACT_CHUNKY,
+        ARENA_GROWTH_FACTOR_CHUNKY_1MB,
         0
     ));
     
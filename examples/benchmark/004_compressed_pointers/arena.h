@@ -0,0 +1,2945 @@
+// Copyright 2022 Alexey Kutepov <reximkut@gmail.com>
+
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef ARENA_H_
+#define ARENA_H_
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdalign.h>
+#include <limits.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef uint64_t  arena_size_t;
+#define ARENA_SIZE_FMT "%llu"
+typedef uintptr_t arena_ptr_t;
+
+#define _ARENA_PLATFORM_LIBC  0x0
+#define _ARENA_PLATFORM_WIN32 0x2
+#define _ARENA_PLATFORM_WIN64 0x4
+#define _ARENA_PLATFORM_UNIX  0x8
+
+#ifdef __GNUC__
+    #define _ARENA_FORCE_INLINE static inline __attribute__((always_inline))
+    #define _ARENA_PREFETCH(addr) __builtin_prefetch((addr))
+    #define _ARENA_ATOMIC_LOAD(ptr)         __atomic_load_n((ptr), __ATOMIC_ACQUIRE)
+    #define _ARENA_ATOMIC_STORE(ptr, value) __atomic_store_n((ptr), (value), __ATOMIC_RELEASE)
+    #define _ARENA_ATOMIC_CAS(ptr, expected, desired) \
+        __atomic_compare_exchange_n((ptr), (expected), (desired), true, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)
+    #define _ARENA_ATOMIC_FETCH_ADD(ptr, value) __atomic_fetch_add((ptr), (value), __ATOMIC_ACQ_REL)
+#else
+    #define _ARENA_FORCE_INLINE static inline
+    #define _ARENA_PREFETCH(...)
+    #define _ARENA_ATOMIC_LOAD(ptr)         (*(ptr))
+    #define _ARENA_ATOMIC_STORE(ptr, value) (*(ptr) = (value))
+    #define _ARENA_ATOMIC_CAS(ptr, expected, desired) \
+        (*(ptr) == *(expected) ? (*(ptr) = (desired), true) : (*(expected) = *(ptr), false))
+    #define _ARENA_ATOMIC_FETCH_ADD(ptr, value) ((*(ptr) += (value)) - (value))
+#endif
+
+#ifndef ARENA_PLATFORM
+    #if defined(_WIN32)
+        #define ARENA_PLATFORM _ARENA_PLATFORM_WIN32
+    #elif defined(_WIN64)
+        #define ARENA_PLATFORM _ARENA_PLATFORM_WIN64
+    #elif defined(__unix__) || defined(__linux__)
+        #define ARENA_PLATFORM _ARENA_PLATFORM_UNIX
+    #else
+        #define ARENA_PLATFORM _ARENA_PLATFORM_LIBC
+    #endif
+#endif 
+
+#if (ARENA_PLATFORM == _ARENA_PLATFORM_WIN32)
+    #define WIN32_LEAN_AND_MEAN
+    #define NOGDI
+    #define NOMINMAX
+    #define NOUSER
+    #define NOSERVICE
+    #define NOMCX
+    #define NOSOUND
+    #define NOCOMM
+    #define NORPC
+    #include <windows.h>
+#elif ARENA_PLATFORM == _ARENA_PLATFORM_UNIX
+    #include <unistd.h>
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #if defined(__linux__)
+        #include <sys/syscall.h>
+    #endif
+    #ifndef MAP_FIXED_NOREPLACE
+        #define MAP_FIXED_NOREPLACE 0 // address becomes a hint, result is checked anyway
+    #endif
+#else
+    #error("Undefined platform")
+#endif
+
+#ifndef ARENA_NOMINAX
+    #define ARENA_MAX(a, b) ((a) - (((a) - (b)) & (((a) - (b)) >> 31))) // damn
+    #define ARENA_MIN(a, b) ((b) + (((a) - (b)) & (((a) - (b)) >> 31)))
+#endif
+
+#define ARENA_U64_MAX  0xffffffffffffffffull
+#define ARENA_U32_MAX  0xffffffffu
+#define ARENA_SIZE_MAX SIZE_MAX
+#define ARENA_PTR_MAX  MAXINT_PTR
+
+#ifndef ARENA_CACHELINE_SIZE
+#define ARENA_CACHELINE_SIZE (uint32_t)64
+#endif
+
+#define _ARENA_POISON_ALLOC         0xCD   // arena memory poisoning value after allocating memory from arena
+#define _ARENA_POISON_RESET         0xDD   // arena memory poisoning value after resetting arena
+
+#define ARENA_PAGE_ALIGN_THRESHOLD 0x2000  // used to identify when to switch to platform specific allocation 
+#define ARENA_PAGE_DEFAULT_SIZE    0x1000  // for libc universal platform 
+
+typedef enum ArenaGrowthContract : uint32_t {
+    ARENA_GROWTH_CONTRACT_FIXED       = 0,
+    ARENA_GROWTH_CONTRACT_REALLOC     = 2,
+    ARENA_GROWTH_CONTRACT_CHUNKY      = 4,
+    ARENA_GROWTH_CONTRACT_RESERVE     = 8, // max_capacity of address space reserved up front, pages committed on growth, never moves
+} ArenaGrowthContract;
+
+typedef enum ArenaGrowthFactor : uint32_t {
+    ARENA_GROWTH_FACTOR_NONE        = 0x0,    // none =D
+    ARENA_GROWTH_FACTOR_REALLOC_2X  = 0x2,    // for mul operation
+    ARENA_GROWTH_FACTOR_REALLOC_4X  = 0x4,    // for mul operation
+    ARENA_GROWTH_FACTOR_REALLOC_8X  = 0x8,    // for mul operation
+    ARENA_GROWTH_FACTOR_CHUNKY_512B  = 0x200,
+    ARENA_GROWTH_FACTOR_CHUNKY_1KB   = 0x400,
+    ARENA_GROWTH_FACTOR_CHUNKY_2KB   = 0x800,
+    ARENA_GROWTH_FACTOR_CHUNKY_4KB   = 0x1000,
+    ARENA_GROWTH_FACTOR_CHUNKY_8KB   = 0x2000,
+    ARENA_GROWTH_FACTOR_CHUNKY_16KB  = 0x4000,
+    ARENA_GROWTH_FACTOR_CHUNKY_32KB  = 0x8000,
+    ARENA_GROWTH_FACTOR_CHUNKY_64KB  = 0x10000,
+    ARENA_GROWTH_FACTOR_CHUNKY_128KB = 0x20000,
+    ARENA_GROWTH_FACTOR_CHUNKY_256KB = 0x40000,
+    ARENA_GROWTH_FACTOR_CHUNKY_512KB = 0x80000,
+    ARENA_GROWTH_FACTOR_CHUNKY_1MB   = 0x100000,
+    ARENA_GROWTH_FACTOR_CHUNKY_2MB   = 0x200000,
+    ARENA_GROWTH_FACTOR_CHUNKY_MAX   = ARENA_GROWTH_FACTOR_CHUNKY_2MB,
+    ARENA_GROWTH_FACTOR_CHUNKY_MIN   = ARENA_GROWTH_FACTOR_CHUNKY_512B,
+} ArenaGrowthFactor;
+
+#define ARENA_CAPACITY_CHOOSE_FOR_ME_PLS 0 
+#define ARENA_CAPACITY_512B    (arena_size_t)0x200
+#define ARENA_CAPACITY_1KB     (arena_size_t)0x400
+#define ARENA_CAPACITY_2KB     (arena_size_t)0x800
+#define ARENA_CAPACITY_4KB     (arena_size_t)0x1000
+#define ARENA_CAPACITY_8KB     (arena_size_t)0x2000
+#define ARENA_CAPACITY_16KB    (arena_size_t)0x4000
+#define ARENA_CAPACITY_32KB    (arena_size_t)0x8000
+#define ARENA_CAPACITY_64KB    (arena_size_t)0x10000
+#define ARENA_CAPACITY_128KB   (arena_size_t)0x20000
+#define ARENA_CAPACITY_256KB   (arena_size_t)0x40000
+#define ARENA_CAPACITY_512KB   (arena_size_t)0x80000
+#define ARENA_CAPACITY_1MB     (arena_size_t)0x100000
+#define ARENA_CAPACITY_2MB     (arena_size_t)0x200000
+#define ARENA_CAPACITY_4MB     (arena_size_t)0x400000
+#define ARENA_CAPACITY_8MB     (arena_size_t)0x800000
+#define ARENA_CAPACITY_16MB    (arena_size_t)0x1000000
+#define ARENA_CAPACITY_32MB    (arena_size_t)0x2000000
+#define ARENA_CAPACITY_64MB    (arena_size_t)0x4000000
+#define ARENA_CAPACITY_128MB   (arena_size_t)0x8000000
+#define ARENA_CAPACITY_256MB   (arena_size_t)0x10000000
+#define ARENA_CAPACITY_512MB   (arena_size_t)0x20000000
+#define ARENA_CAPACITY_1GB     (arena_size_t)0x40000000
+#define ARENA_CAPACITY_2GB     (arena_size_t)0x80000000
+#define ARENA_CAPACITY_4GB     (arena_size_t)0x100000000
+#define ARENA_CAPACITY_8GB     (arena_size_t)0x200000000
+#define ARENA_CAPACITY_DEFAULT ARENA_CAPACITY_4KB
+#define ARENA_CAPACITY_MAX     ARENA_CAPACITY_8GB
+#define ARENA_CAPACITY_MIN     ARENA_CAPACITY_512B
+
+#define ARENA_ALLOC_TYPE_SMALL 0x0 // arena is allocated as an array of bytes
+#define ARENA_ALLOC_TYPE_BIG   0x1 // arena is allocated as memory pages
+
+#define ARENA_CHUNK_BACKING_DEFAULT 0x0 // allocated according to arena alloc type
+#define ARENA_CHUNK_BACKING_MAPPED  0x1 // private mapping of a snapshot file
+#define ARENA_CHUNK_BACKING_FILE    0x2 // shared mapping of arena file (arena_create_file)
+#define ARENA_CHUNK_BACKING_SHARED  0x3 // shared memory object, header page sits right before the chunk
+#define ARENA_CHUNK_BACKING_RESERVED 0x4 // address space reservation (ARENA_GROWTH_CONTRACT_RESERVE)
+
+typedef enum ArenaAlignment : uint32_t {
+    // Alignment constants
+    ARENA_ALIGN_2B      = 2,
+    ARENA_ALIGN_4B      = 4,
+    ARENA_ALIGN_8B      = 8,
+    ARENA_ALIGN_16B     = 16,
+    ARENA_ALIGN_32B     = 32,
+    ARENA_ALIGN_64B     = 64,
+    ARENA_ALIGN_128B    = 128,
+    ARENA_ALIGN_256B    = 256,
+    ARENA_ALIGN_512B    = 512,
+    ARENA_ALIGN_DEFAULT = ARENA_ALIGN_16B,
+    
+    // SIMD support
+    ARENA_ALIGN_SIMD_MMX       = 8,
+    ARENA_ALIGN_SIMD_SSE       = 16,
+    ARENA_ALIGN_SIMD_AVX       = 32,
+    ARENA_ALIGN_SIMD_AVX512    = 512,
+
+    // Cache line sized alignment
+    ARENA_ALIGN_CACHELINE = ARENA_CACHELINE_SIZE,
+} ArenaAlignment;
+
+typedef enum ArenaFlag : uint16_t {
+    ARENA_FLAG_NONE              = 0,
+    ARENA_FLAG_FILLZEROES        = 1,
+    ARENA_FLAG_DEBUG             = 1 << 1,
+    ARENA_FLAG_ENFORCE_ALIGNMENT = 1 << 2,
+    ARENA_FLAG_RESET_AFTER_GROW  = 1 << 3,
+    ARENA_FLAG_FIXED_CHUNK_SIZE  = 1 << 4,
+    ARENA_FLAG_SHARED            = 1 << 5, // chunk is shared between processes, offset is bumped atomically
+} ArenaFlag;
+
+typedef enum ArenaError : uint32_t {
+    ARENA_ERROR_NONE = 0,
+
+    ARENA_ERROR_INVALID_CAPACITY,
+    ARENA_ERROR_INVALID_ALIGNMENT,
+
+    ARENA_ERROR_OOM,
+    ARENA_ERROR_ALIGNMENT_TOO_LARGE,
+    ARENA_ERROR_SIZE_ZERO,
+    ARENA_ERROR_SIZE_OVERFLOW,
+
+    ARENA_ERROR_GROWTH_FORBIDDEN,
+    ARENA_ERROR_MAX_CAPACITY_REACHED,
+    ARENA_ERROR_REALLOC_FAILED,
+    ARENA_ERROR_CHUNK_ALLOC_FAILED,
+
+    ARENA_ERROR_EPOCH_MISMATCH,
+
+    ARENA_ERROR_MAPPING_FAILED,
+    ARENA_ERROR_RING_FULL,
+    ARENA_ERROR_INVALID_HANDLE,
+
+    ARENA_ERROR_IO,
+    ARENA_ERROR_SNAPSHOT_INVALID,
+    ARENA_ERROR_SNAPSHOT_RELOCATED,
+    ARENA_ERROR_SHARED_INVALID,
+} ArenaError;
+
+typedef struct ArenaConfig {
+    arena_size_t        capacity;
+    arena_size_t        max_capacity;
+    ArenaGrowthContract growth_contract;
+    size_t              growth_factor;
+    ArenaFlag           flags;
+} ArenaConfig;
+
+typedef struct ArenaDebugInfo {
+    uint8_t      *end;              // address to the end of the last allocated block of memory
+    arena_size_t bytes_lost;        // bytes loss due to alignment
+    size_t       total_allocations; // obviously number of total allocations
+} ArenaDebugInfo;   
+
+typedef struct ArenaChunk {
+    struct ArenaChunk  *next;
+    arena_size_t       capacity;
+    arena_size_t       offset;
+    uint32_t           index;    // position in the chain (and in arena chunk directory)
+    uint32_t           backing;  // where chunk memory comes from - ARENA_CHUNK_BACKING_...
+    uint8_t            base[];
+} ArenaChunk;
+
+typedef struct ArenaMemory {
+    ArenaChunk   *chunk;    // pointer to chunk
+    void         *data;     // pointer to data
+    size_t       alignment; // how data is aligned in this memory
+    arena_size_t offset;    // offset from the chunk base to the data
+    arena_size_t size;      // memory size
+    arena_size_t epoch;
+} ArenaMemory;
+
+/*
+    Packed 8 byte reference to arena memory: [ epoch:12 | chunk index + 1:18 | offset:34 ]
+    Survives realloc growth, zero value is NULL handle.
+*/
+typedef uint64_t ArenaHandle;
+
+#define ARENA_HANDLE_NULL        ((ArenaHandle)0)
+#define ARENA_HANDLE_OFFSET_BITS 34 // up to 16GB per chunk
+#define ARENA_HANDLE_CHUNK_BITS  18 // up to 262143 chunks
+#define ARENA_HANDLE_EPOCH_BITS  12 // low bits of arena epoch, catches most stale handles
+#define ARENA_HANDLE_OFFSET_MASK ((1ull << ARENA_HANDLE_OFFSET_BITS) - 1)
+#define ARENA_HANDLE_CHUNK_MASK  ((1ull << ARENA_HANDLE_CHUNK_BITS) - 1)
+#define ARENA_HANDLE_EPOCH_MASK  ((1ull << ARENA_HANDLE_EPOCH_BITS) - 1)
+
+typedef struct ArenaMark {
+    ArenaChunk   *chunk;
+    arena_size_t offset;
+    arena_size_t epoch;
+    arena_size_t reserved; // arena reserved memory at the moment of marking
+} ArenaMark;
+
+typedef struct Arena {
+    // metadata
+    arena_size_t        reserved;        // memory reserved for user data (does not include chunk metadata and used for OOM check)
+    arena_size_t        max_capacity;    // max arena capacity (machine dependent), it shows how big this arena can be if it can grow
+    arena_size_t        growth_factor;   // how fast grows (depends on contract)
+    ArenaGrowthContract growth_contract; // arena growth contract (how to grow)
+    ArenaFlag           flags;           // arena flags - ARENA_FLAG_...
+    ArenaError          error;           // error flag
+    uint32_t            alloc_type;      // reflects how arena memory was originally allocated and must not change during arena lifetime
+    arena_size_t        epoch;
+    // chunks
+    ArenaChunk          *head_chunk;
+    ArenaChunk          *last_chunk;
+    ArenaChunk          *free_chunks;    // chunks released by `arena_restore`, reused by `arena_grow` before asking OS for more
+    // backing of new chunks
+    uint32_t            backing;         // ARENA_CHUNK_BACKING_DEFAULT or ARENA_CHUNK_BACKING_FILE
+    int                 fd;              // arena file (ARENA_CHUNK_BACKING_FILE only)
+    arena_size_t        file_size;       // end of the last chunk region in arena file
+    // chunk directory
+    ArenaChunk          **chunks;        // chain order (allocated on first chunky growth, until then head_chunk is the only chunk)
+    ArenaChunk          **chunks_sorted; // every owned chunk (chain + cache) sorted by address
+    uint32_t            chunk_count;     // chunks in the chain
+    uint32_t            owned_count;     // chunks owned by arena (chain + cache)
+    uint32_t            chunk_capacity;  // chunk directory capacity
+    //debug
+    ArenaDebugInfo      debug;
+} Arena;
+
+#define ARENA_EMPTY ((Arena){0})
+
+typedef struct ArenaTemp {
+    Arena     *arena;
+    ArenaMark mark;
+} ArenaTemp;
+
+typedef struct ArenaRing {
+    uint8_t      *base;     // first of two adjacent views of the same pages (record at the end continues in the second view)
+    arena_size_t capacity;  // size of one view (multiple of page size)
+    arena_size_t head;      // bytes published to the consumer (monotonic, written by producer)
+    arena_size_t write;     // producer cursor, becomes visible to the consumer on `arena_ring_commit`
+    arena_size_t tail;      // bytes released by the consumer (monotonic, written by consumer)
+    ArenaError   error;     // error flag
+} ArenaRing;
+
+#define ARENA_RING_EMPTY ((ArenaRing){0})
+
+/*
+    Stable reference to an object in `ArenaTable`: [ generation:32 | slot + 1:32 ]
+    Unlike `ArenaHandle` it stays valid when `arena_compact` moves the object.
+*/
+typedef uint64_t ArenaRef;
+
+#define ARENA_REF_NULL ((ArenaRef)0)
+
+/*
+    Self-relative pointers: distance in bytes from the field itself to the target, 0 is NULL.
+    Data linked with them survives `_arena_realloc`, snapshots and shared mappings without fix-ups,
+    as long as field and target move together (same chunk, or whole arena copied as one block).
+*/
+typedef struct ArenaRelPtr32 { int32_t offset; } ArenaRelPtr32;
+typedef struct ArenaRelPtr64 { int64_t offset; } ArenaRelPtr64;
+
+/*
+    Compressed pointer: (ptr - head chunk) >> ARENA_CPTR_SHIFT in 32 bits, 0 is NULL.
+    Covers 32GB with 8 byte aligned objects. Needs single chunk arena (FIXED, REALLOC or RESERVE),
+    RESERVE is the one that grows without ever moving (and without breaking raw pointers too).
+*/
+typedef uint32_t ArenaCPtr;
+
+#define ARENA_CPTR_NULL  ((ArenaCPtr)0)
+#define ARENA_CPTR_SHIFT 3
+
+typedef struct ArenaTableEntry {
+    ArenaHandle  handle;     // current location of the object (ARENA_HANDLE_NULL for free slot)
+    arena_size_t size;       // object size (next free slot + 1 for free slot)
+    uint32_t     alignment;
+    uint32_t     generation; // bumped on free, so stale refs stop resolving
+} ArenaTableEntry;
+
+/*
+    Object graph description for `arena_evacuate`.
+    Trace function returns size of `object` and calls `visit(&field, ctx)` for every pointer field of it.
+    `visit` is NULL when only the size is needed. Pointer fields must point to the start of an object.
+*/
+typedef void (*ArenaVisitFn)(void **slot, void *ctx);
+typedef arena_size_t (*ArenaTraceFn)(void *object, ArenaVisitFn visit, void *ctx);
+
+typedef struct ArenaGenStats {
+    size_t       cycles;           // finished nursery cycles
+    arena_size_t allocated_bytes;  // bytes allocated in nursery (all cycles)
+    arena_size_t promoted_bytes;   // bytes copied into tenured (all cycles)
+    size_t       promoted_objects;
+    arena_size_t cycle_allocated;  // bytes allocated in nursery in current cycle
+    arena_size_t cycle_promoted;   // bytes promoted in current cycle
+} ArenaGenStats;
+
+typedef struct ArenaGen {
+    Arena         nursery;    // short lived objects, rolled back every cycle (keep it cache sized)
+    Arena         tenured;    // chunky arena for survivors
+    ArenaMark     cycle_mark; // nursery position at the start of the cycle
+    ArenaGenStats stats;
+} ArenaGen;
+
+/*
+    Snapshot file layout:
+    [ header page ][ chunk 0 region ][ chunk 1 region ] ...
+    Every region is page aligned and holds chunk image (header + used bytes) at the same in-page offset
+    as the original chunk had, so it can be mapped back at the original address. Original address of
+    chunk N+1 is `next` field of chunk N image. Unused chunk tail is a hole in the file.
+*/
+#define ARENA_SNAPSHOT_MAGIC   0x504E534E45524141ull // "AARENSNP"
+#define ARENA_FILE_MAGIC       0x4C49464E45524141ull // "AARENFIL", same header, regions in allocation order
+#define ARENA_SNAPSHOT_VERSION 1u
+
+typedef struct ArenaSnapshotHeader {
+    uint64_t     magic;
+    uint32_t     version;
+    uint32_t     chunk_count;
+    uint64_t     page_size;
+    uint64_t     head_address;    // original address of the head chunk
+    arena_size_t max_capacity;
+    arena_size_t growth_factor;
+    arena_size_t epoch;
+    uint32_t     growth_contract;
+    uint32_t     flags;
+    uint32_t     alloc_type;
+    uint32_t     chunk_header_size;
+} ArenaSnapshotHeader;
+
+typedef struct ArenaSharedHeader {
+    uint64_t     magic;           // stored last by creator, attach fails until it is set
+    uint32_t     version;
+    uint32_t     page_size;
+    uint64_t     size;            // whole mapping: header page + chunk
+    arena_size_t epoch;           // bumped atomically by `arena_reset` in any process
+} ArenaSharedHeader;
+
+#define ARENA_SHARED_MAGIC     0x4D48534E45524141ull // "AARENSHM"
+#define ARENA_SHARED_VERSION   1u
+
+typedef struct ArenaTable {
+    Arena           arena;          // object storage, replaced by `arena_compact`
+    ArenaConfig     config;         // used to create fresh storage on compaction
+    ArenaTableEntry *entries;
+    uint32_t        entry_count;
+    uint32_t        entry_capacity;
+    uint32_t        free_slot;      // head of free slot list (slot + 1, zero if empty)
+    arena_size_t    live_bytes;     // bytes of objects reachable through the table
+    arena_size_t    dead_bytes;     // bytes of freed objects still occupying storage
+} ArenaTable;
+
+static inline Arena arena_create_ex(ArenaConfig config);
+static inline ArenaConfig arena_config_create(arena_size_t capacity, arena_size_t max_capacity, ArenaGrowthContract contract, size_t growth_factor, ArenaFlag flags);
+static inline Arena arena_create(arena_size_t capacity);
+static inline void arena_destroy(Arena *arena);
+static inline ArenaMemory arena_alloc(Arena *arena, arena_size_t size, size_t alignment);
+static inline void *arena_alloc_raw(Arena *arena, arena_size_t size, size_t alignment);
+static inline ArenaMemory arena_alloc_zero(Arena *arena, arena_size_t size, size_t alignment);
+static inline bool arena_reset(Arena *arena);
+static inline bool arena_grow(Arena *arena, arena_size_t min_required_size);
+static inline void *arena_memory_resolve(Arena *arena, ArenaMemory *memory);
+static inline ArenaMark arena_mark(const Arena *arena);
+static inline bool arena_restore(Arena *arena, ArenaMark mark, bool poison_memory);
+static inline ArenaHandle arena_alloc_handle(Arena *arena, arena_size_t size, size_t alignment);
+static inline ArenaHandle arena_handle_of(const Arena *arena, const void *ptr);
+static inline void *arena_handle_resolve(Arena *arena, ArenaHandle handle);
+static inline ArenaChunk *arena_chunk_of(const Arena *arena, const void *ptr);
+static inline bool arena_owns(const Arena *arena, const void *ptr);
+static inline ArenaTemp arena_temp_begin(Arena *arena);
+static inline bool arena_temp_end(ArenaTemp temp);
+static inline void arena_trim(Arena *arena);
+
+static inline ArenaTable arena_table_create(ArenaConfig config);
+static inline void arena_table_destroy(ArenaTable *table);
+static inline ArenaRef arena_table_alloc(ArenaTable *table, arena_size_t size, size_t alignment);
+static inline void *arena_table_get(ArenaTable *table, ArenaRef ref);
+static inline bool arena_table_free(ArenaTable *table, ArenaRef ref);
+static inline double arena_table_fragmentation(const ArenaTable *table);
+static inline bool arena_compact(ArenaTable *table);
+
+static inline bool arena_evacuate(Arena *from, Arena *to, void **roots, size_t root_count, ArenaTraceFn trace);
+static inline arena_size_t arena_used_bytes(const Arena *arena);
+
+static inline ArenaGen arena_gen_create(ArenaConfig nursery_config, ArenaConfig tenured_config);
+static inline void arena_gen_destroy(ArenaGen *gen);
+static inline void *arena_gen_alloc(ArenaGen *gen, arena_size_t size, size_t alignment);
+static inline void *arena_gen_promote(ArenaGen *gen, const void *object, arena_size_t size, size_t alignment);
+static inline bool arena_gen_promote_graph(ArenaGen *gen, void **roots, size_t root_count, ArenaTraceFn trace);
+static inline void arena_gen_cycle(ArenaGen *gen);
+static inline double arena_gen_survival_rate(const ArenaGen *gen);
+
+_ARENA_FORCE_INLINE void *arena_relptr32_get(const ArenaRelPtr32 *rel);
+_ARENA_FORCE_INLINE bool arena_relptr32_set(ArenaRelPtr32 *rel, const void *target);
+_ARENA_FORCE_INLINE void *arena_relptr64_get(const ArenaRelPtr64 *rel);
+_ARENA_FORCE_INLINE bool arena_relptr64_set(ArenaRelPtr64 *rel, const void *target);
+
+_ARENA_FORCE_INLINE ArenaCPtr arena_cptr_encode(const Arena *arena, const void *ptr);
+_ARENA_FORCE_INLINE void *arena_cptr_decode(const Arena *arena, ArenaCPtr cptr);
+
+static inline const char *arena_capacity_str(size_t capacity);
+static inline const char *arena_platform_str();
+static inline const char *arena_get_error(const Arena *arena);
+static inline const char *arena_error_str(ArenaError error);
+
+#if ARENA_PLATFORM == _ARENA_PLATFORM_UNIX
+static inline ArenaRing arena_ring_create(arena_size_t capacity);
+static inline void arena_ring_destroy(ArenaRing *ring);
+static inline void *arena_ring_alloc(ArenaRing *ring, arena_size_t size, size_t alignment);
+static inline void arena_ring_commit(ArenaRing *ring);
+static inline void *arena_ring_peek(const ArenaRing *ring, arena_size_t *available);
+static inline bool arena_ring_release(ArenaRing *ring, arena_size_t size);
+static inline bool arena_ring_release_to(ArenaRing *ring, const void *end);
+
+static inline ArenaError arena_snapshot_write(const Arena *arena, const char *path);
+static inline Arena arena_snapshot_map(const char *path);
+
+static inline Arena arena_create_file(const char *path, ArenaConfig config);
+static inline Arena arena_open_file(const char *path);
+static inline bool arena_sync(Arena *arena);
+
+static inline Arena arena_create_shared(const char *name, ArenaConfig config);
+static inline Arena arena_attach_shared(const char *name);
+static inline bool arena_shared_unlink(const char *name);
+#endif
+
+_ARENA_FORCE_INLINE long long arena_abs(long long value);
+
+#ifdef ARENA_USE_STD_STRING // if defined <string.h> functions will be used
+    #include <string.h>
+    #define arena_memcpy      memcpy
+    #define arena_memset      memset
+    #define arena_strdup      strdup
+    #define arena_strlen      strlen
+    #define arena_strlen_fast strlen
+#else
+    static inline void *arena_memcpy(void *dst, const void *src, size_t count);
+    static inline void *arena_memset(void *dst, int value, size_t size);
+    static inline char *arena_strdup(Arena *arena, const char *src);
+    static inline size_t arena_strlen(const char *str);
+    static inline size_t arena_strlen_fast(const char *str);
+#endif
+
+#define ARENA_IMPLEMENTATION
+#ifdef ARENA_IMPLEMENTATION
+
+#ifdef ARENA_LOGGING
+    #include <stdarg.h>
+    #include <stdio.h>
+    #define ARENA_LOG(fmt, ...) printf("[+] "fmt"\n", ##__VA_ARGS__)
+#else
+    #define ARENA_LOG(...)
+#endif
+
+_ARENA_FORCE_INLINE arena_size_t _arena_sadd(arena_size_t a, arena_size_t b, arena_size_t max)
+{
+    return (a > (max - b)) ? max : (a + b);
+}
+
+_ARENA_FORCE_INLINE arena_size_t _arena_ssub(arena_size_t a, arena_size_t b, arena_size_t min)
+{
+    return (a < (b + min)) ? min : (a - b);
+}
+
+_ARENA_FORCE_INLINE arena_size_t _arena_smul(arena_size_t a, arena_size_t b, arena_size_t max)
+{
+    return (a > (max / b)) ? max : (a * b);
+}
+
+_ARENA_FORCE_INLINE bool _arena_is_pow2(size_t value)
+{
+    return (value && !(value & (value - 1)));
+}
+
+_ARENA_FORCE_INLINE bool _arena_is_aligned_to(arena_size_t value, size_t alignment)
+{
+    return (alignment > 0) && ((value % alignment) == 0);
+}
+
+_ARENA_FORCE_INLINE arena_size_t _arena_align_up(arena_size_t value, size_t alignment)
+{
+    size_t a = alignment ? alignment : 1;
+    return (_arena_sadd(value, a - 1, ARENA_U64_MAX)) & ~(a - 1);
+}
+
+_ARENA_FORCE_INLINE size_t _arena_downcast_size(arena_size_t value, bool *overflow)
+{
+    if (overflow) *overflow = false;
+
+    #if ARENA_SIZE_MAX == ARENA_U32_MAX
+    // 32-bit system check
+    if (value > ARENA_SIZE_MAX) {
+        if (overflow) *overflow = true;
+        return ARENA_SIZE_MAX;
+    }
+    #endif
+
+    return (size_t)value;
+}
+
+_ARENA_FORCE_INLINE size_t _arena_get_platform_page_size()
+{
+    #if (ARENA_PLATFORM == _ARENA_PLATFORM_WIN32)
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    return si.dwPageSize;
+    #elif ARENA_PLATFORM == _ARENA_PLATFORM_UNIX
+    long ps = sysconf(_SC_PAGESIZE);
+    return ps > 0 ? (size_t)ps : ARENA_PAGE_DEFAULT_SIZE;
+    #else
+    return ARENA_PAGE_DEFAULT_SIZE;
+    #endif
+}
+
+_ARENA_FORCE_INLINE void _arena_set_error(Arena *arena, ArenaError flag)
+{
+    if (NULL != arena) {
+        arena->error = flag;
+    }
+}
+
+_ARENA_FORCE_INLINE size_t _arena_calc_chunk_real_size(arena_size_t capacity)
+{
+    return _arena_downcast_size(_arena_sadd(sizeof(ArenaChunk), capacity, ARENA_SIZE_MAX), NULL);
+}
+
+_ARENA_FORCE_INLINE arena_size_t _arena_calc_chunk_capacity(size_t chunk_real_size)
+{
+    return (arena_size_t)(chunk_real_size - sizeof(ArenaChunk));
+}
+
+static inline const char *arena_capacity_str(size_t capacity)
+{
+    switch (capacity) {
+        case ARENA_CAPACITY_1KB:       return "1KB";
+        case ARENA_CAPACITY_2KB:       return "2KB";
+        case ARENA_CAPACITY_4KB:       return "4KB";
+        case ARENA_CAPACITY_8KB:       return "8KB";
+        case ARENA_CAPACITY_16KB:      return "16KB";
+        case ARENA_CAPACITY_32KB:      return "32KB";
+        case ARENA_CAPACITY_64KB:      return "64KB";
+        case ARENA_CAPACITY_128KB:     return "128KB";
+        case ARENA_CAPACITY_256KB:     return "256KB";
+        case ARENA_CAPACITY_512KB:     return "512KB";
+        case ARENA_CAPACITY_1MB:       return "1MB";
+        case ARENA_CAPACITY_2MB:       return "2MB";
+        case ARENA_CAPACITY_4MB:       return "4MB";
+        case ARENA_CAPACITY_8MB:       return "8MB";
+        case ARENA_CAPACITY_16MB:      return "16MB";
+        case ARENA_CAPACITY_32MB:      return "32MB";
+        case ARENA_CAPACITY_64MB:      return "64MB";
+        case ARENA_CAPACITY_128MB:     return "128MB";
+        case ARENA_CAPACITY_256MB:     return "256MB";
+        case ARENA_CAPACITY_512MB:     return "512MB";
+        case ARENA_CAPACITY_1GB:       return "1GB";
+        case ARENA_CAPACITY_MAX:       return "8GB"; 
+        default:                       return "Custom";
+    }
+}
+
+static inline const char *arena_platform_str()
+{
+    switch (ARENA_PLATFORM) {
+        case _ARENA_PLATFORM_WIN32: return "WIN32";
+        case _ARENA_PLATFORM_WIN64: return "WIN64";
+        case _ARENA_PLATFORM_UNIX:  return "UNIX";
+        case _ARENA_PLATFORM_LIBC:  return "LIBC";
+        default:                    return "UNKNOWN";
+    }
+}
+
+static inline const char *arena_get_error(const Arena *arena)
+{
+    return arena_error_str(arena->error);
+}
+
+static inline const char *arena_error_str(ArenaError error)
+{
+    switch (error) {
+        case ARENA_ERROR_NONE:                 return "No errors.";
+        case ARENA_ERROR_ALIGNMENT_TOO_LARGE:  return "Alignment value is too big.";
+        case ARENA_ERROR_CHUNK_ALLOC_FAILED:   return "Failed to allocate memory chunk.";
+        case ARENA_ERROR_EPOCH_MISMATCH:       return "Epoch mismatch.";
+        case ARENA_ERROR_GROWTH_FORBIDDEN:     return "Growth forbidden. Use another growth contract.";
+        case ARENA_ERROR_INVALID_ALIGNMENT:    return "Invalid alignment value.";
+        case ARENA_ERROR_INVALID_CAPACITY:     return "Invalid capacity value.";
+        case ARENA_ERROR_REALLOC_FAILED:       return "Failed to reallocate memory chunk.";
+        case ARENA_ERROR_MAX_CAPACITY_REACHED: return "Growth forbidden. Max capacity reached.";
+        case ARENA_ERROR_OOM:                  return "Out of memory.";
+        case ARENA_ERROR_SIZE_OVERFLOW:        return "Size overflow.";
+        case ARENA_ERROR_SIZE_ZERO:            return "Zero size.";
+        case ARENA_ERROR_MAPPING_FAILED:       return "Failed to map memory.";
+        case ARENA_ERROR_RING_FULL:            return "Ring is full. Release some records first.";
+        case ARENA_ERROR_INVALID_HANDLE:       return "Invalid handle.";
+        case ARENA_ERROR_IO:                   return "I/O error.";
+        case ARENA_ERROR_SNAPSHOT_INVALID:     return "Invalid or incompatible snapshot.";
+        case ARENA_ERROR_SNAPSHOT_RELOCATED:   return "Snapshot mapped at different addresses. Raw pointers inside it are invalid.";
+        case ARENA_ERROR_SHARED_INVALID:       return "Invalid or uninitialized shared arena.";
+        default:                               return "Unknown";
+    }
+}
+
+static inline void *_arena_alloc_chunk(size_t chunk_capacity, uint32_t alloc_type)
+{
+    /*
+        Invariants:
+        - chunk.capacity <= chunk_real_size - sizeof(ArenaChunk)
+        - chunk.offset == 0
+        - chunk.next   == NULL
+    */
+    size_t page_size = _arena_get_platform_page_size();
+
+    ArenaChunk *chunk      = NULL;
+    size_t chunk_real_size = _arena_calc_chunk_real_size(chunk_capacity);
+
+    // to make actual assertion that actual chunk capacity >= chunk_capacity
+    if (_arena_calc_chunk_capacity(chunk_real_size) < chunk_capacity) {
+        ARENA_LOG("Critical error while allocating new chunk: allocation capacity is less than required capacity.");
+        return NULL;
+    }
+
+    if (alloc_type == ARENA_ALLOC_TYPE_BIG) {
+    #if ARENA_PLATFORM == _ARENA_PLATFORM_UNIX
+        chunk = mmap(
+            NULL, 
+            chunk_real_size,
+            PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS,
+            -1, 0
+        );
+        if (chunk == MAP_FAILED) goto exit_error;
+        ARENA_LOG("New chunk allocated with `nmap` as %d bytes sized pages. Platform: %s Size: %zu", page_size, arena_platform_str(), chunk_real_size);
+    #elif (ARENA_PLATFORM == _ARENA_PLATFORM_WIN32)
+        chunk = VirtualAlloc(NULL, chunk_real_size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+        if (!chunk) goto exit_error;
+        ARENA_LOG("New chunk allocated with with `VirtualAlloc` as %d bytes sized pages. Platform: %s Size: %zu", page_size, arena_platform_str(), chunk_real_size);
+    #elif ARENA_PLATFORM == _ARENA_PLATFORM_LIBC
+        chunk = malloc(chunk_real_size);
+        if (!chunk) goto exit_error;
+        ARENA_LOG("New chunk allocated with `malloc` as %d bytes sized pages. Platform: %s Size: %zu", page_size, arena_platform_str(), chunk_real_size);
+    #else
+        #error("Failed to apply platform dependent allocation. You are not supposed to see this error.")
+    #endif
+    } else {
+        chunk = malloc(chunk_real_size); // small heap allocation
+        if (!chunk) goto exit_error;
+        ARENA_LOG("New chunk allocated with size of %d bytes. Platform: %s", chunk_real_size, arena_platform_str());
+    }
+
+    chunk->next     = NULL;
+    chunk->offset   = 0;
+    chunk->index    = 0;
+    chunk->backing  = ARENA_CHUNK_BACKING_DEFAULT;
+    chunk->capacity = _arena_calc_chunk_capacity(chunk_real_size);
+
+    ARENA_LOG("Chunk: base:%p capacity:%d", chunk->base, chunk->capacity);
+
+    return chunk;
+
+exit_error:
+    ARENA_LOG("Failed to allocate arena chunk.");
+    return NULL;
+}
+
+_ARENA_FORCE_INLINE size_t _arena_calc_reserve_size(arena_size_t max_capacity)
+{
+    return (size_t)_arena_align_up(_arena_calc_chunk_real_size(max_capacity), _arena_get_platform_page_size());
+}
+
+static inline ArenaChunk *_arena_alloc_reserved_chunk(size_t capacity, arena_size_t max_capacity)
+{
+    // reserves address space for max_capacity, commits only first `capacity` bytes
+    size_t reserve_size = _arena_calc_reserve_size(max_capacity);
+    size_t commit_size  = _arena_calc_reserve_size(capacity);
+    if (commit_size > reserve_size) commit_size = reserve_size;
+
+    ArenaChunk *chunk = NULL;
+#if ARENA_PLATFORM == _ARENA_PLATFORM_UNIX
+    chunk = mmap(NULL, reserve_size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (chunk == MAP_FAILED) return NULL;
+    if (mprotect(chunk, commit_size, PROT_READ | PROT_WRITE) != 0) {
+        munmap(chunk, reserve_size);
+        return NULL;
+    }
+#elif (ARENA_PLATFORM == _ARENA_PLATFORM_WIN32)
+    chunk = VirtualAlloc(NULL, reserve_size, MEM_RESERVE, PAGE_NOACCESS);
+    if (!chunk) return NULL;
+    if (!VirtualAlloc(chunk, commit_size, MEM_COMMIT, PAGE_READWRITE)) {
+        VirtualFree(chunk, 0, MEM_RELEASE);
+        return NULL;
+    }
+#else
+    // nothing to reserve with, commit everything
+    commit_size = reserve_size;
+    chunk = malloc(reserve_size);
+    if (!chunk) return NULL;
+#endif
+
+    chunk->next     = NULL;
+    chunk->offset   = 0;
+    chunk->index    = 0;
+    chunk->backing  = ARENA_CHUNK_BACKING_RESERVED;
+    chunk->capacity = _arena_calc_chunk_capacity(commit_size);
+
+    ARENA_LOG("Address space reserved at: %p Reserved: %zu Committed: %zu", chunk, reserve_size, commit_size);
+    return chunk;
+}
+
+static inline bool _arena_commit_reserved_chunk(const Arena *arena, ArenaChunk *chunk, arena_size_t min_capacity)
+{
+    // commits pages in place, at least `growth_factor` bytes at once
+    size_t page_size    = _arena_get_platform_page_size();
+    size_t reserve_size = _arena_calc_reserve_size(arena->max_capacity);
+    size_t old_size     = _arena_calc_chunk_real_size(chunk->capacity);
+    size_t new_size     = _arena_calc_reserve_size(min_capacity);
+    size_t step_size    = (size_t)_arena_align_up(old_size + arena->growth_factor, page_size);
+
+    if (new_size < step_size) new_size = step_size;
+    if (new_size > reserve_size) new_size = reserve_size;
+    if (_arena_calc_chunk_capacity(new_size) < min_capacity) return false;
+
+#if ARENA_PLATFORM == _ARENA_PLATFORM_UNIX
+    if (mprotect((uint8_t*)chunk + old_size, new_size - old_size, PROT_READ | PROT_WRITE) != 0) return false;
+#elif (ARENA_PLATFORM == _ARENA_PLATFORM_WIN32)
+    if (!VirtualAlloc((uint8_t*)chunk + old_size, new_size - old_size, MEM_COMMIT, PAGE_READWRITE)) return false;
+#endif
+
+    chunk->capacity = _arena_calc_chunk_capacity(new_size);
+    ARENA_LOG("Reserved chunk committed up to: %zu bytes", new_size);
+    return true;
+}
+
+static inline void _arena_free_chunk(const Arena *arena, ArenaChunk *chunk)
+{
+    ARENA_LOG("Chunk memory released at: %p", chunk);
+    switch (chunk->backing) {
+    #if ARENA_PLATFORM == _ARENA_PLATFORM_UNIX
+        case ARENA_CHUNK_BACKING_MAPPED: {
+            // chunk may start in the middle of its first page
+            size_t page_size = _arena_get_platform_page_size();
+            arena_ptr_t start = (arena_ptr_t)chunk & ~(arena_ptr_t)(page_size - 1);
+            munmap((void*)start, ((arena_ptr_t)chunk - start) + _arena_calc_chunk_real_size(chunk->capacity));
+        } return;
+
+        case ARENA_CHUNK_BACKING_FILE: {
+            munmap(chunk, _arena_calc_chunk_real_size(chunk->capacity));
+        } return;
+
+        case ARENA_CHUNK_BACKING_SHARED: {
+            ArenaSharedHeader *header = (ArenaSharedHeader*)((uint8_t*)chunk - _arena_get_platform_page_size());
+            munmap(header, header->size);
+        } return;
+    #endif
+        case ARENA_CHUNK_BACKING_RESERVED: {
+        #if ARENA_PLATFORM == _ARENA_PLATFORM_UNIX
+            munmap(chunk, _arena_calc_reserve_size(arena->max_capacity));
+        #elif (ARENA_PLATFORM == _ARENA_PLATFORM_WIN32)
+            VirtualFree(chunk, 0, MEM_RELEASE);
+        #else
+            free(chunk);
+        #endif
+        } return;
+
+        default: break;
+    }
+
+    if (arena->alloc_type == ARENA_ALLOC_TYPE_BIG) {
+    #if (ARENA_PLATFORM == _ARENA_PLATFORM_WIN32)
+        VirtualFree(chunk, 0, MEM_RELEASE);
+    #elif ARENA_PLATFORM == _ARENA_PLATFORM_UNIX
+        munmap(chunk, _arena_calc_chunk_real_size(chunk->capacity));
+    #elif ARENA_PLATFORM == _ARENA_PLATFORM_LIBC
+        free(chunk);
+    #endif
+    } else {
+        free(chunk);
+    }
+}
+
+#if ARENA_PLATFORM == _ARENA_PLATFORM_UNIX
+static inline bool _arena_pwrite_all(int fd, const void *data, size_t size, off_t offset)
+{
+    const uint8_t *p = (const uint8_t*)data;
+    while (size > 0) {
+        ssize_t written = pwrite(fd, p, size, offset);
+        if (written <= 0) return false;
+        p += written; size -= (size_t)written; offset += written;
+    }
+    return true;
+}
+
+static inline bool _arena_pread_all(int fd, void *data, size_t size, off_t offset)
+{
+    uint8_t *p = (uint8_t*)data;
+    while (size > 0) {
+        ssize_t got = pread(fd, p, size, offset);
+        if (got <= 0) return false;
+        p += got; size -= (size_t)got; offset += got;
+    }
+    return true;
+}
+
+static inline ArenaSnapshotHeader _arena_file_header(const Arena *arena, uint64_t magic)
+{
+    return (ArenaSnapshotHeader){
+        .magic             = magic,
+        .version           = ARENA_SNAPSHOT_VERSION,
+        .chunk_count       = arena->chunk_count,
+        .page_size         = _arena_get_platform_page_size(),
+        .head_address      = (uint64_t)(arena_ptr_t)arena->head_chunk,
+        .max_capacity      = arena->max_capacity,
+        .growth_factor     = arena->growth_factor,
+        .epoch             = arena->epoch,
+        .growth_contract   = arena->growth_contract,
+        .flags             = arena->flags,
+        .alloc_type        = arena->alloc_type,
+        .chunk_header_size = sizeof(ArenaChunk)
+    };
+}
+
+static inline ArenaChunk *_arena_alloc_file_chunk(Arena *arena, arena_size_t capacity)
+{
+    // appends new page aligned region to arena file and maps it shared
+    size_t page_size   = _arena_get_platform_page_size();
+    size_t region_size = (size_t)_arena_align_up(_arena_calc_chunk_real_size(capacity), page_size);
+    off_t  region      = (off_t)arena->file_size;
+
+    // allocate blocks up front so writes through the mapping can't hit ENOSPC (SIGBUS)
+    if (posix_fallocate(arena->fd, region, (off_t)region_size) != 0 &&
+        ftruncate(arena->fd, region + (off_t)region_size) != 0) {
+        return NULL;
+    }
+
+    ArenaChunk *chunk = mmap(NULL, region_size, PROT_READ | PROT_WRITE, MAP_SHARED, arena->fd, region);
+    if (chunk == MAP_FAILED) return NULL;
+
+    chunk->next     = NULL;
+    chunk->offset   = 0;
+    chunk->index    = 0;
+    chunk->backing  = ARENA_CHUNK_BACKING_FILE;
+    chunk->capacity = _arena_calc_chunk_capacity(region_size);
+
+    arena->file_size += region_size;
+    ARENA_LOG("New file chunk mapped at: %p File offset: %lld Size: %zu", chunk, (long long)region, region_size);
+    return chunk;
+}
+
+static inline bool _arena_file_write_header(Arena *arena)
+{
+    // chunks cached by `arena_restore` are not part of the chain on reopen
+    for (ArenaChunk *chunk = arena->free_chunks; chunk != NULL; chunk = chunk->next) {
+        chunk->index = ARENA_U32_MAX;
+    }
+
+    ArenaSnapshotHeader header = _arena_file_header(arena, ARENA_FILE_MAGIC);
+    return _arena_pwrite_all(arena->fd, &header, sizeof(header), 0);
+}
+#endif
+
+static inline size_t _arena_calc_realloc_size(const Arena *arena, arena_size_t required_chunk_capacity)
+{
+    arena_size_t cur_capacity = arena->last_chunk->capacity; // starting from the current capacity
+
+    while (cur_capacity < required_chunk_capacity && cur_capacity < arena->max_capacity) {
+        // there will be no overflow and no inf loop
+        // because _arena_smul will return mul result or max capacity and loop will break
+        cur_capacity = _arena_smul(cur_capacity, arena->growth_factor, arena->max_capacity);
+    }
+
+    bool overflow = false;
+    size_t realloc_size = _arena_downcast_size(cur_capacity, &overflow);
+    if ((arena->flags & ARENA_FLAG_DEBUG) && overflow == true) {
+        ARENA_LOG("Warning: Overflow catched in `%s` while downcasting. Max system integer size will be returned.", __func__);
+    }
+
+    return _arena_calc_chunk_real_size(realloc_size); // returns real alloc size (chunk metadata + capacity)
+}
+
+static inline ArenaChunk *_arena_realloc(Arena* arena, size_t required_chunk_capacity)
+{
+    ArenaChunk *new_chunk = NULL;
+    ArenaChunk *old_chunk = arena->last_chunk;
+
+    size_t realloc_size = _arena_calc_realloc_size(arena, required_chunk_capacity); // real size of new chunk to realloc
+    size_t free_size    = _arena_calc_chunk_real_size(arena->last_chunk->capacity); // real size of old chunk to free
+    size_t memcpy_size  = free_size; // real size of copiable memory
+    
+    if (old_chunk->backing != ARENA_CHUNK_BACKING_DEFAULT) {
+        // memory is not ours to realloc (e.g. mapped snapshot), move it to regular chunk
+        new_chunk = (ArenaChunk*)_arena_alloc_chunk(_arena_calc_chunk_capacity(realloc_size), arena->alloc_type);
+        if (!new_chunk) return NULL;
+        arena_memcpy(new_chunk, old_chunk, memcpy_size);
+        _arena_free_chunk(arena, old_chunk);
+        new_chunk->backing = ARENA_CHUNK_BACKING_DEFAULT;
+    } else if (arena->alloc_type == ARENA_ALLOC_TYPE_BIG) {
+    #if (ARENA_PLATFORM == _ARENA_PLATFORM_WIN32)
+        new_chunk = (ArenaChunk*)VirtualAlloc(NULL, realloc_size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+        if (!new_chunk) return NULL;
+        arena_memcpy(new_chunk, old_chunk, memcpy_size);
+        VirtualFree(old_chunk, free_size, MEM_RELEASE);
+    #elif ARENA_PLATFORM == _ARENA_PLATFORM_UNIX
+        new_chunk = (ArenaChunk*)mmap(NULL, realloc_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (new_chunk == MAP_FAILED) return NULL;
+        arena_memcpy(new_chunk, old_chunk, memcpy_size);
+        munmap(old_chunk, free_size);
+    #elif ARENA_PLATFORM == _ARENA_PLATFORM_LIBC
+        new_chunk = (ArenaChunk*)realloc(old_chunk, realloc_size);
+        if (!new_chunk) return NULL;
+    #endif
+    } else {
+        new_chunk = (ArenaChunk*)realloc(old_chunk, realloc_size);
+        if (!new_chunk) return NULL;
+    }
+
+    new_chunk->capacity = realloc_size - sizeof(ArenaChunk);
+    arena->reserved     = new_chunk->capacity;
+    arena->head_chunk   = new_chunk;
+    arena->last_chunk   = new_chunk;
+    if (arena->chunks) arena->chunks[0] = new_chunk;
+    // because for realloc contract we store capacity of only one chunk
+    // so `reserved` should be same as new chunk capacity (as we have only one chunk)
+
+    return new_chunk;
+}
+
+static inline size_t _arena_resolve_config(ArenaConfig *config)
+{
+    // returns first chunk capacity
+    if (config->capacity == ARENA_CAPACITY_CHOOSE_FOR_ME_PLS) config->capacity = ARENA_CAPACITY_DEFAULT;
+    config->max_capacity = config->max_capacity ? config->max_capacity : config->capacity;
+
+    // resolve contract
+    switch (config->growth_contract) {
+        case ARENA_GROWTH_CONTRACT_RESERVE: // growth factor is commit step
+        case ARENA_GROWTH_CONTRACT_CHUNKY: {
+            if (config->growth_factor < ARENA_GROWTH_FACTOR_CHUNKY_MIN) config->growth_factor = ARENA_GROWTH_FACTOR_CHUNKY_MIN;
+            if (config->growth_factor > ARENA_GROWTH_FACTOR_CHUNKY_MAX) config->growth_factor = ARENA_GROWTH_FACTOR_CHUNKY_MAX;
+        } break;
+
+        case ARENA_GROWTH_CONTRACT_REALLOC: {
+            if (config->growth_factor > ARENA_GROWTH_FACTOR_REALLOC_8X) config->growth_factor = ARENA_GROWTH_FACTOR_REALLOC_8X;
+            if (config->growth_factor < 2) config->growth_factor = ARENA_GROWTH_FACTOR_REALLOC_2X;
+        } break;
+
+        default: {
+            config->growth_factor = ARENA_GROWTH_FACTOR_NONE;
+        } break;
+    }
+
+    // 32-bit sys check
+    bool overflow = false;
+    size_t alloc_size = _arena_downcast_size(config->capacity, &overflow); // this is very important
+    if (overflow) {
+        // cannot allocate >4GB
+        config->max_capacity = ARENA_CAPACITY_4GB - 1;
+    }
+
+    return alloc_size;
+}
+
+static inline Arena arena_create_ex(ArenaConfig config)
+{
+    size_t alloc_size = _arena_resolve_config(&config);
+    
+    // finnaly allocate memory for arena
+    uint32_t alloc_type = (alloc_size > ARENA_PAGE_ALIGN_THRESHOLD) ? ARENA_ALLOC_TYPE_BIG : ARENA_ALLOC_TYPE_SMALL;
+
+    ArenaChunk *chunk = NULL;
+    if (config.growth_contract == ARENA_GROWTH_CONTRACT_RESERVE) {
+        alloc_type = ARENA_ALLOC_TYPE_BIG;
+        chunk = _arena_alloc_reserved_chunk(alloc_size, config.max_capacity);
+    } else {
+        chunk = _arena_alloc_chunk(alloc_size, alloc_type);
+    }
+    if (!chunk) return ARENA_EMPTY;
+
+    if (config.flags & ARENA_FLAG_FILLZEROES) arena_memset(chunk->base, 0, chunk->capacity);
+    
+    return (Arena){
+        .reserved        = chunk->capacity, // how much memory reserved in total
+        .growth_contract = config.growth_contract,
+        .growth_factor   = config.growth_factor,
+        .max_capacity    = config.max_capacity,
+        .flags           = config.flags,
+        .debug           = (ArenaDebugInfo){0},
+        .alloc_type      = alloc_type,
+        .error           = ARENA_ERROR_NONE,
+        .epoch           = 0,
+        .head_chunk      = chunk,
+        .last_chunk      = chunk,
+        .chunks          = NULL,
+        .chunks_sorted   = NULL,
+        .chunk_count     = 1,
+        .owned_count     = 1,
+        .chunk_capacity  = 0
+    };
+}
+
+static inline ArenaConfig arena_config_create(arena_size_t capacity, arena_size_t max_capacity, ArenaGrowthContract contract, size_t growth_factor, ArenaFlag flags)
+{
+    return (ArenaConfig){
+        .capacity        = capacity,
+        .flags           = flags,
+        .growth_contract = contract,
+        .growth_factor   = growth_factor,
+        .max_capacity    = max_capacity
+    };
+}
+
+static inline Arena arena_create(arena_size_t capacity)
+{
+    return arena_create_ex((ArenaConfig){
+        .capacity        = capacity,
+        .flags           = ARENA_FLAG_NONE,
+        .growth_contract = ARENA_GROWTH_CONTRACT_FIXED,
+        .growth_factor   = ARENA_GROWTH_FACTOR_NONE,
+        .max_capacity    = ARENA_CAPACITY_256MB // i like this number
+    });
+}
+
+/*
+    Chunk directory:
+    - `chunks`        chain order, chunks[i]->index == i, used by handles
+    - `chunks_sorted` every chunk owned by the arena (chain + cache) sorted by address, used by ownership queries
+    Both are allocated on first chunky growth. Until then `head_chunk` is the only chunk
+    and `_arena_chain` / `_arena_owned` point at it as at one element array.
+*/
+_ARENA_FORCE_INLINE ArenaChunk *const *_arena_chain(const Arena *arena)
+{
+    return arena->chunks ? arena->chunks : &arena->head_chunk;
+}
+
+_ARENA_FORCE_INLINE ArenaChunk *const *_arena_owned(const Arena *arena)
+{
+    return arena->chunks_sorted ? arena->chunks_sorted : &arena->head_chunk;
+}
+
+static inline bool _arena_reserve_chunk_dir(Arena *arena)
+{
+    if (arena->chunks && arena->owned_count < arena->chunk_capacity) return true;
+
+    uint32_t new_capacity = arena->chunk_capacity ? arena->chunk_capacity * 2 : 8;
+    if (new_capacity > ARENA_HANDLE_CHUNK_MASK) return false;
+
+    ArenaChunk **chunks = (ArenaChunk**)realloc(arena->chunks, new_capacity * sizeof(*chunks));
+    if (!chunks) return false;
+    if (!arena->chunks) chunks[0] = arena->head_chunk;
+    arena->chunks = chunks;
+
+    ArenaChunk **sorted = (ArenaChunk**)realloc(arena->chunks_sorted, new_capacity * sizeof(*sorted));
+    if (!sorted) return false; // `chunks` is still valid, just bigger than capacity says
+    if (!arena->chunks_sorted) sorted[0] = arena->head_chunk;
+    arena->chunks_sorted = sorted;
+
+    arena->chunk_capacity = new_capacity;
+    return true;
+}
+
+static inline uint32_t _arena_lower_bound_chunk(const Arena *arena, arena_ptr_t address)
+{
+    // index of the first owned chunk that starts above `address`
+    ArenaChunk *const *sorted = _arena_owned(arena);
+    uint32_t lo = 0, hi = arena->owned_count;
+    while (lo < hi) {
+        uint32_t mid = lo + ((hi - lo) >> 1);
+        if ((arena_ptr_t)sorted[mid] <= address) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+static inline void _arena_insert_owned_chunk(Arena *arena, ArenaChunk *chunk)
+{
+    // directory must be reserved
+    uint32_t at = _arena_lower_bound_chunk(arena, (arena_ptr_t)chunk);
+    for (uint32_t i = arena->owned_count; i > at; --i) {
+        arena->chunks_sorted[i] = arena->chunks_sorted[i - 1];
+    }
+    arena->chunks_sorted[at] = chunk;
+    arena->owned_count++;
+}
+
+static inline void _arena_remove_owned_chunk(Arena *arena, ArenaChunk *chunk)
+{
+    if (!arena->chunks_sorted) return;
+    uint32_t at = _arena_lower_bound_chunk(arena, (arena_ptr_t)chunk);
+    if (at == 0 || arena->chunks_sorted[at - 1] != chunk) return;
+    for (uint32_t i = at; i < arena->owned_count; ++i) {
+        arena->chunks_sorted[i - 1] = arena->chunks_sorted[i];
+    }
+    arena->owned_count--;
+}
+
+static inline void _arena_push_chunk(Arena *arena, ArenaChunk *chunk)
+{
+    // appends chunk to the chain, directory must be reserved
+    chunk->index = arena->chunk_count;
+    arena->chunks[arena->chunk_count++] = chunk;
+
+    arena->last_chunk->next = chunk;
+    arena->last_chunk = chunk;
+    arena->reserved += chunk->capacity;
+}
+
+static inline ArenaChunk *_arena_take_free_chunk(Arena *arena, arena_size_t min_capacity)
+{
+    // first fit, cache is short (only chunks dropped by restore live here)
+    for (ArenaChunk **link = &arena->free_chunks; *link != NULL; link = &(*link)->next) {
+        ArenaChunk *chunk = *link;
+        if (chunk->capacity >= min_capacity && arena->reserved + chunk->capacity <= arena->max_capacity) {
+            *link        = chunk->next;
+            chunk->next   = NULL;
+            chunk->offset = 0;
+            ARENA_LOG("Chunk reused from cache at: %p", chunk);
+            return chunk;
+        }
+    }
+    return NULL;
+}
+
+static inline ArenaChunk *_arena_new_chunk(Arena *arena, size_t capacity)
+{
+#if ARENA_PLATFORM == _ARENA_PLATFORM_UNIX
+    if (arena->backing == ARENA_CHUNK_BACKING_FILE) return _arena_alloc_file_chunk(arena, capacity);
+#endif
+    return _arena_alloc_chunk(capacity, arena->alloc_type);
+}
+
+static inline void arena_destroy(Arena *arena)
+{
+    if (!arena || !arena->head_chunk) return;
+
+#if ARENA_PLATFORM == _ARENA_PLATFORM_UNIX
+    if (arena->backing == ARENA_CHUNK_BACKING_FILE) {
+        // keep the file reopenable, data itself is written back by the shared mappings
+        _arena_file_write_header(arena);
+    }
+#endif
+
+    ArenaChunk *const *owned = _arena_owned(arena);
+    for (uint32_t i = 0; i < arena->owned_count; ++i) {
+        _arena_free_chunk(arena, owned[i]);
+    }
+    free(arena->chunks);
+    free(arena->chunks_sorted);
+
+#if ARENA_PLATFORM == _ARENA_PLATFORM_UNIX
+    if (arena->backing == ARENA_CHUNK_BACKING_FILE) close(arena->fd);
+#endif
+
+    arena->backing                 = ARENA_CHUNK_BACKING_DEFAULT;
+    arena->fd                      = 0;
+    arena->file_size               = 0;
+    arena->last_chunk              = NULL;
+    arena->head_chunk              = NULL;
+    arena->free_chunks             = NULL;
+    arena->chunks                  = NULL;
+    arena->chunks_sorted           = NULL;
+    arena->chunk_count             = 0;
+    arena->chunk_capacity          = 0;
+    arena->owned_count             = 0;
+    arena->reserved                = 0;
+    arena->flags                   = 0;
+    arena->growth_contract         = 0;
+    arena->growth_factor           = 0;
+    arena->max_capacity            = 0;
+    arena->alloc_type              = 0;
+    arena->error                   = ARENA_ERROR_NONE;
+    arena->debug.end               = NULL;
+    arena->debug.bytes_lost        = 0;
+    arena->debug.total_allocations = 0;
+
+    ARENA_LOG("Arena destroyed. Platform: %s", arena_platform_str());
+}
+
+static inline ArenaChunk *arena_chunk_of(const Arena *arena, const void *ptr)
+{
+    // O(log n) lookup of the chunk in the chain which memory contains `ptr`
+    if (!arena || !arena->head_chunk || !ptr) return NULL;
+
+    arena_ptr_t address = (arena_ptr_t)ptr;
+    uint32_t at = _arena_lower_bound_chunk(arena, address);
+    if (at == 0) return NULL;
+
+    ArenaChunk *chunk = _arena_owned(arena)[at - 1];
+    if (address < (arena_ptr_t)chunk->base || address >= (arena_ptr_t)chunk->base + chunk->capacity) return NULL;
+
+    // chunks sitting in the cache are owned but not in use
+    if (chunk->index >= arena->chunk_count || _arena_chain(arena)[chunk->index] != chunk) return NULL;
+
+    return chunk;
+}
+
+static inline bool arena_owns(const Arena *arena, const void *ptr)
+{
+    return arena_chunk_of(arena, ptr) != NULL;
+}
+
+static inline ArenaMemory arena_alloc(Arena *arena, arena_size_t size, size_t alignment)
+{
+    void *p = arena_alloc_raw(arena, size, alignment);
+    if (!p) return (ArenaMemory){NULL, NULL,  0, 0, 0};
+    return (ArenaMemory){
+        .chunk     = arena->last_chunk,
+        .data      = p,
+        .size      = size,
+        .offset    = (arena_ptr_t)p - (arena_ptr_t)arena->last_chunk->base,
+        .alignment = alignment,
+        .epoch     = arena->epoch
+    };
+}
+
+static inline void 
+_arena_calc_alloc_data(
+    ArenaChunk *last_chunk, arena_size_t size, 
+    size_t alignment, arena_ptr_t *address, 
+    arena_ptr_t *aligned_address, 
+    arena_size_t *new_offset, arena_size_t *lost_bytes)
+{
+    *address = (arena_ptr_t)last_chunk->base + last_chunk->offset;
+    *aligned_address = (arena_ptr_t)_arena_align_up((*address), alignment);
+    *lost_bytes = (arena_size_t)((*aligned_address) - (*address));
+    *new_offset = ((*aligned_address) - (arena_ptr_t)last_chunk->base) + size;
+}
+
+#if ARENA_PLATFORM == _ARENA_PLATFORM_UNIX
+_ARENA_FORCE_INLINE ArenaSharedHeader *_arena_shared_header(const Arena *arena)
+{
+    return (ArenaSharedHeader*)((uint8_t*)arena->head_chunk - _arena_get_platform_page_size());
+}
+
+static inline void *_arena_alloc_shared(Arena *arena, arena_size_t size, size_t alignment)
+{
+    // other processes bump the same offset, so claim the range with CAS instead of plain store
+    ArenaChunk  *chunk      = arena->head_chunk;
+    arena_ptr_t  base       = (arena_ptr_t)chunk->base;
+    arena_size_t offset     = _ARENA_ATOMIC_LOAD(&chunk->offset);
+    arena_ptr_t  aligned    = 0;
+    arena_size_t new_offset = 0;
+
+    do {
+        aligned    = (arena_ptr_t)_arena_align_up(base + offset, alignment);
+        new_offset = (arena_size_t)(aligned - base) + size;
+        if (new_offset > chunk->capacity || new_offset < offset) {
+            _arena_set_error(arena, ARENA_ERROR_GROWTH_FORBIDDEN);
+            return NULL;
+        }
+    } while (!_ARENA_ATOMIC_CAS(&chunk->offset, &offset, new_offset));
+
+    arena->epoch = _ARENA_ATOMIC_LOAD(&_arena_shared_header(arena)->epoch);
+    _arena_set_error(arena, ARENA_ERROR_NONE);
+    return (void*)aligned;
+}
+#endif
+
+static inline void *arena_alloc_raw(Arena *arena, arena_size_t size, size_t alignment)
+{
+    if (!arena || size == 0) return NULL;
+    if (!_arena_is_pow2(alignment)) {
+        _arena_set_error(arena, ARENA_ERROR_INVALID_ALIGNMENT);
+        return NULL;
+    }
+    // if alignment is forced then every address should be aligned to CPU cache line size
+    if (arena->flags & ARENA_FLAG_ENFORCE_ALIGNMENT)
+        alignment = ARENA_ALIGN_CACHELINE;
+
+#if ARENA_PLATFORM == _ARENA_PLATFORM_UNIX
+    if (arena->flags & ARENA_FLAG_SHARED) return _arena_alloc_shared(arena, size, alignment);
+#endif
+
+    arena_ptr_t  addr         = 0;
+    arena_ptr_t  aligned_addr = 0;
+    arena_size_t lost_bytes   = 0;
+    arena_size_t new_offset   = 0;
+    
+    _arena_calc_alloc_data(arena->last_chunk, size, alignment, &addr, &aligned_addr, &new_offset, &lost_bytes);
+    
+    arena_size_t alloc_size = size + lost_bytes;
+    if (new_offset > arena->last_chunk->capacity) {
+        bool has_grown = arena_grow(arena, alloc_size);
+        if (!has_grown) {
+            ARENA_LOG(
+                "Failed to allocate `%d` bytes on arena (OOM error. Requested: "ARENA_SIZE_FMT", Reserved: "ARENA_SIZE_FMT")",
+                size + lost_bytes, size, arena->reserved
+            );
+            return NULL;
+        }
+        // important recalc after growth !!!
+        _arena_calc_alloc_data(arena->last_chunk, size, alignment, &addr, &aligned_addr, &new_offset, &lost_bytes); 
+    }
+    
+    alloc_size = size + lost_bytes;
+    arena->last_chunk->offset = new_offset;
+    
+    ARENA_LOG(
+        "Allocated `%d` bytes on arena (align = %zu, loss = %d, requested = %d)",
+        alloc_size, alignment, lost_bytes, size
+    );
+    
+    if (arena->flags & ARENA_FLAG_DEBUG) {
+        arena->debug.end        = (void*)((arena_ptr_t)arena->last_chunk->base + new_offset);
+        arena->debug.bytes_lost += lost_bytes;
+        arena->debug.total_allocations++;
+    }
+
+    _arena_set_error(arena, ARENA_ERROR_NONE);
+    return (void*)aligned_addr;
+}
+
+static inline ArenaMemory arena_alloc_zero(Arena *arena, arena_size_t size, size_t alignment)
+{
+    ARENA_LOG("Arena `arena_alloc_zero` called.");
+
+    void *p = arena_alloc_raw(arena, size, alignment);
+    if (!p) return (ArenaMemory){NULL, NULL, 0, 0, 0};
+
+    arena_memset(p, 0, size);
+
+    return (ArenaMemory){
+        .chunk     = arena->last_chunk,
+        .data      = p,
+        .size      = size,
+        .offset    = (arena_ptr_t)p - (arena_ptr_t)arena->last_chunk->base,
+        .alignment = alignment
+    };
+}
+
+static inline bool arena_grow(Arena *arena, arena_size_t min_contiguous_size)
+{
+    if (!arena || min_contiguous_size < (arena->last_chunk->capacity - arena->last_chunk->offset)) return false;
+
+    if (arena->growth_contract == ARENA_GROWTH_CONTRACT_FIXED) {
+        _arena_set_error(arena, ARENA_ERROR_GROWTH_FORBIDDEN);
+        return false;
+    }
+
+    if (min_contiguous_size > arena->max_capacity) {
+        _arena_set_error(arena, ARENA_ERROR_MAX_CAPACITY_REACHED);
+        return false;
+    }
+    
+    switch (arena->growth_contract) {        
+        case ARENA_GROWTH_CONTRACT_RESERVE: {
+            arena_size_t required_capacity = min_contiguous_size + arena->last_chunk->offset;
+            if (required_capacity > arena->max_capacity) {
+                _arena_set_error(arena, ARENA_ERROR_MAX_CAPACITY_REACHED);
+                return false;
+            }
+            if (!_arena_commit_reserved_chunk(arena, arena->last_chunk, required_capacity)) {
+                _arena_set_error(arena, ARENA_ERROR_CHUNK_ALLOC_FAILED);
+                return false;
+            }
+            arena->reserved = arena->last_chunk->capacity;
+        } break;
+
+        case ARENA_GROWTH_CONTRACT_REALLOC: {
+            arena_size_t required_capacity = min_contiguous_size + arena->last_chunk->offset;
+            ArenaChunk *new_chunk = _arena_realloc(arena, required_capacity);
+            if (!new_chunk) {
+                _arena_set_error(arena, ARENA_ERROR_REALLOC_FAILED);
+                return false;
+            }
+            
+            arena->last_chunk = new_chunk;
+
+            ARENA_LOG(
+                "Arena reallocated at: %p\n"
+                "    Capacity:          "ARENA_SIZE_FMT"\n"
+                "    Growth factor:     "ARENA_SIZE_FMT"X\n"
+                "    Required capacity: "ARENA_SIZE_FMT"\n"
+                "    Offset:            "ARENA_SIZE_FMT"\n"
+                "    Base:              %p\n",
+                arena->last_chunk,
+                arena->last_chunk->capacity,
+                arena->growth_factor,
+                required_capacity,
+                arena->last_chunk->offset,
+                arena->last_chunk->base
+            );
+        } break;
+
+        case ARENA_GROWTH_CONTRACT_CHUNKY: {
+            arena_size_t required_capacity = min_contiguous_size;
+            if (!_arena_reserve_chunk_dir(arena)) {
+                _arena_set_error(arena, ARENA_ERROR_CHUNK_ALLOC_FAILED);
+                return false;
+            }
+
+            ArenaChunk *cached_chunk = _arena_take_free_chunk(arena, required_capacity);
+            if (cached_chunk) {
+                _arena_push_chunk(arena, cached_chunk);
+                break;
+            }
+
+            arena_size_t chunk_capacity = arena->growth_factor;
+            if (chunk_capacity < required_capacity) {
+                if (!(arena->flags & ARENA_FLAG_FIXED_CHUNK_SIZE)) {
+                    // add extra bytes to prevent alloc failure due to address alignment
+                    chunk_capacity = _arena_align_up(required_capacity, ARENA_ALIGN_512B);
+                } else {
+                    _arena_set_error(arena, ARENA_ERROR_OOM);
+                    return false;
+                }
+            }
+
+            ARENA_LOG("New chunk capacity: "ARENA_SIZE_FMT, chunk_capacity);
+
+            if (arena->reserved + chunk_capacity > arena->max_capacity) {
+                ARENA_LOG("Failed to allocate new chunk. Max capacity overflow.");
+                _arena_set_error(arena, ARENA_ERROR_OOM);
+                return false;
+            }
+
+            ArenaChunk *chunk = _arena_new_chunk(arena, _arena_downcast_size(chunk_capacity, NULL));
+            if (!chunk) {
+                _arena_set_error(arena, ARENA_ERROR_CHUNK_ALLOC_FAILED);
+                return false;
+            }
+
+            _arena_insert_owned_chunk(arena, chunk);
+            _arena_push_chunk(arena, chunk);
+
+            ARENA_LOG(
+                "New chunk added at: %p\n"
+                "    Capacity:          "ARENA_SIZE_FMT"\n"
+                "    Growth factor:     "ARENA_SIZE_FMT"\n"
+                "    Required capacity: "ARENA_SIZE_FMT"\n"
+                "    Offset:            "ARENA_SIZE_FMT"\n"
+                "    Base:              %p\n",
+                chunk,
+                chunk->capacity,
+                arena->growth_factor,
+                required_capacity,
+                chunk->offset,
+                chunk->base
+            );
+        } break;
+
+        default: return false;
+    }
+
+    if (arena->flags & ARENA_FLAG_RESET_AFTER_GROW) arena_reset(arena); // Bye bye =D
+    
+    return true;
+}
+
+static inline void *arena_memory_resolve(Arena *arena, ArenaMemory *memory)
+{
+    if (!arena || !memory || !arena->head_chunk) return NULL;
+    if (memory->epoch != arena->epoch) {
+        _arena_set_error(arena, ARENA_ERROR_EPOCH_MISMATCH);
+        return NULL;
+    }    
+
+    if (arena->growth_contract == ARENA_GROWTH_CONTRACT_REALLOC) {
+        memory->chunk = arena->head_chunk;
+    }
+
+    memory->data = (void*)((arena_ptr_t)memory->chunk->base + memory->offset);
+    
+    return memory->data;
+}
+
+static inline bool arena_reset(Arena *arena)
+{
+    /*
+    - Invalidates all previous pointers
+    - Does not free the memory
+    - Does not change chunks structure
+    - Literally just resets arena (but with all previously allocated memory)
+    - O(1) =D
+    */
+    if (!arena || !arena->last_chunk) goto reset_failure;
+
+#if ARENA_PLATFORM == _ARENA_PLATFORM_UNIX
+    if (arena->flags & ARENA_FLAG_SHARED) {
+        // epoch first, so handles of other processes go stale before memory is handed out again
+        arena->epoch = _ARENA_ATOMIC_FETCH_ADD(&_arena_shared_header(arena)->epoch, 1) + 1;
+        _ARENA_ATOMIC_STORE(&arena->head_chunk->offset, 0);
+        goto reset_success;
+    }
+#endif
+
+    if (arena->growth_contract == ARENA_GROWTH_CONTRACT_CHUNKY) {
+        ArenaChunk *const *chain = _arena_chain(arena);
+        for (uint32_t i = 0; i < arena->chunk_count; ++i) {
+            ARENA_LOG("Chunk resetted at: %p", chain[i]);
+            chain[i]->offset = 0;
+        }
+        arena->epoch++;
+        goto reset_success;
+    } else {
+        arena->last_chunk->offset = 0;
+        arena->epoch++;
+        goto reset_success;
+    }
+
+reset_failure:
+    ARENA_LOG("Arena reset failed");
+    return false;
+reset_success:
+    ARENA_LOG("Arena reset success");
+    return true;
+}
+
+#ifndef ARENA_USE_STD_STRING
+static inline void *arena_memcpy(void *dst, const void *src, size_t count)
+{
+    void *start = dst;
+    while (count >= 8) { // type cast ol trick
+        *(uint64_t*)start = *(uint64_t*)src;
+        start += 8; src += 8;
+        count -= 8;
+    }
+
+    while (count--) *(uint8_t*)start++ = *(uint8_t*)src++;
+    
+    return dst;
+}
+
+static inline void *arena_memset(void *dst, int value, size_t size)
+{
+    // who said that fast algorithms should look readable?
+    if (!dst || size == 0) return NULL;
+
+    int word = 0;
+    uint64_t pattern64 = (uint8_t)value;
+    
+    if (size >= 0x4000) {
+        word = 8;
+        pattern64 |= (pattern64 << 8);
+        pattern64 |= (pattern64 << 16);
+        pattern64 |= (pattern64 << 32);
+    } else if (size >= 0x1000) {
+        word = 4;
+        pattern64 |= (pattern64 << 8);
+        pattern64 |= (pattern64 << 16);
+    }
+
+    uint8_t *p8 = (uint8_t*)dst;
+    
+    if (word) {
+        size_t offset = (uintptr_t)dst & (word-1);
+        
+        if (offset) {
+            size_t align = word - offset;
+            if (size < align) align = size;
+            for (int i = 0; i < align; ++i) *p8++ = (uint8_t)value;
+            size -= align;
+        }
+
+        if (word == 4) {
+            uint32_t *p32 = (uint32_t*)p8;
+            size_t blocks  = size / word;
+            uint32_t pattern32 = (uint32_t)pattern64;
+
+            while (blocks--) {
+                *p32++ = pattern32;
+            }
+
+            p8 = (uint8_t*)p32;
+            size = size % word;
+        } else if (word == 8) {
+             uint64_t *p64 = (uint64_t*)p8;
+             size_t blocks = size / word;
+
+            while (blocks--) {
+                *p64++ = pattern64;
+            }
+
+            p8 = (uint8_t*)p64;
+            size = size % word;
+        }
+
+        while (size--) {
+            *p8++ = (uint8_t)value;
+        }
+    } else {
+        while (size--) {
+            *p8++ = (uint8_t)value;
+        }
+    }
+
+    return dst;
+}
+
+static inline char *arena_strdup(Arena *arena, const char *src)
+{
+    if (!arena || arena->reserved == 0 || !src) return NULL;
+    void *dst = arena_alloc_raw(arena, arena_strlen(src)+1, alignof(char));
+    if (dst) arena_memcpy(dst, src, arena_strlen(src)+1);
+    return dst;
+}
+
+static inline size_t arena_strlen(const char *str) // USA international debt growth simulator
+{
+    size_t usa_international_debt = 0;
+    while (*str++) {
+        usa_international_debt++;
+    }
+    return usa_international_debt;
+}
+
+#define _ARENA_HAS_ZERO_BYTE(v) (((v) - 0x0101010101010101ull) & ~(v) & 0x8080808080808080ull)
+// 1 nanosec faster on O0, O1 and O2 than arena_strlen (still slower than libc strlen)
+static inline size_t arena_strlen_fast(const char *str)
+{
+    const char *p = str;
+    while ((arena_ptr_t)p & 7) {
+        if (*p == 0) return p - str;
+        p++;
+    }
+
+    const uint64_t *word = (uint64_t*)p;
+    while (1) {
+        uint64_t value = *word;
+        if (_ARENA_HAS_ZERO_BYTE(value)) break;
+        word++;
+    }
+
+    const char *byte = (const char*)word;
+    for (char i = 0; i < 8; ++i) {
+        if (byte[i] == 0) return (byte + i) - str;
+    }
+
+    return 0; // should be unreachable actually
+}
+#endif
+
+_ARENA_FORCE_INLINE long long arena_abs(long long value)
+{
+    long long result;
+    const int mask = value >> sizeof(value) * CHAR_BIT - 1;
+    result = (value ^ mask) - mask;
+    return result;
+}
+
+_ARENA_FORCE_INLINE ArenaMark arena_mark(const Arena *arena)
+{
+    return (ArenaMark){ 
+        .offset   = arena->last_chunk->offset,
+        .epoch    = arena->epoch,
+        .chunk    = arena->last_chunk,
+        .reserved = arena->reserved
+    };
+}
+
+static inline bool arena_restore(Arena *arena, ArenaMark mark, bool poison_memory)
+{
+    /*
+    - Rolls arena back to the exact position of the mark
+    - Marks must be restored in LIFO order (nesting is fine)
+    - Chunks allocated after the mark go to the chunk cache (see `arena_trim`)
+    - O(1) unless `poison_memory` is set
+    */
+    if (!arena || !arena->last_chunk || arena->epoch != mark.epoch) return false;
+
+    // realloc contract moves the only chunk around so the marked pointer may be stale
+    ArenaChunk *chunk = (arena->growth_contract == ARENA_GROWTH_CONTRACT_REALLOC) ? arena->head_chunk : mark.chunk;
+    if (!chunk || mark.offset > chunk->offset) return false;
+
+    if (poison_memory) {
+        arena_memset(chunk->base + mark.offset, _ARENA_POISON_RESET, chunk->offset - mark.offset);
+        ArenaChunk *const *chain = _arena_chain(arena);
+        for (uint32_t i = chunk->index + 1; i < arena->chunk_count; ++i) {
+            arena_memset(chain[i]->base, _ARENA_POISON_RESET, chain[i]->offset);
+        }
+    }
+
+    if (chunk != arena->last_chunk) {
+        arena->last_chunk->next = arena->free_chunks;
+        arena->free_chunks      = chunk->next;
+        chunk->next             = NULL;
+        arena->last_chunk       = chunk;
+        arena->reserved         = mark.reserved;
+        arena->chunk_count      = chunk->index + 1;
+    }
+
+    chunk->offset = mark.offset;
+    return true;
+}
+
+_ARENA_FORCE_INLINE ArenaHandle _arena_handle_make(const Arena *arena, const ArenaChunk *chunk, const void *p)
+{
+    arena_size_t offset = (arena_ptr_t)p - (arena_ptr_t)chunk->base;
+    if (offset > ARENA_HANDLE_OFFSET_MASK) return ARENA_HANDLE_NULL;
+
+    return ((arena->epoch & ARENA_HANDLE_EPOCH_MASK) << (ARENA_HANDLE_OFFSET_BITS + ARENA_HANDLE_CHUNK_BITS))
+         | ((ArenaHandle)(chunk->index + 1) << ARENA_HANDLE_OFFSET_BITS)
+         | offset;
+}
+
+static inline ArenaHandle arena_alloc_handle(Arena *arena, arena_size_t size, size_t alignment)
+{
+    void *p = arena_alloc_raw(arena, size, alignment);
+    if (!p) return ARENA_HANDLE_NULL;
+
+    ArenaHandle handle = _arena_handle_make(arena, arena->last_chunk, p);
+    if (handle == ARENA_HANDLE_NULL) _arena_set_error(arena, ARENA_ERROR_INVALID_HANDLE);
+    return handle;
+}
+
+static inline ArenaHandle arena_handle_of(const Arena *arena, const void *ptr)
+{
+    ArenaChunk *chunk = arena_chunk_of(arena, ptr);
+    return chunk ? _arena_handle_make(arena, chunk, ptr) : ARENA_HANDLE_NULL;
+}
+
+_ARENA_FORCE_INLINE void *arena_handle_resolve(Arena *arena, ArenaHandle handle)
+{
+    if (!arena || handle == ARENA_HANDLE_NULL) return NULL;
+
+#if ARENA_PLATFORM == _ARENA_PLATFORM_UNIX
+    if (arena->flags & ARENA_FLAG_SHARED) arena->epoch = _ARENA_ATOMIC_LOAD(&_arena_shared_header(arena)->epoch);
+#endif
+
+    if (((handle >> (ARENA_HANDLE_OFFSET_BITS + ARENA_HANDLE_CHUNK_BITS)) ^ arena->epoch) & ARENA_HANDLE_EPOCH_MASK) {
+        _arena_set_error(arena, ARENA_ERROR_EPOCH_MISMATCH);
+        return NULL;
+    }
+
+    uint32_t     index  = (uint32_t)((handle >> ARENA_HANDLE_OFFSET_BITS) & ARENA_HANDLE_CHUNK_MASK) - 1;
+    arena_size_t offset = handle & ARENA_HANDLE_OFFSET_MASK;
+    if (index >= arena->chunk_count) {
+        _arena_set_error(arena, ARENA_ERROR_INVALID_HANDLE);
+        return NULL;
+    }
+
+    ArenaChunk *chunk = _arena_chain(arena)[index];
+    if (offset >= chunk->offset) {
+        _arena_set_error(arena, ARENA_ERROR_INVALID_HANDLE); // memory was released by restore
+        return NULL;
+    }
+
+    return chunk->base + offset;
+}
+
+static inline ArenaTemp arena_temp_begin(Arena *arena)
+{
+    return (ArenaTemp){
+        .arena = arena,
+        .mark  = arena_mark(arena)
+    };
+}
+
+static inline bool arena_temp_end(ArenaTemp temp)
+{
+    return arena_restore(temp.arena, temp.mark, false);
+}
+
+static inline void _arena_temp_cleanup(ArenaTemp *temp)
+{
+    arena_temp_end(*temp);
+}
+
+static inline void arena_trim(Arena *arena)
+{
+    // gives chunks cached by `arena_restore` back to the system
+    if (!arena) return;
+    while (arena->free_chunks) {
+        ArenaChunk *chunk = arena->free_chunks;
+        arena->free_chunks = chunk->next;
+        _arena_remove_owned_chunk(arena, chunk);
+        // region of a file chunk stays in the file, `arena_open_file` puts it back to the cache
+        if (chunk->backing == ARENA_CHUNK_BACKING_FILE) chunk->index = ARENA_U32_MAX;
+        _arena_free_chunk(arena, chunk);
+    }
+}
+
+static inline ArenaTable arena_table_create(ArenaConfig config)
+{
+    Arena arena = arena_create_ex(config);
+    if (!arena.head_chunk) return (ArenaTable){0};
+
+    return (ArenaTable){
+        .arena  = arena,
+        .config = config
+    };
+}
+
+static inline void arena_table_destroy(ArenaTable *table)
+{
+    if (!table) return;
+    arena_destroy(&table->arena);
+    free(table->entries);
+    *table = (ArenaTable){0};
+}
+
+_ARENA_FORCE_INLINE ArenaTableEntry *_arena_table_entry(const ArenaTable *table, ArenaRef ref)
+{
+    uint32_t slot = (uint32_t)ref - 1; // NULL ref wraps around and fails the check
+    if (slot >= table->entry_count) return NULL;
+
+    ArenaTableEntry *entry = &table->entries[slot];
+    if (entry->generation != (uint32_t)(ref >> 32) || entry->handle == ARENA_HANDLE_NULL) return NULL;
+
+    return entry;
+}
+
+static inline ArenaRef arena_table_alloc(ArenaTable *table, arena_size_t size, size_t alignment)
+{
+    if (!table || !table->arena.head_chunk) return ARENA_REF_NULL;
+
+    uint32_t slot = 0;
+    if (table->free_slot) {
+        slot = table->free_slot - 1;
+    } else {
+        if (table->entry_count == table->entry_capacity) {
+            uint32_t new_capacity = table->entry_capacity ? table->entry_capacity * 2 : 64;
+            ArenaTableEntry *entries = (ArenaTableEntry*)realloc(table->entries, new_capacity * sizeof(*entries));
+            if (!entries) {
+                _arena_set_error(&table->arena, ARENA_ERROR_OOM);
+                return ARENA_REF_NULL;
+            }
+            table->entries        = entries;
+            table->entry_capacity = new_capacity;
+        }
+        slot = table->entry_count;
+        table->entries[slot] = (ArenaTableEntry){0};
+    }
+
+    ArenaHandle handle = arena_alloc_handle(&table->arena, size, alignment);
+    if (handle == ARENA_HANDLE_NULL) return ARENA_REF_NULL;
+
+    ArenaTableEntry *entry = &table->entries[slot];
+    if (table->free_slot) {
+        table->free_slot = (uint32_t)entry->size;
+    } else {
+        table->entry_count++;
+    }
+
+    entry->handle    = handle;
+    entry->size      = size;
+    entry->alignment = (uint32_t)alignment;
+    table->live_bytes += size;
+
+    return ((ArenaRef)entry->generation << 32) | (slot + 1);
+}
+
+_ARENA_FORCE_INLINE void *arena_table_get(ArenaTable *table, ArenaRef ref)
+{
+    // returned pointer is valid until next `arena_compact`
+    ArenaTableEntry *entry = table ? _arena_table_entry(table, ref) : NULL;
+    return entry ? arena_handle_resolve(&table->arena, entry->handle) : NULL;
+}
+
+static inline bool arena_table_free(ArenaTable *table, ArenaRef ref)
+{
+    ArenaTableEntry *entry = table ? _arena_table_entry(table, ref) : NULL;
+    if (!entry) return false;
+
+    table->live_bytes -= entry->size;
+    table->dead_bytes += entry->size;
+
+    entry->handle = ARENA_HANDLE_NULL;
+    entry->size   = table->free_slot;
+    entry->generation++;
+    table->free_slot = (uint32_t)(entry - table->entries) + 1;
+
+    return true;
+}
+
+static inline double arena_table_fragmentation(const ArenaTable *table)
+{
+    // share of storage occupied by freed objects, use it to decide when to compact
+    if (!table || table->live_bytes + table->dead_bytes == 0) return 0.0;
+    return (double)table->dead_bytes / (double)(table->live_bytes + table->dead_bytes);
+}
+
+static inline bool arena_compact(ArenaTable *table)
+{
+    /*
+    - Copies live objects into fresh dense storage and gives old storage back to the system
+    - Refs stay valid, raw pointers from `arena_table_get` do not
+    - Old storage stays untouched if compaction fails
+    */
+    if (!table || !table->arena.head_chunk) return false;
+
+    arena_size_t required = 0;
+    for (uint32_t i = 0; i < table->entry_count; ++i) {
+        const ArenaTableEntry *entry = &table->entries[i];
+        if (entry->handle != ARENA_HANDLE_NULL) required += entry->size + entry->alignment;
+    }
+
+    ArenaConfig config = table->config;
+    if (required > config.capacity) config.capacity = required;
+    if (config.max_capacity && config.capacity > config.max_capacity) config.max_capacity = config.capacity;
+
+    Arena fresh = arena_create_ex(config);
+    if (!fresh.head_chunk) return false;
+
+    ArenaHandle *moved = (ArenaHandle*)malloc((table->entry_count ? table->entry_count : 1) * sizeof(*moved));
+    if (!moved) {
+        arena_destroy(&fresh);
+        return false;
+    }
+
+    for (uint32_t i = 0; i < table->entry_count; ++i) {
+        const ArenaTableEntry *entry = &table->entries[i];
+        moved[i] = ARENA_HANDLE_NULL;
+        if (entry->handle == ARENA_HANDLE_NULL) continue;
+
+        moved[i] = arena_alloc_handle(&fresh, entry->size, entry->alignment);
+        if (moved[i] == ARENA_HANDLE_NULL) {
+            free(moved);
+            arena_destroy(&fresh);
+            return false;
+        }
+        arena_memcpy(arena_handle_resolve(&fresh, moved[i]), arena_handle_resolve(&table->arena, entry->handle), entry->size);
+    }
+
+    for (uint32_t i = 0; i < table->entry_count; ++i) {
+        if (table->entries[i].handle != ARENA_HANDLE_NULL) table->entries[i].handle = moved[i];
+    }
+    free(moved);
+
+    ARENA_LOG("Table compacted. Live: "ARENA_SIZE_FMT" Released: "ARENA_SIZE_FMT, table->live_bytes, table->arena.reserved - fresh.reserved);
+
+    arena_destroy(&table->arena);
+    table->arena      = fresh;
+    table->dead_bytes = 0;
+
+    return true;
+}
+
+typedef struct _ArenaForward {
+    void *from;
+    void *to;
+} _ArenaForward;
+
+typedef struct _ArenaEvacuation {
+    Arena         *from;
+    Arena         *to;
+    ArenaTraceFn  trace;
+    _ArenaForward *forwards;      // copied objects in copy order, doubles as Cheney scan queue
+    uint32_t      count;
+    uint32_t      capacity;
+    uint32_t      *index;         // open addressing: forward index + 1 by hash of `from` address
+    uint32_t      index_capacity; // power of two
+    bool          failed;
+} _ArenaEvacuation;
+
+_ARENA_FORCE_INLINE uint32_t _arena_ptr_hash(const void *ptr, uint32_t mask)
+{
+    return (uint32_t)((((arena_ptr_t)ptr >> 3) * 0x9E3779B97F4A7C15ull) >> 32) & mask;
+}
+
+static inline bool _arena_evacuation_reserve(_ArenaEvacuation *ev)
+{
+    if (ev->count < ev->capacity) return true;
+
+    uint32_t new_capacity = ev->capacity ? ev->capacity * 2 : 256;
+    _ArenaForward *forwards = (_ArenaForward*)realloc(ev->forwards, new_capacity * sizeof(*forwards));
+    if (!forwards) return false;
+    ev->forwards = forwards;
+    ev->capacity = new_capacity;
+
+    // keep load factor <= 0.5
+    uint32_t *index = (uint32_t*)calloc(new_capacity * 2, sizeof(*index));
+    if (!index) return false;
+    free(ev->index);
+    ev->index          = index;
+    ev->index_capacity = new_capacity * 2;
+
+    uint32_t mask = ev->index_capacity - 1;
+    for (uint32_t i = 0; i < ev->count; ++i) {
+        uint32_t h = _arena_ptr_hash(ev->forwards[i].from, mask);
+        while (ev->index[h]) h = (h + 1) & mask;
+        ev->index[h] = i + 1;
+    }
+    return true;
+}
+
+static inline void *_arena_forward(_ArenaEvacuation *ev, void *object)
+{
+    if (ev->index_capacity) {
+        uint32_t mask = ev->index_capacity - 1;
+        for (uint32_t h = _arena_ptr_hash(object, mask); ev->index[h]; h = (h + 1) & mask) {
+            if (ev->forwards[ev->index[h] - 1].from == object) return ev->forwards[ev->index[h] - 1].to;
+        }
+    }
+
+    if (!_arena_evacuation_reserve(ev)) goto forward_failure;
+
+    arena_size_t size = ev->trace(object, NULL, NULL);
+    void *copy = arena_alloc_raw(ev->to, size, ARENA_ALIGN_DEFAULT);
+    if (!copy) goto forward_failure;
+    arena_memcpy(copy, object, _arena_downcast_size(size, NULL));
+
+    uint32_t mask = ev->index_capacity - 1;
+    uint32_t h = _arena_ptr_hash(object, mask);
+    while (ev->index[h]) h = (h + 1) & mask;
+    ev->index[h] = ev->count + 1;
+    ev->forwards[ev->count++] = (_ArenaForward){ .from = object, .to = copy };
+
+    return copy;
+
+forward_failure:
+    ev->failed = true;
+    return object;
+}
+
+static inline void _arena_evacuate_visit(void **slot, void *ctx)
+{
+    _ArenaEvacuation *ev = (_ArenaEvacuation*)ctx;
+    if (ev->failed || !*slot || !arena_owns(ev->from, *slot)) return;
+    *slot = _arena_forward(ev, *slot);
+}
+
+static inline bool _arena_evacuate(Arena *from, Arena *to, void **roots, size_t root_count, ArenaTraceFn trace, size_t *copied)
+{
+    /*
+    Cheney style copy of everything reachable from `roots` out of `from` into `to`:
+    - roots and pointer fields of the copies are rewritten to new locations
+    - shared objects and cycles are copied once (forwarding table)
+    - pointers that do not belong to `from` are left as is
+    - `from` is not modified, reset it after success to reclaim the garbage
+    - on failure roots are untouched and `to` is restored to where it was
+    */
+    if (!from || !to || !trace || from == to || (root_count && !roots)) return false;
+    if (to->growth_contract == ARENA_GROWTH_CONTRACT_REALLOC) {
+        // copies must not move while their fields are being rewritten
+        _arena_set_error(to, ARENA_ERROR_GROWTH_FORBIDDEN);
+        return false;
+    }
+
+    _ArenaEvacuation ev = {
+        .from  = from,
+        .to    = to,
+        .trace = trace
+    };
+
+    ArenaMark to_mark = arena_mark(to);
+    void **new_roots = (void**)malloc((root_count ? root_count : 1) * sizeof(*new_roots));
+    if (!new_roots) return false;
+
+    for (size_t i = 0; i < root_count; ++i) {
+        new_roots[i] = roots[i];
+        _arena_evacuate_visit(&new_roots[i], &ev);
+    }
+
+    for (uint32_t scan = 0; scan < ev.count && !ev.failed; ++scan) {
+        trace(ev.forwards[scan].to, _arena_evacuate_visit, &ev);
+    }
+
+    if (!ev.failed) {
+        for (size_t i = 0; i < root_count; ++i) roots[i] = new_roots[i];
+        if (copied) *copied = ev.count;
+        ARENA_LOG("Evacuated %u objects.", ev.count);
+    } else {
+        arena_restore(to, to_mark, false);
+        ARENA_LOG("Evacuation failed after %u objects.", ev.count);
+    }
+
+    free(new_roots);
+    free(ev.forwards);
+    free(ev.index);
+
+    return !ev.failed;
+}
+
+static inline bool arena_evacuate(Arena *from, Arena *to, void **roots, size_t root_count, ArenaTraceFn trace)
+{
+    return _arena_evacuate(from, to, roots, root_count, trace, NULL);
+}
+
+static inline arena_size_t arena_used_bytes(const Arena *arena)
+{
+    // bytes taken by allocations in the chain (alignment padding included)
+    if (!arena || !arena->head_chunk) return 0;
+
+    arena_size_t used = 0;
+    ArenaChunk *const *chain = _arena_chain(arena);
+    for (uint32_t i = 0; i < arena->chunk_count; ++i) used += chain[i]->offset;
+    return used;
+}
+
+static inline ArenaGen arena_gen_create(ArenaConfig nursery_config, ArenaConfig tenured_config)
+{
+    tenured_config.growth_contract = ARENA_GROWTH_CONTRACT_CHUNKY;
+
+    Arena nursery = arena_create_ex(nursery_config);
+    if (!nursery.head_chunk) return (ArenaGen){0};
+
+    Arena tenured = arena_create_ex(tenured_config);
+    if (!tenured.head_chunk) {
+        arena_destroy(&nursery);
+        return (ArenaGen){0};
+    }
+
+    return (ArenaGen){
+        .nursery    = nursery,
+        .tenured    = tenured,
+        .cycle_mark = arena_mark(&nursery),
+        .stats      = {0}
+    };
+}
+
+static inline void arena_gen_destroy(ArenaGen *gen)
+{
+    if (!gen) return;
+    arena_destroy(&gen->nursery);
+    arena_destroy(&gen->tenured);
+    *gen = (ArenaGen){0};
+}
+
+_ARENA_FORCE_INLINE void *arena_gen_alloc(ArenaGen *gen, arena_size_t size, size_t alignment)
+{
+    void *p = arena_alloc_raw(&gen->nursery, size, alignment);
+    if (p) gen->stats.cycle_allocated += size;
+    return p;
+}
+
+static inline void *arena_gen_promote(ArenaGen *gen, const void *object, arena_size_t size, size_t alignment)
+{
+    // copies one survivor into tenured arena, pointers inside it are copied as is
+    if (!gen || !object) return NULL;
+
+    void *p = arena_alloc_raw(&gen->tenured, size, alignment);
+    if (!p) return NULL;
+
+    arena_memcpy(p, object, _arena_downcast_size(size, NULL));
+    gen->stats.cycle_promoted += size;
+    gen->stats.promoted_objects++;
+    return p;
+}
+
+static inline bool arena_gen_promote_graph(ArenaGen *gen, void **roots, size_t root_count, ArenaTraceFn trace)
+{
+    // promotes everything reachable from roots, nursery pointers inside survivors are rewritten
+    if (!gen) return false;
+
+    arena_size_t used = arena_used_bytes(&gen->tenured);
+    size_t copied = 0;
+    if (!_arena_evacuate(&gen->nursery, &gen->tenured, roots, root_count, trace, &copied)) return false;
+
+    gen->stats.cycle_promoted   += arena_used_bytes(&gen->tenured) - used;
+    gen->stats.promoted_objects += copied;
+    return true;
+}
+
+static inline void arena_gen_cycle(ArenaGen *gen)
+{
+    /*
+    - Drops everything allocated in nursery during the cycle
+    - Nursery goes back to its first chunk (extra chunks are cached) so next cycle runs over the same warm bytes
+    - Old nursery handles and marks are invalidated
+    */
+    if (!gen || !gen->nursery.head_chunk) return;
+
+    arena_restore(&gen->nursery, gen->cycle_mark, false);
+    gen->nursery.epoch++;
+    gen->cycle_mark = arena_mark(&gen->nursery);
+
+    gen->stats.allocated_bytes += gen->stats.cycle_allocated;
+    gen->stats.promoted_bytes  += gen->stats.cycle_promoted;
+    gen->stats.cycle_allocated  = 0;
+    gen->stats.cycle_promoted   = 0;
+    gen->stats.cycles++;
+}
+
+static inline double arena_gen_survival_rate(const ArenaGen *gen)
+{
+    // promoted / allocated over finished cycles
+    if (!gen || gen->stats.allocated_bytes == 0) return 0.0;
+    return (double)gen->stats.promoted_bytes / (double)gen->stats.allocated_bytes;
+}
+
+_ARENA_FORCE_INLINE void *arena_relptr32_get(const ArenaRelPtr32 *rel)
+{
+    return rel->offset ? (void*)((intptr_t)rel + rel->offset) : NULL;
+}
+
+_ARENA_FORCE_INLINE bool arena_relptr32_set(ArenaRelPtr32 *rel, const void *target)
+{
+    // false if target is further than 2GB away, field is left untouched then
+    intptr_t distance = target ? (intptr_t)target - (intptr_t)rel : 0;
+    if (distance < INT32_MIN || distance > INT32_MAX) return false;
+    rel->offset = (int32_t)distance;
+    return true;
+}
+
+_ARENA_FORCE_INLINE void *arena_relptr64_get(const ArenaRelPtr64 *rel)
+{
+    return rel->offset ? (void*)((intptr_t)rel + (intptr_t)rel->offset) : NULL;
+}
+
+_ARENA_FORCE_INLINE bool arena_relptr64_set(ArenaRelPtr64 *rel, const void *target)
+{
+    rel->offset = target ? (int64_t)((intptr_t)target - (intptr_t)rel) : 0;
+    return true;
+}
+
+_ARENA_FORCE_INLINE ArenaCPtr arena_cptr_encode(const Arena *arena, const void *ptr)
+{
+    // relative to chunk header, so the first object is never 0
+    return ptr ? (ArenaCPtr)(((arena_ptr_t)ptr - (arena_ptr_t)arena->head_chunk) >> ARENA_CPTR_SHIFT) : ARENA_CPTR_NULL;
+}
+
+_ARENA_FORCE_INLINE void *arena_cptr_decode(const Arena *arena, ArenaCPtr cptr)
+{
+    return cptr ? (void*)((arena_ptr_t)arena->head_chunk + ((arena_ptr_t)cptr << ARENA_CPTR_SHIFT)) : NULL;
+}
+
+#if ARENA_PLATFORM == _ARENA_PLATFORM_UNIX
+static inline int _arena_memfd_create(const char *name)
+{
+    #if defined(__linux__) && defined(SYS_memfd_create)
+    int memfd = (int)syscall(SYS_memfd_create, name, 0x1u /* MFD_CLOEXEC */);
+    if (memfd >= 0) return memfd;
+    #endif
+
+    // no memfd here, fallback to unlinked POSIX shared memory object named "/<name>-<pid>-<counter>"
+    static uint32_t counter = 0;
+    char shm_name[64] = { '/' };
+    size_t len = 1;
+    while (*name && len < 32) shm_name[len++] = *name++;
+
+    uint64_t tags[2] = { (uint64_t)getpid(), (uint64_t)counter++ };
+    for (int t = 0; t < 2; ++t) {
+        shm_name[len++] = '-';
+        for (int shift = 60; shift >= 0; shift -= 4) {
+            shm_name[len++] = "0123456789abcdef"[(tags[t] >> shift) & 0xF];
+        }
+    }
+    shm_name[len] = '\0';
+
+    int fd = shm_open(shm_name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd >= 0) shm_unlink(shm_name);
+    return fd;
+}
+
+static inline ArenaRing arena_ring_create(arena_size_t capacity)
+{
+    /*
+        Same pages are mapped twice back to back:
+        [ view 0 | view 1 ] - byte at `base + capacity + i` is byte at `base + i`
+        so a record that crosses the end of view 0 is still one contiguous span.
+    */
+    size_t page_size = _arena_get_platform_page_size();
+
+    if (capacity == ARENA_CAPACITY_CHOOSE_FOR_ME_PLS) capacity = ARENA_CAPACITY_DEFAULT;
+    capacity = _arena_align_up(capacity, page_size);
+
+    bool overflow = false;
+    size_t view_size = _arena_downcast_size(capacity, &overflow);
+    if (overflow || view_size > ARENA_SIZE_MAX / 2) return (ArenaRing){ .error = ARENA_ERROR_INVALID_CAPACITY };
+
+    int fd = _arena_memfd_create("arena_ring");
+    if (fd < 0) goto exit_error;
+
+    if (ftruncate(fd, (off_t)view_size) != 0) {
+        close(fd);
+        goto exit_error;
+    }
+
+    uint8_t *base = mmap(NULL, view_size * 2, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) {
+        close(fd);
+        goto exit_error;
+    }
+
+    void *view0 = mmap(base,             view_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0);
+    void *view1 = mmap(base + view_size, view_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0);
+    close(fd); // mappings keep the pages alive
+
+    if (view0 != base || view1 != base + view_size) {
+        munmap(base, view_size * 2);
+        goto exit_error;
+    }
+
+    ARENA_LOG("Ring created at: %p Capacity: "ARENA_SIZE_FMT, base, capacity);
+
+    return (ArenaRing){
+        .base     = base,
+        .capacity = capacity,
+        .head     = 0,
+        .write    = 0,
+        .tail     = 0,
+        .error    = ARENA_ERROR_NONE
+    };
+
+exit_error:
+    ARENA_LOG("Failed to create ring.");
+    return (ArenaRing){ .error = ARENA_ERROR_MAPPING_FAILED };
+}
+
+static inline void arena_ring_destroy(ArenaRing *ring)
+{
+    if (!ring || !ring->base) return;
+    munmap(ring->base, _arena_downcast_size(ring->capacity * 2, NULL));
+    *ring = ARENA_RING_EMPTY;
+}
+
+static inline void *arena_ring_alloc(ArenaRing *ring, arena_size_t size, size_t alignment)
+{
+    /*
+        Producer side. Bytes are not visible to the consumer until `arena_ring_commit`,
+        so one producer and one consumer may work on the ring from different threads.
+    */
+    if (!ring || !ring->base || size == 0) return NULL;
+    if (!_arena_is_pow2(alignment) || alignment > _arena_get_platform_page_size()) {
+        ring->error = ARENA_ERROR_INVALID_ALIGNMENT;
+        return NULL;
+    }
+
+    arena_size_t tail         = _ARENA_ATOMIC_LOAD(&ring->tail);
+    arena_ptr_t  address      = (arena_ptr_t)ring->base + (ring->write % ring->capacity);
+    arena_ptr_t  aligned_addr = (arena_ptr_t)_arena_align_up(address, alignment);
+    arena_size_t new_write    = ring->write + (aligned_addr - address) + size;
+
+    if (new_write - tail > ring->capacity) {
+        ring->error = ARENA_ERROR_RING_FULL;
+        return NULL;
+    }
+
+    ring->write = new_write;
+    ring->error = ARENA_ERROR_NONE;
+    return (void*)aligned_addr;
+}
+
+static inline void arena_ring_commit(ArenaRing *ring)
+{
+    if (!ring) return;
+    _ARENA_ATOMIC_STORE(&ring->head, ring->write);
+}
+
+static inline void *arena_ring_peek(const ArenaRing *ring, arena_size_t *available)
+{
+    /*
+        Consumer side. Returns oldest unreleased byte and how many bytes
+        after it are readable as one span (never crosses the mirror end).
+    */
+    if (available) *available = 0;
+    if (!ring || !ring->base) return NULL;
+
+    arena_size_t head = _ARENA_ATOMIC_LOAD(&ring->head);
+    if (available) *available = head - ring->tail;
+
+    return ring->base + (ring->tail % ring->capacity);
+}
+
+static inline bool arena_ring_release(ArenaRing *ring, arena_size_t size)
+{
+    if (!ring || !ring->base) return false;
+
+    arena_size_t head = _ARENA_ATOMIC_LOAD(&ring->head);
+    if (size > head - ring->tail) return false;
+
+    _ARENA_ATOMIC_STORE(&ring->tail, ring->tail + size);
+    return true;
+}
+
+static inline bool arena_ring_release_to(ArenaRing *ring, const void *end)
+{
+    // releases everything before `end` (e.g. end of consumed record, including alignment padding before it)
+    if (!ring || !ring->base) return false;
+
+    arena_ptr_t tail_address = (arena_ptr_t)ring->base + (ring->tail % ring->capacity);
+    if ((arena_ptr_t)end < tail_address) return false;
+
+    return arena_ring_release(ring, (arena_ptr_t)end - tail_address);
+}
+_ARENA_FORCE_INLINE size_t _arena_snapshot_region_size(arena_ptr_t chunk_address, arena_size_t capacity, size_t page_size)
+{
+    size_t in_page = (size_t)(chunk_address & (page_size - 1));
+    return (size_t)_arena_align_up(in_page + _arena_calc_chunk_real_size(capacity), page_size);
+}
+
+static inline ArenaError arena_snapshot_write(const Arena *arena, const char *path)
+{
+    /*
+    - Persists chain chunks with metadata (chunk cache is not persisted)
+    - Only used bytes are written, rest of every chunk is a file hole
+    */
+    if (!arena || !arena->head_chunk || !path) return ARENA_ERROR_SNAPSHOT_INVALID;
+
+    size_t page_size = _arena_get_platform_page_size();
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return ARENA_ERROR_IO;
+
+    ArenaSnapshotHeader header = _arena_file_header(arena, ARENA_SNAPSHOT_MAGIC);
+
+    bool ok = _arena_pwrite_all(fd, &header, sizeof(header), 0);
+
+    off_t region = (off_t)page_size;
+    ArenaChunk *const *chain = _arena_chain(arena);
+    for (uint32_t i = 0; ok && i < arena->chunk_count; ++i) {
+        const ArenaChunk *chunk = chain[i];
+        arena_ptr_t address = (arena_ptr_t)chunk;
+        off_t image = region + (off_t)(address & (page_size - 1));
+
+        ok = _arena_pwrite_all(fd, chunk, sizeof(ArenaChunk) + _arena_downcast_size(chunk->offset, NULL), image);
+        region += (off_t)_arena_snapshot_region_size(address, chunk->capacity, page_size);
+    }
+
+    if (ok) ok = ftruncate(fd, region) == 0;
+    if (close(fd) != 0) ok = false;
+
+    ARENA_LOG("Snapshot written to `%s`. Chunks: %u Size: %lld", path, arena->chunk_count, (long long)region);
+    return ok ? ARENA_ERROR_NONE : ARENA_ERROR_IO;
+}
+
+static inline Arena arena_snapshot_map(const char *path)
+{
+    /*
+    - Maps chunks back privately (copy-on-write, file is never modified)
+    - Tries original addresses first, so raw pointers inside the arena stay valid
+    - If any chunk could not be placed at its address, arena is still usable but
+      `error` is ARENA_ERROR_SNAPSHOT_RELOCATED (handles and offsets work, raw pointers do not)
+    - Failure returns empty arena with `error` set
+    */
+    ArenaError error = ARENA_ERROR_NONE;
+    size_t page_size = _arena_get_platform_page_size();
+
+    int fd = path ? open(path, O_RDONLY) : -1;
+    if (fd < 0) return (Arena){ .error = ARENA_ERROR_IO };
+
+    ArenaSnapshotHeader header;
+    if (!_arena_pread_all(fd, &header, sizeof(header), 0)) {
+        close(fd);
+        return (Arena){ .error = ARENA_ERROR_IO };
+    }
+
+    if (header.magic != ARENA_SNAPSHOT_MAGIC || header.version != ARENA_SNAPSHOT_VERSION ||
+        header.page_size != page_size || header.chunk_header_size != sizeof(ArenaChunk) ||
+        header.chunk_count == 0 || header.chunk_count > ARENA_HANDLE_CHUNK_MASK) {
+        close(fd);
+        return (Arena){ .error = ARENA_ERROR_SNAPSHOT_INVALID };
+    }
+
+    Arena arena = {
+        .max_capacity    = header.max_capacity,
+        .growth_factor   = header.growth_factor,
+        .growth_contract = (ArenaGrowthContract)header.growth_contract,
+        .flags           = (ArenaFlag)header.flags,
+        .alloc_type      = header.alloc_type,
+        .epoch           = header.epoch,
+        .error           = ARENA_ERROR_NONE
+    };
+
+    off_t region = (off_t)page_size;
+    arena_ptr_t address = (arena_ptr_t)header.head_address;
+    for (uint32_t i = 0; i < header.chunk_count; ++i) {
+        ArenaChunk image;
+        size_t in_page = (size_t)(address & (page_size - 1));
+        if (!_arena_pread_all(fd, &image, sizeof(image), region + (off_t)in_page) || image.index != i) {
+            error = ARENA_ERROR_SNAPSHOT_INVALID;
+            goto exit_error;
+        }
+
+        size_t region_size = _arena_snapshot_region_size(address, image.capacity, page_size);
+        void *want = (void*)(address - in_page);
+        uint8_t *mapping = mmap(want, region_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED_NOREPLACE, fd, region);
+        if (mapping != MAP_FAILED && mapping != want) {
+            munmap(mapping, region_size);
+            mapping = MAP_FAILED;
+        }
+        if (mapping == MAP_FAILED) {
+            mapping = mmap(NULL, region_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, region);
+            if (mapping == MAP_FAILED) {
+                error = ARENA_ERROR_MAPPING_FAILED;
+                goto exit_error;
+            }
+            arena.error = ARENA_ERROR_SNAPSHOT_RELOCATED;
+        }
+
+        ArenaChunk *chunk = (ArenaChunk*)(mapping + in_page);
+        address = (arena_ptr_t)chunk->next; // original address of the next chunk
+        chunk->next    = NULL;
+        chunk->backing = ARENA_CHUNK_BACKING_MAPPED;
+
+        if (i == 0) {
+            arena.head_chunk  = chunk;
+            arena.last_chunk  = chunk;
+            arena.reserved    = chunk->capacity;
+            arena.chunk_count = 1;
+            arena.owned_count = 1;
+        } else {
+            if (!_arena_reserve_chunk_dir(&arena)) {
+                _arena_free_chunk(&arena, chunk);
+                error = ARENA_ERROR_OOM;
+                goto exit_error;
+            }
+            _arena_insert_owned_chunk(&arena, chunk);
+            _arena_push_chunk(&arena, chunk);
+        }
+
+        region += (off_t)region_size;
+    }
+
+    close(fd);
+    ARENA_LOG("Snapshot mapped from `%s`. Chunks: %u Relocated: %d", path, header.chunk_count, arena.error == ARENA_ERROR_SNAPSHOT_RELOCATED);
+    return arena;
+
+exit_error:
+    close(fd);
+    arena_destroy(&arena);
+    return (Arena){ .error = error };
+}
+
+static inline Arena arena_create_file(const char *path, ArenaConfig config)
+{
+    /*
+    - Every chunk is a page aligned region of the file mapped MAP_SHARED, data survives the process
+    - Page 0 holds the header, chunk regions follow in allocation order
+    - Chunks land at different addresses after `arena_open_file`, store handles or offsets, not raw pointers
+    - Realloc contract would move the head chunk, only fixed and chunky arenas can be file backed
+    - File never shrinks, trimmed chunks stay in it and come back as cached chunks
+    */
+    if (config.growth_contract == ARENA_GROWTH_CONTRACT_REALLOC) return (Arena){ .error = ARENA_ERROR_GROWTH_FORBIDDEN };
+
+    size_t capacity = _arena_resolve_config(&config);
+    int fd = path ? open(path, O_RDWR | O_CREAT | O_TRUNC, 0644) : -1;
+    if (fd < 0) return (Arena){ .error = ARENA_ERROR_IO };
+
+    Arena arena = {
+        .growth_contract = config.growth_contract,
+        .growth_factor   = config.growth_factor,
+        .max_capacity    = config.max_capacity,
+        .flags           = config.flags,
+        .alloc_type      = ARENA_ALLOC_TYPE_BIG,
+        .error           = ARENA_ERROR_NONE,
+        .backing         = ARENA_CHUNK_BACKING_FILE,
+        .fd              = fd,
+        .file_size       = _arena_get_platform_page_size()
+    };
+
+    ArenaChunk *chunk = _arena_alloc_file_chunk(&arena, capacity);
+    if (!chunk) {
+        close(fd);
+        return (Arena){ .error = ARENA_ERROR_MAPPING_FAILED };
+    }
+
+    arena.head_chunk  = chunk;
+    arena.last_chunk  = chunk;
+    arena.reserved    = chunk->capacity;
+    arena.chunk_count = 1;
+    arena.owned_count = 1;
+
+    if (!_arena_file_write_header(&arena)) {
+        arena_destroy(&arena);
+        return (Arena){ .error = ARENA_ERROR_IO };
+    }
+
+    ARENA_LOG("File arena created at `%s`. Capacity: "ARENA_SIZE_FMT, path, arena.reserved);
+    return arena;
+}
+
+static inline Arena arena_open_file(const char *path)
+{
+    /*
+    - Maps every chunk region of a file created by `arena_create_file` back MAP_SHARED
+    - Chain is rebuilt from chunk indices, regions outside of the chain become cached chunks
+    - Epoch is persisted, handles from previous sessions resolve
+    - Failure returns empty arena with `error` set
+    */
+    ArenaError error = ARENA_ERROR_NONE;
+    size_t page_size = _arena_get_platform_page_size();
+
+    int fd = path ? open(path, O_RDWR) : -1;
+    if (fd < 0) return (Arena){ .error = ARENA_ERROR_IO };
+
+    ArenaSnapshotHeader header;
+    off_t file_size = lseek(fd, 0, SEEK_END);
+    if (file_size < 0 || !_arena_pread_all(fd, &header, sizeof(header), 0)) {
+        close(fd);
+        return (Arena){ .error = ARENA_ERROR_IO };
+    }
+
+    if (header.magic != ARENA_FILE_MAGIC || header.version != ARENA_SNAPSHOT_VERSION ||
+        header.page_size != page_size || header.chunk_header_size != sizeof(ArenaChunk) ||
+        header.growth_contract == ARENA_GROWTH_CONTRACT_REALLOC ||
+        header.chunk_count == 0 || header.chunk_count > ARENA_HANDLE_CHUNK_MASK) {
+        close(fd);
+        return (Arena){ .error = ARENA_ERROR_SNAPSHOT_INVALID };
+    }
+
+    ArenaChunk **chain = (ArenaChunk**)calloc(header.chunk_count, sizeof(*chain));
+    if (!chain) {
+        close(fd);
+        return (Arena){ .error = ARENA_ERROR_OOM };
+    }
+
+    Arena arena = {
+        .max_capacity    = header.max_capacity,
+        .growth_factor   = header.growth_factor,
+        .growth_contract = (ArenaGrowthContract)header.growth_contract,
+        .flags           = (ArenaFlag)header.flags,
+        .alloc_type      = ARENA_ALLOC_TYPE_BIG,
+        .epoch           = header.epoch,
+        .error           = ARENA_ERROR_NONE,
+        .backing         = ARENA_CHUNK_BACKING_FILE,
+        .fd              = fd
+    };
+
+    ArenaChunk *cached = NULL;
+    off_t region = (off_t)page_size;
+    while (region < file_size) {
+        ArenaChunk image;
+        if (!_arena_pread_all(fd, &image, sizeof(image), region) || image.backing != ARENA_CHUNK_BACKING_FILE) {
+            error = ARENA_ERROR_SNAPSHOT_INVALID;
+            goto exit_error;
+        }
+
+        size_t region_size = (size_t)_arena_align_up(_arena_calc_chunk_real_size(image.capacity), page_size);
+        if (region_size > (size_t)(file_size - region)) {
+            error = ARENA_ERROR_SNAPSHOT_INVALID;
+            goto exit_error;
+        }
+
+        ArenaChunk *chunk = mmap(NULL, region_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, region);
+        if (chunk == MAP_FAILED) {
+            error = ARENA_ERROR_MAPPING_FAILED;
+            goto exit_error;
+        }
+
+        chunk->next = NULL;
+        if (chunk->index < header.chunk_count && !chain[chunk->index]) {
+            chain[chunk->index] = chunk;
+        } else {
+            chunk->index = ARENA_U32_MAX;
+            chunk->next  = cached;
+            cached       = chunk;
+        }
+
+        region += (off_t)region_size;
+    }
+    arena.file_size = (arena_size_t)region;
+
+    for (uint32_t i = 0; i < header.chunk_count; ++i) {
+        if (!chain[i]) {
+            error = ARENA_ERROR_SNAPSHOT_INVALID;
+            goto exit_error;
+        }
+    }
+
+    // rebuild directory, from here on `arena_destroy` owns every chunk it has seen
+    arena.head_chunk  = chain[0];
+    arena.last_chunk  = chain[0];
+    arena.reserved    = chain[0]->capacity;
+    arena.chunk_count = 1;
+    arena.owned_count = 1;
+    chain[0] = NULL;
+
+    for (uint32_t i = 1; i < header.chunk_count; ++i) {
+        if (!_arena_reserve_chunk_dir(&arena)) {
+            error = ARENA_ERROR_OOM;
+            goto exit_error;
+        }
+        _arena_insert_owned_chunk(&arena, chain[i]);
+        _arena_push_chunk(&arena, chain[i]);
+        chain[i] = NULL;
+    }
+
+    while (cached) {
+        if (!_arena_reserve_chunk_dir(&arena)) {
+            error = ARENA_ERROR_OOM;
+            goto exit_error;
+        }
+        ArenaChunk *chunk = cached;
+        cached = chunk->next;
+        _arena_insert_owned_chunk(&arena, chunk);
+        chunk->next = arena.free_chunks;
+        arena.free_chunks = chunk;
+    }
+
+    free(chain);
+    ARENA_LOG("File arena opened from `%s`. Chunks: %u Owned: %u", path, arena.chunk_count, arena.owned_count);
+    return arena;
+
+exit_error:
+    for (uint32_t i = 0; i < header.chunk_count; ++i) {
+        if (chain[i]) _arena_free_chunk(&arena, chain[i]);
+    }
+    while (cached) {
+        ArenaChunk *chunk = cached;
+        cached = chunk->next;
+        _arena_free_chunk(&arena, chunk);
+    }
+    free(chain);
+
+    if (arena.head_chunk) {
+        arena.backing = ARENA_CHUNK_BACKING_DEFAULT; // don't touch the header of a file we failed to open
+        arena_destroy(&arena);
+    }
+    close(fd);
+    return (Arena){ .error = error };
+}
+
+static inline bool arena_sync(Arena *arena)
+{
+    // writes header and flushes every chunk of a file backed arena to disk
+    if (!arena || !arena->head_chunk || arena->backing != ARENA_CHUNK_BACKING_FILE) return false;
+
+    bool ok = _arena_file_write_header(arena);
+
+    ArenaChunk *const *owned = _arena_owned(arena);
+    for (uint32_t i = 0; ok && i < arena->owned_count; ++i) {
+        ArenaChunk *chunk = owned[i];
+        ok = msync(chunk, _arena_calc_chunk_real_size(chunk->capacity), MS_SYNC) == 0;
+    }
+    if (ok) ok = fsync(arena->fd) == 0;
+
+    if (!ok) _arena_set_error(arena, ARENA_ERROR_IO);
+    return ok;
+}
+
+static inline Arena _arena_map_shared(int fd, size_t size)
+{
+    // maps header page + chunk, both processes see the same chunk header (offset) and epoch
+    uint8_t *mapping = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) return (Arena){ .error = ARENA_ERROR_MAPPING_FAILED };
+
+    ArenaChunk *chunk = (ArenaChunk*)(mapping + _arena_get_platform_page_size());
+    return (Arena){
+        .reserved        = chunk->capacity,
+        .growth_contract = ARENA_GROWTH_CONTRACT_FIXED,
+        .growth_factor   = ARENA_GROWTH_FACTOR_NONE,
+        .max_capacity    = chunk->capacity,
+        .flags           = ARENA_FLAG_SHARED,
+        .alloc_type      = ARENA_ALLOC_TYPE_BIG,
+        .error           = ARENA_ERROR_NONE,
+        .epoch           = _ARENA_ATOMIC_LOAD(&((ArenaSharedHeader*)mapping)->epoch),
+        .head_chunk      = chunk,
+        .last_chunk      = chunk,
+        .chunk_count     = 1,
+        .owned_count     = 1
+    };
+}
+
+static inline Arena arena_create_shared(const char *name, ArenaConfig config)
+{
+    /*
+    - Single fixed chunk in a shared memory object (`shm_open` with `name`, or anonymous memfd
+      shared only with children forked after creation when `name` is NULL)
+    - Any process may allocate, offset is claimed with CAS so allocations never overlap
+    - `arena_reset` from any process bumps the shared epoch, handles made before it stop resolving
+    - Chunks land at different addresses in every process, pass handles or offsets, not raw pointers
+    - Restore is not coordinated between processes, use reset
+    */
+    if (config.growth_contract != ARENA_GROWTH_CONTRACT_FIXED) return (Arena){ .error = ARENA_ERROR_GROWTH_FORBIDDEN };
+
+    size_t page_size = _arena_get_platform_page_size();
+    size_t capacity  = _arena_resolve_config(&config);
+    size_t size      = page_size + (size_t)_arena_align_up(_arena_calc_chunk_real_size(capacity), page_size);
+
+    int fd = name ? shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600) : _arena_memfd_create("arena_shared");
+    if (fd < 0) return (Arena){ .error = ARENA_ERROR_IO };
+    if (ftruncate(fd, (off_t)size) != 0) {
+        close(fd);
+        if (name) shm_unlink(name);
+        return (Arena){ .error = ARENA_ERROR_IO };
+    }
+
+    Arena arena = _arena_map_shared(fd, size);
+    if (!arena.head_chunk) {
+        if (name) shm_unlink(name);
+        return arena;
+    }
+
+    ArenaChunk *chunk = arena.head_chunk;
+    chunk->next     = NULL;
+    chunk->offset   = 0;
+    chunk->index    = 0;
+    chunk->backing  = ARENA_CHUNK_BACKING_SHARED;
+    chunk->capacity = _arena_calc_chunk_capacity(size - page_size);
+    arena.reserved     = chunk->capacity;
+    arena.max_capacity = chunk->capacity;
+    arena.flags        = (ArenaFlag)(config.flags | ARENA_FLAG_SHARED);
+
+    ArenaSharedHeader *header = _arena_shared_header(&arena);
+    header->version   = ARENA_SHARED_VERSION;
+    header->page_size = (uint32_t)page_size;
+    header->size      = size;
+    header->epoch     = 0;
+    _ARENA_ATOMIC_STORE(&header->magic, ARENA_SHARED_MAGIC); // publish
+
+    ARENA_LOG("Shared arena created `%s`. Capacity: "ARENA_SIZE_FMT, name ? name : "(anonymous)", chunk->capacity);
+    return arena;
+}
+
+static inline Arena arena_attach_shared(const char *name)
+{
+    // maps arena created by `arena_create_shared` in another process, detach with `arena_destroy`
+    int fd = name ? shm_open(name, O_RDWR, 0600) : -1;
+    if (fd < 0) return (Arena){ .error = ARENA_ERROR_IO };
+
+    ArenaSharedHeader header;
+    if (!_arena_pread_all(fd, &header, sizeof(header), 0)) {
+        close(fd);
+        return (Arena){ .error = ARENA_ERROR_SHARED_INVALID }; // creator has not sized it yet
+    }
+
+    size_t page_size = _arena_get_platform_page_size();
+    if (header.magic != ARENA_SHARED_MAGIC || header.version != ARENA_SHARED_VERSION ||
+        header.page_size != page_size || header.size <= page_size + sizeof(ArenaChunk)) {
+        close(fd);
+        return (Arena){ .error = ARENA_ERROR_SHARED_INVALID };
+    }
+
+    Arena arena = _arena_map_shared(fd, header.size);
+    if (arena.head_chunk && arena.head_chunk->backing != ARENA_CHUNK_BACKING_SHARED) {
+        munmap(_arena_shared_header(&arena), header.size);
+        return (Arena){ .error = ARENA_ERROR_SHARED_INVALID };
+    }
+    return arena;
+}
+
+static inline bool arena_shared_unlink(const char *name)
+{
+    // removes the name, mappings stay valid until every process destroys its arena
+    return name && shm_unlink(name) == 0;
+}
+#endif // ARENA_PLATFORM == _ARENA_PLATFORM_UNIX
+
+/* Helper macros */
+#define arena_alloc_struct(pArena, type)           ((type*)arena_alloc_raw((pArena), sizeof(type), alignof(type)))
+#define arena_alloc_array(pArena, size, type)      ((size) == 0 ? NULL : (type*)arena_alloc_raw((pArena), sizeof(type)*size, alignof(type)))
+#define arena_alloc_struct_zero(pArena, type)      ((type*)arena_alloc_zero((pArena), sizeof(type), alignof(type)))
+#define arena_alloc_array_zero(pArena, size, type) ((size) == 0 ? NULL : (type*)arena_alloc_zero((pArena), sizeof(type)*size, alignof(type)))
+
+// self-relative pointers, `pRel` is `ArenaRelPtr32*` or `ArenaRelPtr64*`
+#define arena_relptr_get(pRel) _Generic((pRel),                   \
+    ArenaRelPtr32*: arena_relptr32_get, const ArenaRelPtr32*: arena_relptr32_get, \
+    ArenaRelPtr64*: arena_relptr64_get, const ArenaRelPtr64*: arena_relptr64_get  \
+)(pRel)
+#define arena_relptr_set(pRel, target) _Generic((pRel),           \
+    ArenaRelPtr32*: arena_relptr32_set,                           \
+    ArenaRelPtr64*: arena_relptr64_set                            \
+)((pRel), (target))
+#define arena_relptr_get_as(pRel, type) ((type*)arena_relptr_get((pRel)))
+
+#ifdef __GNUC__
+// temporary scope restored automatically when `name` goes out of scope
+#define ARENA_TEMP_SCOPE(name, pArena) ArenaTemp name __attribute__((cleanup(_arena_temp_cleanup))) = arena_temp_begin((pArena))
+#endif
+
+#endif // ARENA_IMPLEMENTATION
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ARENA_H_
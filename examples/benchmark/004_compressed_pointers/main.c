@@ -0,0 +1,128 @@
+#include <stdio.h>
+#include <time.h>
+
+#define ARENA_IMPLEMENTATION
+#include "arena.h"
+
+#define DEPTH (size_t)22
+#define WALKS (size_t)10
+#define RUNS  (size_t)5
+
+typedef struct Node {
+    struct Node *left, *right;
+    int          value;
+} Node;
+
+typedef struct CNode {
+    ArenaCPtr left, right;
+    int       value;
+} CNode;
+
+static Node *build(Arena *arena, size_t depth, int value)
+{
+    Node *node = arena_alloc_struct(arena, Node);
+    node->value = value;
+    node->left  = depth ? build(arena, depth - 1, 2*value)     : NULL;
+    node->right = depth ? build(arena, depth - 1, 2*value + 1) : NULL;
+    return node;
+}
+
+static long long walk(const Node *node)
+{
+    if (!node) return 0;
+    return node->value + walk(node->left) + walk(node->right);
+}
+
+static ArenaCPtr build_compressed(Arena *arena, size_t depth, int value)
+{
+    CNode *node = arena_alloc_raw(arena, sizeof(CNode), 1 << ARENA_CPTR_SHIFT);
+    node->value = value;
+    node->left  = depth ? build_compressed(arena, depth - 1, 2*value)     : ARENA_CPTR_NULL;
+    node->right = depth ? build_compressed(arena, depth - 1, 2*value + 1) : ARENA_CPTR_NULL;
+    return arena_cptr_encode(arena, node);
+}
+
+static long long walk_compressed(const Arena *arena, ArenaCPtr cptr)
+{
+    const CNode *node = arena_cptr_decode(arena, cptr);
+    if (!node) return 0;
+    return node->value + walk_compressed(arena, node->left) + walk_compressed(arena, node->right);
+}
+
+static Arena create_arena()
+{
+    return arena_create_ex(arena_config_create(
+        ARENA_CAPACITY_1MB,
+        ARENA_CAPACITY_1GB,
+        ARENA_GROWTH_CONTRACT_RESERVE,
+        ARENA_GROWTH_FACTOR_CHUNKY_2MB,
+        ARENA_FLAG_NONE
+    ));
+}
+
+static void test_raw()
+{
+    Arena arena = create_arena();
+
+    double build_time = 0, walk_time = 0;
+    long long checksum = 0;
+    for (size_t r = 0; r < RUNS; ++r) {
+        long t = clock();
+        Node *root = build(&arena, DEPTH, 1);
+        long t2 = clock();
+        for (size_t w = 0; w < WALKS; ++w) checksum += walk(root);
+        long t3 = clock();
+
+        build_time += (double)(t2 - t);
+        walk_time  += (double)(t3 - t2);
+        arena_reset(&arena);
+    }
+
+    printf("Raw pointers (%zu B/node):        build %.3f ms, walk %.3f ms (Memory used: %0.1f MB) [%lld]\n",
+        sizeof(Node),
+        build_time * 1000.0 / CLOCKS_PER_SEC / RUNS,
+        walk_time  * 1000.0 / CLOCKS_PER_SEC / RUNS,
+        (double)arena.reserved / (1024*1024), checksum
+    );
+
+    arena_destroy(&arena);
+}
+
+static void test_compressed()
+{
+    Arena arena = create_arena();
+
+    double build_time = 0, walk_time = 0;
+    long long checksum = 0;
+    for (size_t r = 0; r < RUNS; ++r) {
+        long t = clock();
+        ArenaCPtr root = build_compressed(&arena, DEPTH, 1);
+        long t2 = clock();
+        for (size_t w = 0; w < WALKS; ++w) checksum += walk_compressed(&arena, root);
+        long t3 = clock();
+
+        build_time += (double)(t2 - t);
+        walk_time  += (double)(t3 - t2);
+        arena_reset(&arena);
+    }
+
+    printf("Compressed pointers (%zu B/node): build %.3f ms, walk %.3f ms (Memory used: %0.1f MB) [%lld]\n",
+        sizeof(CNode),
+        build_time * 1000.0 / CLOCKS_PER_SEC / RUNS,
+        walk_time  * 1000.0 / CLOCKS_PER_SEC / RUNS,
+        (double)arena.reserved / (1024*1024), checksum
+    );
+
+    arena_destroy(&arena);
+}
+
+int main(int argc, char const *argv[])
+{
+    printf("Raw vs compressed pointers, binary tree\nDepth: %zu (%zu nodes)\nWalks: %zu\nRuns: %zu\n",
+        DEPTH, ((size_t)1 << (DEPTH + 1)) - 1, WALKS, RUNS);
+
+    test_raw();
+    test_compressed();
+
+    return 0;
+}
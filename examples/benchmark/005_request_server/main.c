@@ -0,0 +1,448 @@
+#define _GNU_SOURCE // memmem
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/socket.h>
+
+#define ARENA_IMPLEMENTATION
+#include "arena.h"
+
+#define WORKERS  (size_t)4
+#define REQUESTS (size_t)50000 // per worker
+#define RUNS     (size_t)3
+
+#define MAX_REQUEST    (size_t)4096
+#define MAX_HEADERS    (size_t)64
+#define REQUEST_KINDS  (size_t)4
+
+/*
+    Every worker owns one end of a socketpair, a client thread drives the other end:
+    it writes one request and waits for the whole response (closed loop).
+    Worker per request: read until "\r\n\r\n", parse request line and headers, build response
+    out of many small pieces and ship them with one `writev`.
+    Latency is the time worker spends on a request once it is read (parse, build, writev, cleanup),
+    throughput is wall clock.
+*/
+
+typedef struct Header {
+    const char *name;   // lowercased copy
+    const char *value;  // copy
+    size_t      name_length;
+    size_t      value_length;
+} Header;
+
+typedef struct Request {
+    const char *method;
+    const char *path;
+    Header     *headers;
+    size_t     header_count;
+} Request;
+
+typedef struct Worker {
+    int       fd;         // server end
+    int       client_fd;  // client end
+    uint64_t *latencies;  // ns per request
+    pthread_t thread;
+    pthread_t client;
+} Worker;
+
+static char REQUESTS_TEXT[REQUEST_KINDS][MAX_REQUEST];
+
+static const char *REQUEST_PATHS[REQUEST_KINDS] = { "/", "/api/v1/users/42", "/static/app.js", "/api/v1/orders?limit=20&offset=40" };
+
+static uint64_t now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void build_requests()
+{
+    for (size_t k = 0; k < REQUEST_KINDS; ++k) {
+        int n = snprintf(REQUESTS_TEXT[k], MAX_REQUEST,
+            "GET %s HTTP/1.1\r\n"
+            "Host: bench.local\r\n"
+            "User-Agent: arena-bench/1.0 (worker; x86_64)\r\n"
+            "Accept: text/html,application/json;q=0.9,*/*;q=0.8\r\n"
+            "Accept-Encoding: gzip, deflate, br\r\n"
+            "Accept-Language: en-US,en;q=0.5\r\n"
+            "Connection: keep-alive\r\n"
+            "Cookie: session=7f3a9c2e1b; theme=dark; tracking=off\r\n"
+            "X-Request-Id: req-%zu-5b1f0d\r\n"
+            "X-Forwarded-For: 10.0.%zu.17, 192.168.1.1\r\n"
+            "Cache-Control: no-cache\r\n"
+            "Pragma: no-cache\r\n",
+            REQUEST_PATHS[k], k, k);
+        for (size_t extra = 0; extra < k * 4; ++extra) {
+            n += snprintf(REQUESTS_TEXT[k] + n, MAX_REQUEST - n, "X-Trace-%zu: span-%zu-%zu\r\n", extra, k, extra);
+        }
+        snprintf(REQUESTS_TEXT[k] + n, MAX_REQUEST - n, "\r\n");
+    }
+}
+
+static bool write_all(int fd, const char *data, size_t size)
+{
+    while (size > 0) {
+        ssize_t n = write(fd, data, size);
+        if (n <= 0) return false;
+        data += n; size -= (size_t)n;
+    }
+    return true;
+}
+
+static void *client_main(void *arg)
+{
+    Worker *worker = arg;
+    char response[16384];
+
+    for (size_t i = 0; i < REQUESTS; ++i) {
+        const char *request = REQUESTS_TEXT[i % REQUEST_KINDS];
+        if (!write_all(worker->client_fd, request, strlen(request))) break;
+
+        // headers end, then Content-Length bytes of body
+        size_t got = 0, expected = 0;
+        while (!expected || got < expected) {
+            ssize_t n = read(worker->client_fd, response + got, sizeof(response) - got);
+            if (n <= 0) return NULL;
+            got += (size_t)n;
+            if (!expected) {
+                char *end = memmem(response, got, "\r\n\r\n", 4);
+                char *length = memmem(response, got, "Content-Length: ", 16);
+                if (end && length) expected = (size_t)(end + 4 - response) + strtoul(length + 16, NULL, 10);
+            }
+        }
+    }
+    shutdown(worker->client_fd, SHUT_WR);
+    return NULL;
+}
+
+static size_t read_request(int fd, char *buffer)
+{
+    size_t got = 0;
+    while (got < MAX_REQUEST) {
+        ssize_t n = read(fd, buffer + got, MAX_REQUEST - got);
+        if (n <= 0) return 0;
+        got += (size_t)n;
+        if (got >= 4 && memcmp(buffer + got - 4, "\r\n\r\n", 4) == 0) return got;
+    }
+    return 0;
+}
+
+static size_t format_size(char *out, size_t value)
+{
+    char digits[24];
+    size_t n = 0;
+    do { digits[n++] = (char)('0' + value % 10); value /= 10; } while (value);
+    for (size_t i = 0; i < n; ++i) out[i] = digits[n - 1 - i];
+    return n;
+}
+
+/* Arena version */
+
+static char *arena_copy(Arena *arena, const char *src, size_t length, bool lower)
+{
+    char *dst = arena_alloc_raw(arena, length + 1, 1);
+    for (size_t i = 0; i < length; ++i) dst[i] = (lower && src[i] >= 'A' && src[i] <= 'Z') ? src[i] + 32 : src[i];
+    dst[length] = '\0';
+    return dst;
+}
+
+static bool parse_arena(Arena *arena, const char *text, size_t size, Request *request)
+{
+    const char *end = text + size;
+    const char *line_end = memmem(text, size, "\r\n", 2);
+    const char *space = memchr(text, ' ', line_end - text);
+    const char *space2 = space ? memchr(space + 1, ' ', line_end - space - 1) : NULL;
+    if (!space2) return false;
+
+    request->method  = arena_copy(arena, text, space - text, false);
+    request->path    = arena_copy(arena, space + 1, space2 - space - 1, false);
+    request->headers = arena_alloc_array(arena, MAX_HEADERS, Header);
+    request->header_count = 0;
+
+    for (const char *line = line_end + 2; line < end && request->header_count < MAX_HEADERS; line = line_end + 2) {
+        line_end = memmem(line, end - line, "\r\n", 2);
+        if (!line_end || line_end == line) break;
+        const char *colon = memchr(line, ':', line_end - line);
+        if (!colon) return false;
+        const char *value = colon + 1;
+        while (*value == ' ') value++;
+
+        Header *header = &request->headers[request->header_count++];
+        header->name_length  = colon - line;
+        header->value_length = line_end - value;
+        header->name  = arena_copy(arena, line, header->name_length, true);
+        header->value = arena_copy(arena, value, header->value_length, false);
+    }
+    return true;
+}
+
+static void append_arena(Arena *response, const char *data, size_t length)
+{
+    // response arena holds nothing but output, so its chunks are the iovec
+    char *dst = arena_alloc_raw(response, length, 1);
+    memcpy(dst, data, length);
+}
+
+static bool respond_arena(Arena *response, int fd, const Request *request)
+{
+    // body: one line per header, its size goes into the status block so it is counted first
+    size_t body_size = 0;
+    for (size_t i = 0; i < request->header_count; ++i) {
+        body_size += request->headers[i].name_length + 1 + request->headers[i].value_length + 1;
+    }
+
+    static const char STATUS[] = "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\nServer: arena-bench\r\n";
+    append_arena(response, STATUS, sizeof(STATUS) - 1);
+    for (size_t i = 0; i < request->header_count; ++i) {
+        if (strcmp(request->headers[i].name, "x-request-id") != 0) continue;
+        append_arena(response, "X-Request-Id: ", 14);
+        append_arena(response, request->headers[i].value, request->headers[i].value_length);
+        append_arena(response, "\r\n", 2);
+    }
+    char length[64] = "Content-Length: ";
+    size_t n = 16 + format_size(length + 16, body_size);
+    memcpy(length + n, "\r\n\r\n", 4);
+    append_arena(response, length, n + 4);
+
+    for (size_t i = 0; i < request->header_count; ++i) {
+        append_arena(response, request->headers[i].name, request->headers[i].name_length);
+        append_arena(response, "=", 1);
+        append_arena(response, request->headers[i].value, request->headers[i].value_length);
+        append_arena(response, "\n", 1);
+    }
+
+    struct iovec iov[32];
+    size_t count = arena_to_iovec(response, iov, 32);
+    return count <= 32 && writev(fd, iov, (int)count) > 0;
+}
+
+static void *worker_arena(void *arg)
+{
+    Worker *worker = arg;
+
+    // per request arenas, kept across requests and reset after each one
+    Arena request_arena = arena_create_ex(arena_config_create(
+        ARENA_CAPACITY_8KB,
+        ARENA_CAPACITY_1MB,
+        ARENA_GROWTH_CONTRACT_CHUNKY,
+        ARENA_GROWTH_FACTOR_CHUNKY_4KB,
+        ARENA_FLAG_NONE
+    ));
+    Arena response_arena = arena_create_ex(arena_config_create(
+        ARENA_CAPACITY_1KB,
+        ARENA_CAPACITY_1MB,
+        ARENA_GROWTH_CONTRACT_CHUNKY,
+        ARENA_GROWTH_FACTOR_CHUNKY_1KB,
+        ARENA_FLAG_NONE
+    ));
+
+    for (size_t i = 0; i < REQUESTS; ++i) {
+        char *buffer = arena_alloc_raw(&request_arena, MAX_REQUEST, 16);
+        size_t size = read_request(worker->fd, buffer);
+        if (!size) break;
+
+        uint64_t start = now_ns();
+        Request request = {0};
+        if (!parse_arena(&request_arena, buffer, size, &request)) break;
+        if (!respond_arena(&response_arena, worker->fd, &request)) break;
+        arena_reset(&request_arena);
+        arena_reset(&response_arena);
+        worker->latencies[i] = now_ns() - start;
+    }
+
+    arena_destroy(&request_arena);
+    arena_destroy(&response_arena);
+    return NULL;
+}
+
+/* Malloc version */
+
+static char *malloc_copy(const char *src, size_t length, bool lower)
+{
+    char *dst = malloc(length + 1);
+    for (size_t i = 0; i < length; ++i) dst[i] = (lower && src[i] >= 'A' && src[i] <= 'Z') ? src[i] + 32 : src[i];
+    dst[length] = '\0';
+    return dst;
+}
+
+static bool parse_malloc(const char *text, size_t size, Request *request)
+{
+    const char *end = text + size;
+    const char *line_end = memmem(text, size, "\r\n", 2);
+    const char *space = memchr(text, ' ', line_end - text);
+    const char *space2 = space ? memchr(space + 1, ' ', line_end - space - 1) : NULL;
+    if (!space2) return false;
+
+    request->method  = malloc_copy(text, space - text, false);
+    request->path    = malloc_copy(space + 1, space2 - space - 1, false);
+    request->headers = malloc(MAX_HEADERS * sizeof(Header));
+    request->header_count = 0;
+
+    for (const char *line = line_end + 2; line < end && request->header_count < MAX_HEADERS; line = line_end + 2) {
+        line_end = memmem(line, end - line, "\r\n", 2);
+        if (!line_end || line_end == line) break;
+        const char *colon = memchr(line, ':', line_end - line);
+        if (!colon) return false;
+        const char *value = colon + 1;
+        while (*value == ' ') value++;
+
+        Header *header = &request->headers[request->header_count++];
+        header->name_length  = colon - line;
+        header->value_length = line_end - value;
+        header->name  = malloc_copy(line, header->name_length, true);
+        header->value = malloc_copy(value, header->value_length, false);
+    }
+    return true;
+}
+
+static void free_request(Request *request)
+{
+    for (size_t i = 0; i < request->header_count; ++i) {
+        free((void*)request->headers[i].name);
+        free((void*)request->headers[i].value);
+    }
+    free(request->headers);
+    free((void*)request->method);
+    free((void*)request->path);
+}
+
+typedef struct Pieces {
+    struct iovec *iov;
+    size_t       count;
+    size_t       capacity;
+} Pieces;
+
+static void append_malloc(Pieces *pieces, const char *data, size_t length)
+{
+    if (pieces->count == pieces->capacity) {
+        pieces->capacity = pieces->capacity ? pieces->capacity * 2 : 16;
+        pieces->iov = realloc(pieces->iov, pieces->capacity * sizeof(struct iovec));
+    }
+    char *dst = malloc(length);
+    memcpy(dst, data, length);
+    pieces->iov[pieces->count++] = (struct iovec){ dst, length };
+}
+
+static bool respond_malloc(int fd, const Request *request)
+{
+    size_t body_size = 0;
+    for (size_t i = 0; i < request->header_count; ++i) {
+        body_size += request->headers[i].name_length + 1 + request->headers[i].value_length + 1;
+    }
+
+    Pieces pieces = {0};
+    static const char STATUS[] = "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\nServer: arena-bench\r\n";
+    append_malloc(&pieces, STATUS, sizeof(STATUS) - 1);
+    for (size_t i = 0; i < request->header_count; ++i) {
+        if (strcmp(request->headers[i].name, "x-request-id") != 0) continue;
+        append_malloc(&pieces, "X-Request-Id: ", 14);
+        append_malloc(&pieces, request->headers[i].value, request->headers[i].value_length);
+        append_malloc(&pieces, "\r\n", 2);
+    }
+    char length[64] = "Content-Length: ";
+    size_t n = 16 + format_size(length + 16, body_size);
+    memcpy(length + n, "\r\n\r\n", 4);
+    append_malloc(&pieces, length, n + 4);
+
+    for (size_t i = 0; i < request->header_count; ++i) {
+        append_malloc(&pieces, request->headers[i].name, request->headers[i].name_length);
+        append_malloc(&pieces, "=", 1);
+        append_malloc(&pieces, request->headers[i].value, request->headers[i].value_length);
+        append_malloc(&pieces, "\n", 1);
+    }
+
+    // writev takes at most IOV_MAX pieces, plenty here
+    bool ok = writev(fd, pieces.iov, (int)pieces.count) > 0;
+    for (size_t i = 0; i < pieces.count; ++i) free(pieces.iov[i].iov_base);
+    free(pieces.iov);
+    return ok;
+}
+
+static void *worker_malloc(void *arg)
+{
+    Worker *worker = arg;
+
+    for (size_t i = 0; i < REQUESTS; ++i) {
+        char *buffer = malloc(MAX_REQUEST);
+        size_t size = read_request(worker->fd, buffer);
+        if (!size) {
+            free(buffer);
+            break;
+        }
+
+        uint64_t start = now_ns();
+        Request request = {0};
+        bool ok = parse_malloc(buffer, size, &request) && respond_malloc(worker->fd, &request);
+        free_request(&request);
+        free(buffer);
+        if (!ok) break;
+        worker->latencies[i] = now_ns() - start;
+    }
+    return NULL;
+}
+
+/* Driver */
+
+static int compare_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+static void run(bool use_arena)
+{
+    size_t total = WORKERS * REQUESTS;
+    uint64_t *latencies = calloc(total * RUNS, sizeof(uint64_t));
+    double seconds = 0;
+
+    for (size_t r = 0; r < RUNS; ++r) {
+        Worker workers[WORKERS];
+        for (size_t w = 0; w < WORKERS; ++w) {
+            int fds[2];
+            socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+            workers[w] = (Worker){
+                .fd        = fds[0],
+                .client_fd = fds[1],
+                .latencies = latencies + (r * WORKERS + w) * REQUESTS
+            };
+        }
+
+        uint64_t start = now_ns();
+        for (size_t w = 0; w < WORKERS; ++w) {
+            pthread_create(&workers[w].thread, NULL, use_arena ? worker_arena : worker_malloc, &workers[w]);
+            pthread_create(&workers[w].client, NULL, client_main, &workers[w]);
+        }
+        for (size_t w = 0; w < WORKERS; ++w) {
+            pthread_join(workers[w].client, NULL);
+            pthread_join(workers[w].thread, NULL);
+            close(workers[w].fd);
+            close(workers[w].client_fd);
+        }
+        seconds += (double)(now_ns() - start) / 1e9;
+    }
+
+    qsort(latencies, total * RUNS, sizeof(uint64_t), compare_u64);
+    printf("%s: %.0f req/s, p50 %.2f us, p99 %.2f us, p999 %.2f us\n",
+        use_arena ? "Arena " : "Malloc",
+        (double)(total * RUNS) / seconds,
+        latencies[total * RUNS / 2] / 1000.0,
+        latencies[total * RUNS * 99 / 100] / 1000.0,
+        latencies[total * RUNS * 999 / 1000] / 1000.0
+    );
+    free(latencies);
+}
+
+int main(int argc, char const *argv[])
+{
+    printf("Request server over socketpair, arena vs malloc\nWorkers: %zu\nRequests per worker: %zu\nRuns: %zu\n",
+        WORKERS, REQUESTS, RUNS);
+
+    build_requests();
+    run(true);
+    run(false);
+
+    return 0;
+}
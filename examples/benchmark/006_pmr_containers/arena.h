@@ -0,0 +1,4551 @@
+// Copyright 2022 Alexey Kutepov <reximkut@gmail.com>
+
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef ARENA_H_
+#define ARENA_H_
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdalign.h>
+#include <limits.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef uint64_t  arena_size_t;
+#define ARENA_SIZE_FMT "%llu"
+typedef uintptr_t arena_ptr_t;
+
+#define _ARENA_PLATFORM_LIBC  0x0
+#define _ARENA_PLATFORM_WIN32 0x2
+#define _ARENA_PLATFORM_WIN64 0x4
+#define _ARENA_PLATFORM_UNIX  0x8
+
+#ifdef __GNUC__
+    #define _ARENA_FORCE_INLINE static inline __attribute__((always_inline))
+    #define _ARENA_PREFETCH(addr) __builtin_prefetch((addr))
+    #define _ARENA_ATOMIC_LOAD(ptr)         __atomic_load_n((ptr), __ATOMIC_ACQUIRE)
+    #define _ARENA_ATOMIC_STORE(ptr, value) __atomic_store_n((ptr), (value), __ATOMIC_RELEASE)
+    #define _ARENA_ATOMIC_CAS(ptr, expected, desired) \
+        __atomic_compare_exchange_n((ptr), (expected), (desired), true, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)
+    #define _ARENA_ATOMIC_FETCH_ADD(ptr, value) __atomic_fetch_add((ptr), (value), __ATOMIC_ACQ_REL)
+#else
+    #define _ARENA_FORCE_INLINE static inline
+    #define _ARENA_PREFETCH(...)
+    #define _ARENA_ATOMIC_LOAD(ptr)         (*(ptr))
+    #define _ARENA_ATOMIC_STORE(ptr, value) (*(ptr) = (value))
+    #define _ARENA_ATOMIC_CAS(ptr, expected, desired) \
+        (*(ptr) == *(expected) ? (*(ptr) = (desired), true) : (*(expected) = *(ptr), false))
+    #define _ARENA_ATOMIC_FETCH_ADD(ptr, value) ((*(ptr) += (value)) - (value))
+#endif
+
+#ifndef ARENA_PLATFORM
+    #if defined(_WIN32)
+        #define ARENA_PLATFORM _ARENA_PLATFORM_WIN32
+    #elif defined(_WIN64)
+        #define ARENA_PLATFORM _ARENA_PLATFORM_WIN64
+    #elif defined(__unix__) || defined(__linux__)
+        #define ARENA_PLATFORM _ARENA_PLATFORM_UNIX
+    #else
+        #define ARENA_PLATFORM _ARENA_PLATFORM_LIBC
+    #endif
+#endif 
+
+#if (ARENA_PLATFORM == _ARENA_PLATFORM_WIN32)
+    #define WIN32_LEAN_AND_MEAN
+    #define NOGDI
+    #define NOMINMAX
+    #define NOUSER
+    #define NOSERVICE
+    #define NOMCX
+    #define NOSOUND
+    #define NOCOMM
+    #define NORPC
+    #include <windows.h>
+#elif ARENA_PLATFORM == _ARENA_PLATFORM_UNIX
+    #include <unistd.h>
+    #include <fcntl.h>
+    #include <errno.h>
+    #include <sys/mman.h>
+    #include <sys/uio.h>
+    #include <sys/stat.h>
+    #if defined(__linux__)
+        #include <sys/syscall.h>
+        #if defined(SYS_io_uring_setup) && defined(SYS_io_uring_enter) && defined(SYS_io_uring_register)
+            #define _ARENA_HAS_URING 1 // raw syscalls, no liburing
+        #endif
+    #endif
+    #ifndef MAP_FIXED_NOREPLACE
+        #define MAP_FIXED_NOREPLACE 0 // address becomes a hint, result is checked anyway
+    #endif
+#else
+    #error("Undefined platform")
+#endif
+
+#ifndef ARENA_NOMINAX
+    #define ARENA_MAX(a, b) ((a) - (((a) - (b)) & (((a) - (b)) >> 31))) // damn
+    #define ARENA_MIN(a, b) ((b) + (((a) - (b)) & (((a) - (b)) >> 31)))
+#endif
+
+#define ARENA_U64_MAX  0xffffffffffffffffull
+#define ARENA_U32_MAX  0xffffffffu
+#define ARENA_SIZE_MAX SIZE_MAX
+#define ARENA_PTR_MAX  MAXINT_PTR
+
+#ifndef ARENA_CACHELINE_SIZE
+#define ARENA_CACHELINE_SIZE (uint32_t)64
+#endif
+
+#define _ARENA_POISON_ALLOC         0xCD   // arena memory poisoning value after allocating memory from arena
+#define _ARENA_POISON_RESET         0xDD   // arena memory poisoning value after resetting arena
+
+#define ARENA_PAGE_ALIGN_THRESHOLD 0x2000  // used to identify when to switch to platform specific allocation 
+#define ARENA_PAGE_DEFAULT_SIZE    0x1000  // for libc universal platform 
+
+typedef enum ArenaGrowthContract : uint32_t {
+    ARENA_GROWTH_CONTRACT_FIXED       = 0,
+    ARENA_GROWTH_CONTRACT_REALLOC     = 2,
+    ARENA_GROWTH_CONTRACT_CHUNKY      = 4,
+    ARENA_GROWTH_CONTRACT_RESERVE     = 8, // max_capacity of address space reserved up front, pages committed on growth, never moves
+} ArenaGrowthContract;
+
+typedef enum ArenaGrowthFactor : uint32_t {
+    ARENA_GROWTH_FACTOR_NONE        = 0x0,    // none =D
+    ARENA_GROWTH_FACTOR_REALLOC_2X  = 0x2,    // for mul operation
+    ARENA_GROWTH_FACTOR_REALLOC_4X  = 0x4,    // for mul operation
+    ARENA_GROWTH_FACTOR_REALLOC_8X  = 0x8,    // for mul operation
+    ARENA_GROWTH_FACTOR_CHUNKY_512B  = 0x200,
+    ARENA_GROWTH_FACTOR_CHUNKY_1KB   = 0x400,
+    ARENA_GROWTH_FACTOR_CHUNKY_2KB   = 0x800,
+    ARENA_GROWTH_FACTOR_CHUNKY_4KB   = 0x1000,
+    ARENA_GROWTH_FACTOR_CHUNKY_8KB   = 0x2000,
+    ARENA_GROWTH_FACTOR_CHUNKY_16KB  = 0x4000,
+    ARENA_GROWTH_FACTOR_CHUNKY_32KB  = 0x8000,
+    ARENA_GROWTH_FACTOR_CHUNKY_64KB  = 0x10000,
+    ARENA_GROWTH_FACTOR_CHUNKY_128KB = 0x20000,
+    ARENA_GROWTH_FACTOR_CHUNKY_256KB = 0x40000,
+    ARENA_GROWTH_FACTOR_CHUNKY_512KB = 0x80000,
+    ARENA_GROWTH_FACTOR_CHUNKY_1MB   = 0x100000,
+    ARENA_GROWTH_FACTOR_CHUNKY_2MB   = 0x200000,
+    ARENA_GROWTH_FACTOR_CHUNKY_MAX   = ARENA_GROWTH_FACTOR_CHUNKY_2MB,
+    ARENA_GROWTH_FACTOR_CHUNKY_MIN   = ARENA_GROWTH_FACTOR_CHUNKY_512B,
+} ArenaGrowthFactor;
+
+#define ARENA_CAPACITY_CHOOSE_FOR_ME_PLS 0 
+#define ARENA_CAPACITY_512B    (arena_size_t)0x200
+#define ARENA_CAPACITY_1KB     (arena_size_t)0x400
+#define ARENA_CAPACITY_2KB     (arena_size_t)0x800
+#define ARENA_CAPACITY_4KB     (arena_size_t)0x1000
+#define ARENA_CAPACITY_8KB     (arena_size_t)0x2000
+#define ARENA_CAPACITY_16KB    (arena_size_t)0x4000
+#define ARENA_CAPACITY_32KB    (arena_size_t)0x8000
+#define ARENA_CAPACITY_64KB    (arena_size_t)0x10000
+#define ARENA_CAPACITY_128KB   (arena_size_t)0x20000
+#define ARENA_CAPACITY_256KB   (arena_size_t)0x40000
+#define ARENA_CAPACITY_512KB   (arena_size_t)0x80000
+#define ARENA_CAPACITY_1MB     (arena_size_t)0x100000
+#define ARENA_CAPACITY_2MB     (arena_size_t)0x200000
+#define ARENA_CAPACITY_4MB     (arena_size_t)0x400000
+#define ARENA_CAPACITY_8MB     (arena_size_t)0x800000
+#define ARENA_CAPACITY_16MB    (arena_size_t)0x1000000
+#define ARENA_CAPACITY_32MB    (arena_size_t)0x2000000
+#define ARENA_CAPACITY_64MB    (arena_size_t)0x4000000
+#define ARENA_CAPACITY_128MB   (arena_size_t)0x8000000
+#define ARENA_CAPACITY_256MB   (arena_size_t)0x10000000
+#define ARENA_CAPACITY_512MB   (arena_size_t)0x20000000
+#define ARENA_CAPACITY_1GB     (arena_size_t)0x40000000
+#define ARENA_CAPACITY_2GB     (arena_size_t)0x80000000
+#define ARENA_CAPACITY_4GB     (arena_size_t)0x100000000
+#define ARENA_CAPACITY_8GB     (arena_size_t)0x200000000
+#define ARENA_CAPACITY_DEFAULT ARENA_CAPACITY_4KB
+#define ARENA_CAPACITY_MAX     ARENA_CAPACITY_8GB
+#define ARENA_CAPACITY_MIN     ARENA_CAPACITY_512B
+
+#define ARENA_ALLOC_TYPE_SMALL 0x0 // arena is allocated as an array of bytes
+#define ARENA_ALLOC_TYPE_BIG   0x1 // arena is allocated as memory pages
+
+#define ARENA_CHUNK_BACKING_DEFAULT 0x0 // allocated according to arena alloc type
+#define ARENA_CHUNK_BACKING_MAPPED  0x1 // private mapping of a snapshot file
+#define ARENA_CHUNK_BACKING_FILE    0x2 // shared mapping of arena file (arena_create_file)
+#define ARENA_CHUNK_BACKING_SHARED  0x3 // shared memory object, header page sits right before the chunk
+#define ARENA_CHUNK_BACKING_RESERVED 0x4 // address space reservation (ARENA_GROWTH_CONTRACT_RESERVE)
+#define ARENA_CHUNK_BACKING_LOADED  0x5 // read only file mapping (arena_load_file), owned but never in the chain
+#define ARENA_CHUNK_BACKING_SPILLED 0x6 // moved to the spill file (arena_spill_enable), kernel may evict its pages
+
+typedef enum ArenaAlignment : uint32_t {
+    // Alignment constants
+    ARENA_ALIGN_2B      = 2,
+    ARENA_ALIGN_4B      = 4,
+    ARENA_ALIGN_8B      = 8,
+    ARENA_ALIGN_16B     = 16,
+    ARENA_ALIGN_32B     = 32,
+    ARENA_ALIGN_64B     = 64,
+    ARENA_ALIGN_128B    = 128,
+    ARENA_ALIGN_256B    = 256,
+    ARENA_ALIGN_512B    = 512,
+    ARENA_ALIGN_DEFAULT = ARENA_ALIGN_16B,
+    
+    // SIMD support
+    ARENA_ALIGN_SIMD_MMX       = 8,
+    ARENA_ALIGN_SIMD_SSE       = 16,
+    ARENA_ALIGN_SIMD_AVX       = 32,
+    ARENA_ALIGN_SIMD_AVX512    = 512,
+
+    // Cache line sized alignment
+    ARENA_ALIGN_CACHELINE = ARENA_CACHELINE_SIZE,
+} ArenaAlignment;
+
+typedef enum ArenaFlag : uint16_t {
+    ARENA_FLAG_NONE              = 0,
+    ARENA_FLAG_FILLZEROES        = 1,
+    ARENA_FLAG_DEBUG             = 1 << 1,
+    ARENA_FLAG_ENFORCE_ALIGNMENT = 1 << 2,
+    ARENA_FLAG_RESET_AFTER_GROW  = 1 << 3,
+    ARENA_FLAG_FIXED_CHUNK_SIZE  = 1 << 4,
+    ARENA_FLAG_SHARED            = 1 << 5, // chunk is shared between processes, offset is bumped atomically
+    ARENA_FLAG_FROZEN            = 1 << 6, // chunks are read only (`arena_freeze`), set by the library
+} ArenaFlag;
+
+typedef enum ArenaError : uint32_t {
+    ARENA_ERROR_NONE = 0,
+
+    ARENA_ERROR_INVALID_CAPACITY,
+    ARENA_ERROR_INVALID_ALIGNMENT,
+
+    ARENA_ERROR_OOM,
+    ARENA_ERROR_ALIGNMENT_TOO_LARGE,
+    ARENA_ERROR_SIZE_ZERO,
+    ARENA_ERROR_SIZE_OVERFLOW,
+
+    ARENA_ERROR_GROWTH_FORBIDDEN,
+    ARENA_ERROR_MAX_CAPACITY_REACHED,
+    ARENA_ERROR_REALLOC_FAILED,
+    ARENA_ERROR_CHUNK_ALLOC_FAILED,
+
+    ARENA_ERROR_EPOCH_MISMATCH,
+
+    ARENA_ERROR_MAPPING_FAILED,
+    ARENA_ERROR_RING_FULL,
+    ARENA_ERROR_INVALID_HANDLE,
+
+    ARENA_ERROR_IO,
+    ARENA_ERROR_SNAPSHOT_INVALID,
+    ARENA_ERROR_SNAPSHOT_RELOCATED,
+    ARENA_ERROR_SHARED_INVALID,
+    ARENA_ERROR_UNSUPPORTED,
+    ARENA_ERROR_FORK_STALE,
+    ARENA_ERROR_FROZEN,
+    ARENA_ERROR_BUFFER_INVALID,
+} ArenaError;
+
+typedef struct ArenaConfig {
+    arena_size_t        capacity;
+    arena_size_t        max_capacity;
+    ArenaGrowthContract growth_contract;
+    size_t              growth_factor;
+    ArenaFlag           flags;
+} ArenaConfig;
+
+typedef struct ArenaDebugInfo {
+    uint8_t      *end;              // address to the end of the last allocated block of memory
+    arena_size_t bytes_lost;        // bytes loss due to alignment
+    size_t       total_allocations; // obviously number of total allocations
+} ArenaDebugInfo;   
+
+typedef struct ArenaChunk {
+    struct ArenaChunk  *next;
+    arena_size_t       capacity;
+    arena_size_t       offset;
+    uint32_t           index;    // position in the chain (and in arena chunk directory)
+    uint32_t           backing;  // where chunk memory comes from - ARENA_CHUNK_BACKING_...
+    uint8_t            base[];
+} ArenaChunk;
+
+typedef struct ArenaMemory {
+    ArenaChunk   *chunk;    // pointer to chunk
+    void         *data;     // pointer to data
+    size_t       alignment; // how data is aligned in this memory
+    arena_size_t offset;    // offset from the chunk base to the data
+    arena_size_t size;      // memory size
+    arena_size_t epoch;
+} ArenaMemory;
+
+/*
+    Packed 8 byte reference to arena memory: [ epoch:12 | chunk index + 1:18 | offset:34 ]
+    Survives realloc growth, zero value is NULL handle.
+*/
+typedef uint64_t ArenaHandle;
+
+#define ARENA_HANDLE_NULL        ((ArenaHandle)0)
+#define ARENA_HANDLE_OFFSET_BITS 34 // up to 16GB per chunk
+#define ARENA_HANDLE_CHUNK_BITS  18 // up to 262143 chunks
+#define ARENA_HANDLE_EPOCH_BITS  12 // low bits of arena epoch, catches most stale handles
+#define ARENA_HANDLE_OFFSET_MASK ((1ull << ARENA_HANDLE_OFFSET_BITS) - 1)
+#define ARENA_HANDLE_CHUNK_MASK  ((1ull << ARENA_HANDLE_CHUNK_BITS) - 1)
+#define ARENA_HANDLE_EPOCH_MASK  ((1ull << ARENA_HANDLE_EPOCH_BITS) - 1)
+
+typedef struct ArenaMark {
+    ArenaChunk   *chunk;
+    arena_size_t offset;
+    arena_size_t epoch;
+    arena_size_t reserved; // arena reserved memory at the moment of marking
+    ArenaHandle  defer;    // newest deferred callback at the moment of marking
+} ArenaMark;
+
+typedef void (*ArenaDeferFn)(void *ctx);
+
+typedef struct ArenaDeferRecord {
+    ArenaDeferFn fn;
+    void         *ctx;
+    ArenaHandle  prev;     // older record, handles survive realloc moves
+} ArenaDeferRecord;
+
+typedef struct Arena {
+    // metadata
+    arena_size_t        reserved;        // memory reserved for user data in the chain (does not include chunk metadata or cached chunks, used for OOM check)
+    arena_size_t        max_capacity;    // max arena capacity (machine dependent), it shows how big this arena can be if it can grow
+    arena_size_t        growth_factor;   // how fast grows (depends on contract)
+    ArenaGrowthContract growth_contract; // arena growth contract (how to grow)
+    ArenaFlag           flags;           // arena flags - ARENA_FLAG_...
+    ArenaError          error;           // error flag
+    uint32_t            alloc_type;      // reflects how arena memory was originally allocated and must not change during arena lifetime
+    arena_size_t        epoch;
+    uint32_t            remaps;          // bumped whenever chunk memory is unmapped or replaced by another mapping
+    // chunks
+    ArenaChunk          *head_chunk;
+    ArenaChunk          *last_chunk;
+    ArenaChunk          *free_chunks;    // chunks released by `arena_restore`, reused by `arena_grow` before asking OS for more
+    // backing of new chunks
+    uint32_t            backing;         // ARENA_CHUNK_BACKING_DEFAULT or ARENA_CHUNK_BACKING_FILE
+    int                 fd;              // arena file (ARENA_CHUNK_BACKING_FILE) or spill file (spill_budget set)
+    arena_size_t        file_size;       // end of the last chunk region in arena file or spill file
+    arena_size_t        spill_budget;    // resident chunk bytes allowed before the oldest chunks are spilled, 0 = off
+    struct ArenaFork    *fork;           // set on arenas made by `arena_fork`
+    ArenaHandle         defer;           // newest `arena_defer` record, run LIFO on reset, restore and destroy
+    // chunk directory
+    ArenaChunk          **chunks;        // chain order (allocated on first chunky growth, until then head_chunk is the only chunk)
+    ArenaChunk          **chunks_sorted; // every owned chunk (chain + cache) sorted by address
+    uint32_t            chunk_count;     // chunks in the chain
+    uint32_t            owned_count;     // chunks owned by arena (chain + cache)
+    uint32_t            chunk_capacity;  // chunk directory capacity
+    //debug
+    ArenaDebugInfo      debug;
+} Arena;
+
+#define ARENA_EMPTY ((Arena){})
+
+typedef struct ArenaFork {
+    // parent state at fork time, commit refuses to run if it changed
+    ArenaChunk   *parent_head;
+    arena_size_t parent_epoch;
+    arena_size_t parent_used;
+    uint32_t     parent_chunk_count;
+    uint32_t     count;
+    ArenaChunk   *twins[];        // [2*i] child chunk, [2*i + 1] parent chunk it is a private mapping of
+} ArenaFork;
+
+typedef struct ArenaTemp {
+    Arena     *arena;
+    ArenaMark mark;
+} ArenaTemp;
+
+typedef struct ArenaRing {
+    uint8_t      *base;     // first of two adjacent views of the same pages (record at the end continues in the second view)
+    arena_size_t capacity;  // size of one view (multiple of page size)
+    arena_size_t head;      // bytes published to the consumer (monotonic, written by producer)
+    arena_size_t write;     // producer cursor, becomes visible to the consumer on `arena_ring_commit`
+    arena_size_t tail;      // bytes released by the consumer (monotonic, written by consumer)
+    ArenaError   error;     // error flag
+} ArenaRing;
+
+#define ARENA_RING_EMPTY ((ArenaRing){})
+
+#ifdef _ARENA_HAS_URING
+/*
+    io_uring kernel ABI (stable), copied so <linux/io_uring.h> and the <linux/fs.h>
+    macros it drags in stay out of user code.
+*/
+typedef struct _ArenaUringParams {
+    uint32_t sq_entries, cq_entries, flags, sq_thread_cpu, sq_thread_idle, features, wq_fd, resv[3];
+    struct { uint32_t head, tail, ring_mask, ring_entries, flags, dropped, array, resv1; uint64_t user_addr; } sq_off;
+    struct { uint32_t head, tail, ring_mask, ring_entries, overflow, cqes, flags, resv1; uint64_t user_addr; } cq_off;
+} _ArenaUringParams;
+
+typedef struct _ArenaUringSqe {
+    uint8_t  opcode;
+    uint8_t  flags;
+    uint16_t ioprio;
+    int32_t  fd;
+    uint64_t off;
+    uint64_t addr;
+    uint32_t len;
+    uint32_t rw_flags;
+    uint64_t user_data;
+    uint16_t buf_index;
+    uint16_t personality;
+    int32_t  splice_fd_in;
+    uint64_t pad[2];
+} _ArenaUringSqe;
+
+typedef struct _ArenaUringCqe {
+    uint64_t user_data;
+    int32_t  res;
+    uint32_t flags;
+} _ArenaUringCqe;
+
+#define _ARENA_URING_OFF_SQ_RING        0ull
+#define _ARENA_URING_OFF_CQ_RING        0x8000000ull
+#define _ARENA_URING_OFF_SQES           0x10000000ull
+#define _ARENA_URING_FEAT_SINGLE_MMAP   (1u << 0)
+#define _ARENA_URING_ENTER_GETEVENTS    (1u << 0)
+#define _ARENA_URING_REGISTER_BUFFERS   0
+#define _ARENA_URING_UNREGISTER_BUFFERS 1
+#define _ARENA_URING_OP_READ_FIXED      4
+#define _ARENA_URING_OP_WRITE_FIXED     5
+#define _ARENA_URING_OP_READ            22
+#define _ARENA_URING_OP_WRITE           23
+#endif
+
+typedef struct ArenaUring {
+    int          fd;            // io_uring instance
+    uint32_t     *sq_head;      // kernel side of the submission ring
+    uint32_t     *sq_tail;
+    uint32_t     *sq_array;
+    uint32_t     *cq_head;      // our side of the completion ring
+    uint32_t     *cq_tail;
+    uint32_t     sq_mask;
+    uint32_t     cq_mask;
+    uint32_t     sq_entries;
+    uint32_t     pending;       // queued but not yet submitted
+    void         *sqes;         // submission entries (`_ArenaUringSqe`)
+    void         *cqes;         // completion entries (`_ArenaUringCqe`)
+    uint8_t      *sq_ring;
+    uint8_t      *cq_ring;      // same mapping as `sq_ring` on kernels with single mmap feature
+    size_t       sq_ring_size;
+    size_t       cq_ring_size;
+    size_t       sqes_size;
+    struct iovec *buffers;      // registered arena chunks sorted by address, position is the fixed buffer index
+    uint32_t     buffer_count;
+    const Arena  *arena;        // arena the buffers belong to
+    ArenaChunk   *arena_head;   // its head chunk and remap count at registration, fixed buffers are
+    uint32_t     arena_remaps;  // used only while both still match
+    ArenaError   error;         // error flag
+} ArenaUring;
+
+typedef struct ArenaUringCompletion {
+    uint64_t user_data;
+    int32_t  result;            // bytes transferred or -errno
+    uint32_t flags;
+} ArenaUringCompletion;
+
+/*
+    Stable reference to an object in `ArenaTable`: [ generation:32 | slot + 1:32 ]
+    Unlike `ArenaHandle` it stays valid when `arena_compact` moves the object.
+*/
+typedef uint64_t ArenaRef;
+
+#define ARENA_REF_NULL ((ArenaRef)0)
+
+/*
+    Self-relative pointers: distance in bytes from the field itself to the target, 0 is NULL.
+    Data linked with them survives `_arena_realloc`, snapshots and shared mappings without fix-ups,
+    as long as field and target move together (same chunk, or whole arena copied as one block).
+*/
+typedef struct ArenaRelPtr32 { int32_t offset; } ArenaRelPtr32;
+typedef struct ArenaRelPtr64 { int64_t offset; } ArenaRelPtr64;
+
+/*
+    Compressed pointer: (ptr - head chunk) >> ARENA_CPTR_SHIFT in 32 bits, 0 is NULL.
+    Covers 32GB with 8 byte aligned objects. Valid only for FIXED and RESERVE arenas: chunky ones have
+    no single base, REALLOC moves decoded objects on every growth. RESERVE grows without ever moving.
+    Encoding a misaligned, out of range pointer or one from another arena asserts in debug builds.
+*/
+typedef uint32_t ArenaCPtr;
+
+#define ARENA_CPTR_NULL  ((ArenaCPtr)0)
+#define ARENA_CPTR_SHIFT 3
+
+/*
+    Serialized buffer: [ ArenaBufHeader ][ objects ... ]
+    Objects link to each other with offsets from the buffer start (0 is NULL), so the buffer is position
+    independent: it can be written to a socket or file and read in place (mmap, `arena_load_file`).
+    Vector: [ uint32 count ][ pad ][ items ], string: [ uint32 length ][ bytes ][ 0 ], offset points at the count.
+    Alignment is relative to buffer start (max ARENA_BUF_MAX_ALIGN), values are in native byte order.
+*/
+typedef uint32_t ArenaBufOffset;
+
+#define ARENA_BUF_MAGIC     0x46554241u // "ABUF"
+#define ARENA_BUF_VERSION   1u
+#define ARENA_BUF_MAX_ALIGN 16
+
+typedef struct ArenaBufHeader {
+    uint32_t       magic;
+    uint32_t       version;
+    uint32_t       size;   // whole buffer, header included
+    ArenaBufOffset root;
+} ArenaBufHeader;
+
+typedef struct ArenaBufBuilder {
+    Arena      arena;  // realloc arena, its only chunk is the buffer
+    ArenaError error;  // error flag
+} ArenaBufBuilder;
+
+typedef struct ArenaBufView {
+    const uint8_t  *data;
+    uint32_t       size;
+    ArenaBufOffset root;
+    ArenaError     error;  // set by `arena_buf_view`, accessors of an invalid view return NULL
+} ArenaBufView;
+
+typedef struct ArenaTableEntry {
+    ArenaHandle  handle;     // current location of the object (ARENA_HANDLE_NULL for free slot)
+    arena_size_t size;       // object size (next free slot + 1 for free slot)
+    uint32_t     alignment;
+    uint32_t     generation; // bumped on free, so stale refs stop resolving
+} ArenaTableEntry;
+
+/*
+    Object graph description for `arena_evacuate`.
+    Trace function returns size of `object` and calls `visit(&field, ctx)` for every pointer field of it.
+    `visit` is NULL when only the layout is needed, then `alignment` points to ARENA_ALIGN_DEFAULT
+    and should be overwritten for objects that need more (it is NULL otherwise).
+    Pointer fields must point to the start of an object.
+*/
+typedef void (*ArenaVisitFn)(void **slot, void *ctx);
+typedef arena_size_t (*ArenaTraceFn)(void *object, size_t *alignment, ArenaVisitFn visit, void *ctx);
+
+typedef struct ArenaRelocEntry {
+    arena_ptr_t  old_base;  // chunk base before `arena_flatten`
+    arena_size_t size;      // bytes used in that chunk
+    arena_ptr_t  new_base;  // where those bytes live now
+} ArenaRelocEntry;
+
+typedef struct ArenaRelocMap {
+    ArenaRelocEntry *entries; // sorted by `old_base`
+    uint32_t        count;
+} ArenaRelocMap;
+
+typedef struct ArenaGenStats {
+    size_t       cycles;           // finished nursery cycles
+    arena_size_t allocated_bytes;  // bytes allocated in nursery (all cycles)
+    arena_size_t promoted_bytes;   // bytes copied into tenured (all cycles)
+    size_t       promoted_objects;
+    arena_size_t cycle_allocated;  // bytes allocated in nursery in current cycle
+    arena_size_t cycle_promoted;   // bytes promoted in current cycle
+} ArenaGenStats;
+
+typedef struct ArenaGen {
+    Arena         nursery;    // short lived objects, rolled back every cycle (keep it cache sized)
+    Arena         tenured;    // chunky arena for survivors
+    ArenaMark     cycle_mark; // nursery position at the start of the cycle
+    ArenaGenStats stats;
+} ArenaGen;
+
+/*
+    Snapshot file layout:
+    [ header page ][ chunk 0 region ][ chunk 1 region ] ...
+    Every region is page aligned and holds chunk image (header + used bytes) at the same in-page offset
+    as the original chunk had, so it can be mapped back at the original address. Original address of
+    chunk N+1 is `next` field of chunk N image. Unused chunk tail is a hole in the file.
+*/
+#define ARENA_SNAPSHOT_MAGIC   0x504E534E45524141ull // "AARENSNP"
+#define ARENA_FILE_MAGIC       0x4C49464E45524141ull // "AARENFIL", same header, regions in allocation order
+#define ARENA_SNAPSHOT_VERSION 1u
+
+typedef struct ArenaSnapshotHeader {
+    uint64_t     magic;
+    uint32_t     version;
+    uint32_t     chunk_count;
+    uint64_t     page_size;
+    uint64_t     head_address;    // original address of the head chunk
+    arena_size_t max_capacity;
+    arena_size_t growth_factor;
+    arena_size_t epoch;
+    uint32_t     growth_contract;
+    uint32_t     flags;
+    uint32_t     alloc_type;
+    uint32_t     chunk_header_size;
+} ArenaSnapshotHeader;
+
+typedef struct ArenaSharedHeader {
+    uint64_t     magic;           // stored last by creator, attach fails until it is set
+    uint32_t     version;
+    uint32_t     page_size;
+    uint64_t     size;            // whole mapping: header page + chunk
+    arena_size_t epoch;           // bumped atomically by `arena_reset` in any process
+} ArenaSharedHeader;
+
+#define ARENA_SHARED_MAGIC     0x4D48534E45524141ull // "AARENSHM"
+#define ARENA_SHARED_VERSION   1u
+
+typedef enum ArenaLoadFlag : uint32_t {
+    ARENA_LOAD_DEFAULT = 0,      // map big files read only (chunky arenas), copy the rest
+    ARENA_LOAD_MMAP    = 1 << 0, // always map, fails for arenas that can not own extra chunks
+    ARENA_LOAD_COPY    = 1 << 1, // always copy, data is writable
+    ARENA_LOAD_DIRECT  = 1 << 2, // copy with O_DIRECT (page cache bypass), plain read when not supported
+} ArenaLoadFlag;
+
+#define ARENA_LOAD_MMAP_THRESHOLD  (arena_size_t)0x100000 // 1MB, smaller files are copied
+#define ARENA_LOAD_PADDING         64                     // zero bytes after data, safe SIMD over-read
+#define ARENA_LOAD_DIRECT_ALIGN    4096                   // buffer, offset and length alignment for O_DIRECT
+
+typedef struct ArenaSpan {
+    uint8_t      *data;   // data[size] is 0, followed by at least ARENA_LOAD_PADDING zero bytes
+    arena_size_t size;
+    bool         mapped;  // read only file mapping, lives until arena_destroy
+} ArenaSpan;
+
+typedef struct ArenaTable {
+    Arena           arena;          // object storage, replaced by `arena_compact`
+    ArenaConfig     config;         // used to create fresh storage on compaction
+    ArenaTableEntry *entries;
+    uint32_t        entry_count;
+    uint32_t        entry_capacity;
+    uint32_t        free_slot;      // head of free slot list (slot + 1, zero if empty)
+    arena_size_t    live_bytes;     // bytes of objects reachable through the table
+    arena_size_t    dead_bytes;     // bytes of freed objects still occupying storage
+} ArenaTable;
+
+static inline Arena arena_create_ex(ArenaConfig config);
+static inline ArenaConfig arena_config_create(arena_size_t capacity, arena_size_t max_capacity, ArenaGrowthContract contract, size_t growth_factor, ArenaFlag flags);
+static inline Arena arena_create(arena_size_t capacity);
+static inline void arena_destroy(Arena *arena);
+static inline ArenaMemory arena_alloc(Arena *arena, arena_size_t size, size_t alignment);
+static inline void *arena_alloc_raw(Arena *arena, arena_size_t size, size_t alignment);
+static inline ArenaMemory arena_alloc_zero(Arena *arena, arena_size_t size, size_t alignment);
+static inline bool arena_reset(Arena *arena);
+static inline bool arena_grow(Arena *arena, arena_size_t min_required_size);
+static inline void *arena_memory_resolve(Arena *arena, ArenaMemory *memory);
+static inline ArenaMark arena_mark(const Arena *arena);
+static inline bool arena_restore(Arena *arena, ArenaMark mark, bool poison_memory);
+static inline ArenaHandle arena_alloc_handle(Arena *arena, arena_size_t size, size_t alignment);
+static inline ArenaHandle arena_handle_of(const Arena *arena, const void *ptr);
+static inline void *arena_handle_resolve(Arena *arena, ArenaHandle handle);
+static inline ArenaChunk *arena_chunk_of(const Arena *arena, const void *ptr);
+static inline bool arena_owns(const Arena *arena, const void *ptr);
+static inline ArenaTemp arena_temp_begin(Arena *arena);
+static inline bool arena_temp_end(ArenaTemp temp);
+static inline void arena_trim(Arena *arena);
+static inline bool arena_defer(Arena *arena, ArenaDeferFn fn, void *ctx);
+
+static inline ArenaTable arena_table_create(ArenaConfig config);
+static inline void arena_table_destroy(ArenaTable *table);
+static inline ArenaRef arena_table_alloc(ArenaTable *table, arena_size_t size, size_t alignment);
+static inline void *arena_table_get(ArenaTable *table, ArenaRef ref);
+static inline bool arena_table_free(ArenaTable *table, ArenaRef ref);
+static inline double arena_table_fragmentation(const ArenaTable *table);
+static inline bool arena_compact(ArenaTable *table);
+
+static inline bool arena_evacuate(Arena *from, Arena *to, void **roots, size_t root_count, ArenaTraceFn trace);
+static inline arena_size_t arena_used_bytes(const Arena *arena);
+
+static inline bool arena_flatten(Arena *arena, ArenaRelocMap *map_out, bool read_mostly);
+static inline void *arena_relocate_ptr(const ArenaRelocMap *map, const void *ptr);
+static inline void arena_reloc_map_destroy(ArenaRelocMap *map);
+
+static inline bool arena_freeze(Arena *arena, bool share);
+static inline bool arena_thaw(Arena *arena);
+
+static inline ArenaGen arena_gen_create(ArenaConfig nursery_config, ArenaConfig tenured_config);
+static inline void arena_gen_destroy(ArenaGen *gen);
+static inline void *arena_gen_alloc(ArenaGen *gen, arena_size_t size, size_t alignment);
+static inline void *arena_gen_promote(ArenaGen *gen, const void *object, arena_size_t size, size_t alignment);
+static inline bool arena_gen_promote_graph(ArenaGen *gen, void **roots, size_t root_count, ArenaTraceFn trace);
+static inline void arena_gen_cycle(ArenaGen *gen);
+static inline double arena_gen_survival_rate(const ArenaGen *gen);
+
+_ARENA_FORCE_INLINE void *arena_relptr32_get(const ArenaRelPtr32 *rel);
+_ARENA_FORCE_INLINE bool arena_relptr32_set(ArenaRelPtr32 *rel, const void *target);
+_ARENA_FORCE_INLINE void *arena_relptr64_get(const ArenaRelPtr64 *rel);
+_ARENA_FORCE_INLINE bool arena_relptr64_set(ArenaRelPtr64 *rel, const void *target);
+
+_ARENA_FORCE_INLINE ArenaCPtr arena_cptr_encode(const Arena *arena, const void *ptr);
+_ARENA_FORCE_INLINE void *arena_cptr_decode(const Arena *arena, ArenaCPtr cptr);
+
+static inline ArenaBufBuilder arena_buf_builder_create(arena_size_t capacity);
+static inline void arena_buf_builder_destroy(ArenaBufBuilder *builder);
+static inline bool arena_buf_builder_reset(ArenaBufBuilder *builder);
+static inline ArenaBufOffset arena_buf_add_struct(ArenaBufBuilder *builder, const void *data, uint32_t size, uint32_t alignment);
+static inline ArenaBufOffset arena_buf_add_vector(ArenaBufBuilder *builder, const void *items, uint32_t count, uint32_t item_size, uint32_t alignment);
+static inline ArenaBufOffset arena_buf_add_string(ArenaBufBuilder *builder, const char *str, uint32_t length);
+static inline void *arena_buf_at(ArenaBufBuilder *builder, ArenaBufOffset offset);
+static inline ArenaSpan arena_buf_finish(ArenaBufBuilder *builder, ArenaBufOffset root);
+static inline ArenaBufView arena_buf_view(const void *data, arena_size_t size);
+static inline const void *arena_buf_struct(const ArenaBufView *view, ArenaBufOffset offset, uint32_t size, uint32_t alignment);
+static inline const void *arena_buf_vector(const ArenaBufView *view, ArenaBufOffset offset, uint32_t item_size, uint32_t alignment, uint32_t *count);
+static inline const char *arena_buf_string(const ArenaBufView *view, ArenaBufOffset offset, uint32_t *length);
+
+static inline const char *arena_capacity_str(size_t capacity);
+static inline const char *arena_platform_str();
+static inline const char *arena_get_error(const Arena *arena);
+static inline const char *arena_error_str(ArenaError error);
+
+#if ARENA_PLATFORM == _ARENA_PLATFORM_UNIX
+static inline ArenaRing arena_ring_create(arena_size_t capacity);
+static inline void arena_ring_destroy(ArenaRing *ring);
+static inline void *arena_ring_alloc(ArenaRing *ring, arena_size_t size, size_t alignment);
+static inline void arena_ring_commit(ArenaRing *ring);
+static inline void *arena_ring_peek(const ArenaRing *ring, arena_size_t *available);
+static inline bool arena_ring_release(ArenaRing *ring, arena_size_t size);
+static inline bool arena_ring_release_to(ArenaRing *ring, const void *end);
+
+static inline ArenaError arena_snapshot_write(const Arena *arena, const char *path);
+static inline Arena arena_snapshot_map(const char *path);
+
+static inline Arena arena_create_file(const char *path, ArenaConfig config);
+static inline Arena arena_open_file(const char *path);
+static inline bool arena_sync(Arena *arena);
+static inline Arena arena_fork(Arena *parent);
+static inline bool arena_fork_commit(Arena *parent, Arena *child);
+
+static inline Arena arena_create_shared(const char *name, ArenaConfig config);
+static inline Arena arena_attach_shared(const char *name);
+static inline bool arena_shared_unlink(const char *name);
+
+static inline size_t arena_to_iovec(const Arena *arena, struct iovec *out, size_t n);
+static inline arena_size_t arena_readv_into(Arena *arena, int fd, arena_size_t size);
+static inline ArenaSpan arena_load_file(Arena *arena, const char *path, ArenaLoadFlag flags);
+static inline bool arena_spill_enable(Arena *arena, arena_size_t budget, const char *dir);
+
+static inline ArenaUring arena_uring_create(uint32_t entries);
+static inline void arena_uring_destroy(ArenaUring *ring);
+static inline bool arena_uring_register(ArenaUring *ring, const Arena *arena);
+static inline bool arena_uring_read(ArenaUring *ring, int fd, void *buffer, uint32_t size, uint64_t offset, uint64_t user_data);
+static inline bool arena_uring_write(ArenaUring *ring, int fd, const void *buffer, uint32_t size, uint64_t offset, uint64_t user_data);
+static inline int arena_uring_submit(ArenaUring *ring, uint32_t wait_count);
+static inline ArenaUringCompletion *arena_uring_reap(ArenaUring *ring, Arena *arena, size_t *count);
+#endif
+
+_ARENA_FORCE_INLINE long long arena_abs(long long value);
+
+#ifdef ARENA_USE_STD_STRING // if defined <string.h> functions will be used
+    #include <string.h>
+    #define arena_memcpy      memcpy
+    #define arena_memset      memset
+    #define arena_strdup      strdup
+    #define arena_strlen      strlen
+    #define arena_strlen_fast strlen
+#else
+    static inline void *arena_memcpy(void *dst, const void *src, size_t count);
+    static inline void *arena_memset(void *dst, int value, size_t size);
+    static inline char *arena_strdup(Arena *arena, const char *src);
+    static inline size_t arena_strlen(const char *str);
+    static inline size_t arena_strlen_fast(const char *str);
+#endif
+
+#define ARENA_IMPLEMENTATION
+#ifdef ARENA_IMPLEMENTATION
+
+#ifdef ARENA_LOGGING
+    #include <stdarg.h>
+    #include <stdio.h>
+    #define ARENA_LOG(fmt, ...) printf("[+] " fmt "\n", ##__VA_ARGS__)
+#else
+    #define ARENA_LOG(...)
+#endif
+
+#ifndef ARENA_ASSERT // debug only contract checks, define before including to override
+    #include <assert.h>
+    #define ARENA_ASSERT(expr) assert(expr)
+#endif
+
+_ARENA_FORCE_INLINE arena_size_t _arena_sadd(arena_size_t a, arena_size_t b, arena_size_t max)
+{
+    return (a > (max - b)) ? max : (a + b);
+}
+
+_ARENA_FORCE_INLINE arena_size_t _arena_ssub(arena_size_t a, arena_size_t b, arena_size_t min)
+{
+    return (a < (b + min)) ? min : (a - b);
+}
+
+_ARENA_FORCE_INLINE arena_size_t _arena_smul(arena_size_t a, arena_size_t b, arena_size_t max)
+{
+    return (a > (max / b)) ? max : (a * b);
+}
+
+_ARENA_FORCE_INLINE bool _arena_is_pow2(size_t value)
+{
+    return (value && !(value & (value - 1)));
+}
+
+_ARENA_FORCE_INLINE bool _arena_is_aligned_to(arena_size_t value, size_t alignment)
+{
+    return (alignment > 0) && ((value % alignment) == 0);
+}
+
+_ARENA_FORCE_INLINE arena_size_t _arena_align_up(arena_size_t value, size_t alignment)
+{
+    size_t a = alignment ? alignment : 1;
+    return (_arena_sadd(value, a - 1, ARENA_U64_MAX)) & ~(a - 1);
+}
+
+_ARENA_FORCE_INLINE size_t _arena_downcast_size(arena_size_t value, bool *overflow)
+{
+    if (overflow) *overflow = false;
+
+    #if ARENA_SIZE_MAX == ARENA_U32_MAX
+    // 32-bit system check
+    if (value > ARENA_SIZE_MAX) {
+        if (overflow) *overflow = true;
+        return ARENA_SIZE_MAX;
+    }
+    #endif
+
+    return (size_t)value;
+}
+
+_ARENA_FORCE_INLINE size_t _arena_get_platform_page_size()
+{
+    #if (ARENA_PLATFORM == _ARENA_PLATFORM_WIN32)
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    return si.dwPageSize;
+    #elif ARENA_PLATFORM == _ARENA_PLATFORM_UNIX
+    long ps = sysconf(_SC_PAGESIZE);
+    return ps > 0 ? (size_t)ps : ARENA_PAGE_DEFAULT_SIZE;
+    #else
+    return ARENA_PAGE_DEFAULT_SIZE;
+    #endif
+}
+
+_ARENA_FORCE_INLINE void _arena_set_error(Arena *arena, ArenaError flag)
+{
+    if (NULL != arena) {
+        arena->error = flag;
+    }
+}
+
+_ARENA_FORCE_INLINE Arena _arena_failed(ArenaError error)
+{
+    // empty arena carrying only the error, returned by constructors
+    Arena arena = ARENA_EMPTY;
+    arena.error = error;
+    return arena;
+}
+
+_ARENA_FORCE_INLINE size_t _arena_calc_chunk_real_size(arena_size_t capacity)
+{
+    return _arena_downcast_size(_arena_sadd(sizeof(ArenaChunk), capacity, ARENA_SIZE_MAX), NULL);
+}
+
+_ARENA_FORCE_INLINE arena_size_t _arena_calc_chunk_capacity(size_t chunk_real_size)
+{
+    return (arena_size_t)(chunk_real_size - sizeof(ArenaChunk));
+}
+
+static inline const char *arena_capacity_str(size_t capacity)
+{
+    switch (capacity) {
+        case ARENA_CAPACITY_1KB:       return "1KB";
+        case ARENA_CAPACITY_2KB:       return "2KB";
+        case ARENA_CAPACITY_4KB:       return "4KB";
+        case ARENA_CAPACITY_8KB:       return "8KB";
+        case ARENA_CAPACITY_16KB:      return "16KB";
+        case ARENA_CAPACITY_32KB:      return "32KB";
+        case ARENA_CAPACITY_64KB:      return "64KB";
+        case ARENA_CAPACITY_128KB:     return "128KB";
+        case ARENA_CAPACITY_256KB:     return "256KB";
+        case ARENA_CAPACITY_512KB:     return "512KB";
+        case ARENA_CAPACITY_1MB:       return "1MB";
+        case ARENA_CAPACITY_2MB:       return "2MB";
+        case ARENA_CAPACITY_4MB:       return "4MB";
+        case ARENA_CAPACITY_8MB:       return "8MB";
+        case ARENA_CAPACITY_16MB:      return "16MB";
+        case ARENA_CAPACITY_32MB:      return "32MB";
+        case ARENA_CAPACITY_64MB:      return "64MB";
+        case ARENA_CAPACITY_128MB:     return "128MB";
+        case ARENA_CAPACITY_256MB:     return "256MB";
+        case ARENA_CAPACITY_512MB:     return "512MB";
+        case ARENA_CAPACITY_1GB:       return "1GB";
+        case ARENA_CAPACITY_MAX:       return "8GB"; 
+        default:                       return "Custom";
+    }
+}
+
+static inline const char *arena_platform_str()
+{
+    switch (ARENA_PLATFORM) {
+        case _ARENA_PLATFORM_WIN32: return "WIN32";
+        case _ARENA_PLATFORM_WIN64: return "WIN64";
+        case _ARENA_PLATFORM_UNIX:  return "UNIX";
+        case _ARENA_PLATFORM_LIBC:  return "LIBC";
+        default:                    return "UNKNOWN";
+    }
+}
+
+static inline const char *arena_get_error(const Arena *arena)
+{
+    return arena_error_str(arena->error);
+}
+
+static inline const char *arena_error_str(ArenaError error)
+{
+    switch (error) {
+        case ARENA_ERROR_NONE:                 return "No errors.";
+        case ARENA_ERROR_ALIGNMENT_TOO_LARGE:  return "Alignment value is too big.";
+        case ARENA_ERROR_CHUNK_ALLOC_FAILED:   return "Failed to allocate memory chunk.";
+        case ARENA_ERROR_EPOCH_MISMATCH:       return "Epoch mismatch.";
+        case ARENA_ERROR_GROWTH_FORBIDDEN:     return "Growth forbidden. Use another growth contract.";
+        case ARENA_ERROR_INVALID_ALIGNMENT:    return "Invalid alignment value.";
+        case ARENA_ERROR_INVALID_CAPACITY:     return "Invalid capacity value.";
+        case ARENA_ERROR_REALLOC_FAILED:       return "Failed to reallocate memory chunk.";
+        case ARENA_ERROR_MAX_CAPACITY_REACHED: return "Growth forbidden. Max capacity reached.";
+        case ARENA_ERROR_OOM:                  return "Out of memory.";
+        case ARENA_ERROR_SIZE_OVERFLOW:        return "Size overflow.";
+        case ARENA_ERROR_SIZE_ZERO:            return "Zero size.";
+        case ARENA_ERROR_MAPPING_FAILED:       return "Failed to map memory.";
+        case ARENA_ERROR_RING_FULL:            return "Ring is full. Release some records first.";
+        case ARENA_ERROR_INVALID_HANDLE:       return "Invalid handle.";
+        case ARENA_ERROR_IO:                   return "I/O error.";
+        case ARENA_ERROR_SNAPSHOT_INVALID:     return "Invalid or incompatible snapshot.";
+        case ARENA_ERROR_SNAPSHOT_RELOCATED:   return "Snapshot mapped at different addresses. Raw pointers inside it are invalid.";
+        case ARENA_ERROR_SHARED_INVALID:       return "Invalid or uninitialized shared arena.";
+        case ARENA_ERROR_UNSUPPORTED:          return "Operation is not supported by this arena.";
+        case ARENA_ERROR_FORK_STALE:           return "Parent arena changed after fork.";
+        case ARENA_ERROR_FROZEN:               return "Arena is frozen (read only). Call `arena_thaw` first.";
+        case ARENA_ERROR_BUFFER_INVALID:       return "Serialized buffer is malformed (header, offset or bounds).";
+        default:                               return "Unknown";
+    }
+}
+
+static inline void *_arena_alloc_chunk(size_t chunk_capacity, uint32_t alloc_type)
+{
+    /*
+        Invariants:
+        - chunk.capacity <= chunk_real_size - sizeof(ArenaChunk)
+        - chunk.offset == 0
+        - chunk.next   == NULL
+    */
+    size_t page_size = _arena_get_platform_page_size();
+    (void)page_size; // only logged
+
+    ArenaChunk *chunk      = NULL;
+    size_t chunk_real_size = _arena_calc_chunk_real_size(chunk_capacity);
+
+    // to make actual assertion that actual chunk capacity >= chunk_capacity
+    if (_arena_calc_chunk_capacity(chunk_real_size) < chunk_capacity) {
+        ARENA_LOG("Critical error while allocating new chunk: allocation capacity is less than required capacity.");
+        return NULL;
+    }
+
+    if (alloc_type == ARENA_ALLOC_TYPE_BIG) {
+    #if ARENA_PLATFORM == _ARENA_PLATFORM_UNIX
+        chunk = (ArenaChunk*)mmap(
+            NULL, 
+            chunk_real_size,
+            PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS,
+            -1, 0
+        );
+        if (chunk == MAP_FAILED) goto exit_error;
+        ARENA_LOG("New chunk allocated with `nmap` as %zu bytes sized pages. Platform: %s Size: %zu", page_size, arena_platform_str(), chunk_real_size);
+    #elif (ARENA_PLATFORM == _ARENA_PLATFORM_WIN32)
+        chunk = VirtualAlloc(NULL, chunk_real_size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+        if (!chunk) goto exit_error;
+        ARENA_LOG("New chunk allocated with with `VirtualAlloc` as %zu bytes sized pages. Platform: %s Size: %zu", page_size, arena_platform_str(), chunk_real_size);
+    #elif ARENA_PLATFORM == _ARENA_PLATFORM_LIBC
+        chunk = malloc(chunk_real_size);
+        if (!chunk) goto exit_error;
+        ARENA_LOG("New chunk allocated with `malloc` as %zu bytes sized pages. Platform: %s Size: %zu", page_size, arena_platform_str(), chunk_real_size);
+    #else
+        #error("Failed to apply platform dependent allocation. You are not supposed to see this error.")
+    #endif
+    } else {
+        chunk = (ArenaChunk*)malloc(chunk_real_size); // small heap allocation
+        if (!chunk) goto exit_error;
+        ARENA_LOG("New chunk allocated with size of %d bytes. Platform: %s", chunk_real_size, arena_platform_str());
+    }
+
+    chunk->next     = NULL;
+    chunk->offset   = 0;
+    chunk->index    = 0;
+    chunk->backing  = ARENA_CHUNK_BACKING_DEFAULT;
+    chunk->capacity = _arena_calc_chunk_capacity(chunk_real_size);
+
+    ARENA_LOG("Chunk: base:%p capacity:%d", chunk->base, chunk->capacity);
+
+    return chunk;
+
+exit_error:
+    ARENA_LOG("Failed to allocate arena chunk.");
+    return NULL;
+}
+
+_ARENA_FORCE_INLINE size_t _arena_calc_reserve_size(arena_size_t max_capacity)
+{
+    return (size_t)_arena_align_up(_arena_calc_chunk_real_size(max_capacity), _arena_get_platform_page_size());
+}
+
+static inline ArenaChunk *_arena_alloc_reserved_chunk(size_t capacity, arena_size_t max_capacity)
+{
+    // reserves address space for max_capacity, commits only first `capacity` bytes
+    size_t reserve_size = _arena_calc_reserve_size(max_capacity);
+    size_t commit_size  = _arena_calc_reserve_size(capacity);
+    if (commit_size > reserve_size) commit_size = reserve_size;
+
+    ArenaChunk *chunk = NULL;
+#if ARENA_PLATFORM == _ARENA_PLATFORM_UNIX
+    chunk = (ArenaChunk*)mmap(NULL, reserve_size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (chunk == MAP_FAILED) return NULL;
+    if (mprotect(chunk, commit_size, PROT_READ | PROT_WRITE) != 0) {
+        munmap(chunk, reserve_size);
+        return NULL;
+    }
+#elif (ARENA_PLATFORM == _ARENA_PLATFORM_WIN32)
+    chunk = VirtualAlloc(NULL, reserve_size, MEM_RESERVE, PAGE_NOACCESS);
+    if (!chunk) return NULL;
+    if (!VirtualAlloc(chunk, commit_size, MEM_COMMIT, PAGE_READWRITE)) {
+        VirtualFree(chunk, 0, MEM_RELEASE);
+        return NULL;
+    }
+#else
+    // nothing to reserve with, commit everything
+    commit_size = reserve_size;
+    chunk = malloc(reserve_size);
+    if (!chunk) return NULL;
+#endif
+
+    chunk->next     = NULL;
+    chunk->offset   = 0;
+    chunk->index    = 0;
+    chunk->backing  = ARENA_CHUNK_BACKING_RESERVED;
+    chunk->capacity = _arena_calc_chunk_capacity(commit_size);
+
+    ARENA_LOG("Address space reserved at: %p Reserved: %zu Committed: %zu", chunk, reserve_size, commit_size);
+    return chunk;
+}
+
+static inline bool _arena_commit_reserved_chunk(const Arena *arena, ArenaChunk *chunk, arena_size_t min_capacity)
+{
+    // commits pages in place, at least `growth_factor` bytes at once
+    size_t page_size    = _arena_get_platform_page_size();
+    size_t reserve_size = _arena_calc_reserve_size(arena->max_capacity);
+    size_t old_size     = _arena_calc_chunk_real_size(chunk->capacity);
+    size_t new_size     = _arena_calc_reserve_size(min_capacity);
+    size_t step_size    = (size_t)_arena_align_up(old_size + arena->growth_factor, page_size);
+
+    if (new_size < step_size) new_size = step_size;
+    if (new_size > reserve_size) new_size = reserve_size;
+    if (_arena_calc_chunk_capacity(new_size) < min_capacity) return false;
+
+#if ARENA_PLATFORM == _ARENA_PLATFORM_UNIX
+    if (mprotect((uint8_t*)chunk + old_size, new_size - old_size, PROT_READ | PROT_WRITE) != 0) return false;
+#elif (ARENA_PLATFORM == _ARENA_PLATFORM_WIN32)
+    if (!VirtualAlloc((uint8_t*)chunk + old_size, new_size - old_size, MEM_COMMIT, PAGE_READWRITE)) return false;
+#endif
+
+    chunk->capacity = _arena_calc_chunk_capacity(new_size);
+    ARENA_LOG("Reserved chunk committed up to: %zu bytes", new_size);
+    return true;
+}
+
+static inline void _arena_free_chunk(const Arena *arena, ArenaChunk *chunk)
+{
+    ARENA_LOG("Chunk memory released at: %p", chunk);
+    switch (chunk->backing) {
+    #if ARENA_PLATFORM == _ARENA_PLATFORM_UNIX
+        case ARENA_CHUNK_BACKING_MAPPED:
+        case ARENA_CHUNK_BACKING_LOADED: {
+            // chunk may start in the middle of its first page
+            size_t page_size = _arena_get_platform_page_size();
+            arena_ptr_t start = (arena_ptr_t)chunk & ~(arena_ptr_t)(page_size - 1);
+            munmap((void*)start, ((arena_ptr_t)chunk - start) + _arena_calc_chunk_real_size(chunk->capacity));
+        } return;
+
+        case ARENA_CHUNK_BACKING_FILE:
+        case ARENA_CHUNK_BACKING_SPILLED: {
+            munmap(chunk, _arena_calc_chunk_real_size(chunk->capacity));
+        } return;
+
+        case ARENA_CHUNK_BACKING_SHARED: {
+            ArenaSharedHeader *header = (ArenaSharedHeader*)((uint8_t*)chunk - _arena_get_platform_page_size());
+            munmap(header, header->size);
+        } return;
+    #endif
+        case ARENA_CHUNK_BACKING_RESERVED: {
+        #if ARENA_PLATFORM == _ARENA_PLATFORM_UNIX
+            munmap(chunk, _arena_calc_reserve_size(arena->max_capacity));
+        #elif (ARENA_PLATFORM == _ARENA_PLATFORM_WIN32)
+            VirtualFree(chunk, 0, MEM_RELEASE);
+        #else
+            free(chunk);
+        #endif
+        } return;
+
+        default: break;
+    }
+
+    if (arena->alloc_type == ARENA_ALLOC_TYPE_BIG) {
+    #if (ARENA_PLATFORM == _ARENA_PLATFORM_WIN32)
+        VirtualFree(chunk, 0, MEM_RELEASE);
+    #elif ARENA_PLATFORM == _ARENA_PLATFORM_UNIX
+        munmap(chunk, _arena_calc_chunk_real_size(chunk->capacity));
+    #elif ARENA_PLATFORM == _ARENA_PLATFORM_LIBC
+        free(chunk);
+    #endif
+    } else {
+        free(chunk);
+    }
+}
+
+#if ARENA_PLATFORM == _ARENA_PLATFORM_UNIX
+static inline int _arena_memfd_create(const char *name)
+{
+    #if defined(__linux__) && defined(SYS_memfd_create)
+    int memfd = (int)syscall(SYS_memfd_create, name, 0x1u /* MFD_CLOEXEC */);
+    if (memfd >= 0) return memfd;
+    #endif
+
+    // no memfd here, fallback to unlinked POSIX shared memory object named "/<name>-<pid>-<counter>"
+    static uint32_t counter = 0;
+    char shm_name[64] = { '/' };
+    size_t len = 1;
+    while (*name && len < sizeof(shm_name) - 35) shm_name[len++] = *name++; // room for two "-<16 hex>" tags and NUL
+
+    uint64_t tags[2] = { (uint64_t)getpid(), (uint64_t)counter++ };
+    for (int t = 0; t < 2; ++t) {
+        shm_name[len++] = '-';
+        for (int shift = 60; shift >= 0; shift -= 4) {
+            shm_name[len++] = "0123456789abcdef"[(tags[t] >> shift) & 0xF];
+        }
+    }
+    shm_name[len] = '\0';
+
+    int fd = shm_open(shm_name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd >= 0) shm_unlink(shm_name);
+    return fd;
+}
+
+static inline bool _arena_pwrite_all(int fd, const void *data, size_t size, off_t offset)
+{
+    const uint8_t *p = (const uint8_t*)data;
+    while (size > 0) {
+        ssize_t written = pwrite(fd, p, size, offset);
+        if (written <= 0) return false;
+        p += written; size -= (size_t)written; offset += written;
+    }
+    return true;
+}
+
+static inline bool _arena_pread_all(int fd, void *data, size_t size, off_t offset)
+{
+    uint8_t *p = (uint8_t*)data;
+    while (size > 0) {
+        ssize_t got = pread(fd, p, size, offset);
+        if (got <= 0) return false;
+        p += got; size -= (size_t)got; offset += got;
+    }
+    return true;
+}
+
+static inline ArenaSnapshotHeader _arena_file_header(const Arena *arena, uint64_t magic)
+{
+    return (ArenaSnapshotHeader){
+        .magic             = magic,
+        .version           = ARENA_SNAPSHOT_VERSION,
+        .chunk_count       = arena->chunk_count,
+        .page_size         = _arena_get_platform_page_size(),
+        .head_address      = (uint64_t)(arena_ptr_t)arena->head_chunk,
+        .max_capacity      = arena->max_capacity,
+        .growth_factor     = arena->growth_factor,
+        .epoch             = arena->epoch,
+        .growth_contract   = arena->growth_contract,
+        .flags             = arena->flags,
+        .alloc_type        = arena->alloc_type,
+        .chunk_header_size = sizeof(ArenaChunk)
+    };
+}
+
+static inline ArenaChunk *_arena_alloc_file_chunk(Arena *arena, arena_size_t capacity)
+{
+    // appends new page aligned region to arena file and maps it shared
+    size_t page_size   = _arena_get_platform_page_size();
+    size_t region_size = (size_t)_arena_align_up(_arena_calc_chunk_real_size(capacity), page_size);
+    off_t  region      = (off_t)arena->file_size;
+
+    // allocate blocks up front so writes through the mapping can't hit ENOSPC (SIGBUS),
+    // sparse file only where the filesystem can't preallocate at all
+    int status = posix_fallocate(arena->fd, region, (off_t)region_size);
+    if (status == EOPNOTSUPP || status == EINVAL) status = ftruncate(arena->fd, region + (off_t)region_size);
+    if (status != 0) {
+        _arena_set_error(arena, ARENA_ERROR_IO);
+        return NULL;
+    }
+
+    ArenaChunk *chunk = (ArenaChunk*)mmap(NULL, region_size, PROT_READ | PROT_WRITE, MAP_SHARED, arena->fd, region);
+    if (chunk == MAP_FAILED) {
+        _arena_set_error(arena, ARENA_ERROR_MAPPING_FAILED);
+        return NULL;
+    }
+
+    chunk->next     = NULL;
+    chunk->offset   = 0;
+    chunk->index    = 0;
+    chunk->backing  = ARENA_CHUNK_BACKING_FILE;
+    chunk->capacity = _arena_calc_chunk_capacity(region_size);
+
+    arena->file_size += region_size;
+    ARENA_LOG("New file chunk mapped at: %p File offset: %lld Size: %zu", chunk, (long long)region, region_size);
+    return chunk;
+}
+
+static inline bool _arena_file_write_header(Arena *arena)
+{
+    // chunks cached by `arena_restore` are not part of the chain on reopen
+    // (frozen arenas marked them in `arena_freeze`, their headers are read only now)
+    for (ArenaChunk *chunk = arena->free_chunks; chunk != NULL; chunk = chunk->next) {
+        if (chunk->index != ARENA_U32_MAX) chunk->index = ARENA_U32_MAX;
+    }
+
+    ArenaSnapshotHeader header = _arena_file_header(arena, ARENA_FILE_MAGIC);
+    return _arena_pwrite_all(arena->fd, &header, sizeof(header), 0);
+}
+#endif
+
+static inline size_t _arena_calc_realloc_size(const Arena *arena, arena_size_t required_chunk_capacity)
+{
+    arena_size_t cur_capacity = arena->last_chunk->capacity; // starting from the current capacity
+
+    while (cur_capacity < required_chunk_capacity && cur_capacity < arena->max_capacity) {
+        // there will be no overflow and no inf loop
+        // because _arena_smul will return mul result or max capacity and loop will break
+        cur_capacity = _arena_smul(cur_capacity, arena->growth_factor, arena->max_capacity);
+    }
+
+    bool overflow = false;
+    size_t realloc_size = _arena_downcast_size(cur_capacity, &overflow);
+    if ((arena->flags & ARENA_FLAG_DEBUG) && overflow == true) {
+        ARENA_LOG("Warning: Overflow catched in `%s` while downcasting. Max system integer size will be returned.", __func__);
+    }
+
+    return _arena_calc_chunk_real_size(realloc_size); // returns real alloc size (chunk metadata + capacity)
+}
+
+static inline ArenaChunk *_arena_realloc(Arena* arena, size_t required_chunk_capacity)
+{
+    ArenaChunk *new_chunk = NULL;
+    ArenaChunk *old_chunk = arena->last_chunk;
+
+    size_t realloc_size = _arena_calc_realloc_size(arena, required_chunk_capacity); // real size of new chunk to realloc
+    size_t free_size    = _arena_calc_chunk_real_size(arena->last_chunk->capacity); // real size of old chunk to free
+    size_t memcpy_size  = free_size; // real size of copiable memory
+    
+    if (old_chunk->backing != ARENA_CHUNK_BACKING_DEFAULT) {
+        // memory is not ours to realloc (e.g. mapped snapshot), move it to regular chunk
+        new_chunk = (ArenaChunk*)_arena_alloc_chunk(_arena_calc_chunk_capacity(realloc_size), arena->alloc_type);
+        if (!new_chunk) return NULL;
+        arena_memcpy(new_chunk, old_chunk, memcpy_size);
+        _arena_free_chunk(arena, old_chunk);
+        new_chunk->backing = ARENA_CHUNK_BACKING_DEFAULT;
+    } else if (arena->alloc_type == ARENA_ALLOC_TYPE_BIG) {
+    #if (ARENA_PLATFORM == _ARENA_PLATFORM_WIN32)
+        new_chunk = (ArenaChunk*)VirtualAlloc(NULL, realloc_size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+        if (!new_chunk) return NULL;
+        arena_memcpy(new_chunk, old_chunk, memcpy_size);
+        VirtualFree(old_chunk, free_size, MEM_RELEASE);
+    #elif ARENA_PLATFORM == _ARENA_PLATFORM_UNIX
+        new_chunk = (ArenaChunk*)mmap(NULL, realloc_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (new_chunk == MAP_FAILED) return NULL;
+        arena_memcpy(new_chunk, old_chunk, memcpy_size);
+        munmap(old_chunk, free_size);
+    #elif ARENA_PLATFORM == _ARENA_PLATFORM_LIBC
+        new_chunk = (ArenaChunk*)realloc(old_chunk, realloc_size);
+        if (!new_chunk) return NULL;
+    #endif
+    } else {
+        new_chunk = (ArenaChunk*)realloc(old_chunk, realloc_size);
+        if (!new_chunk) return NULL;
+    }
+
+    new_chunk->capacity = realloc_size - sizeof(ArenaChunk);
+    arena->reserved     = new_chunk->capacity;
+    arena->head_chunk   = new_chunk;
+    arena->last_chunk   = new_chunk;
+    arena->remaps++;
+    if (arena->chunks) arena->chunks[0] = new_chunk;
+    // because for realloc contract we store capacity of only one chunk
+    // so `reserved` should be same as new chunk capacity (as we have only one chunk)
+
+    return new_chunk;
+}
+
+static inline size_t _arena_resolve_config(ArenaConfig *config)
+{
+    // returns first chunk capacity
+    if (config->capacity == ARENA_CAPACITY_CHOOSE_FOR_ME_PLS) config->capacity = ARENA_CAPACITY_DEFAULT;
+    // library owned flags describe how chunks were made, set only by `arena_create_shared` / `arena_freeze`
+    config->flags = (ArenaFlag)(config->flags & ~(ARENA_FLAG_SHARED | ARENA_FLAG_FROZEN));
+    config->max_capacity = config->max_capacity ? config->max_capacity : config->capacity;
+
+    // resolve contract
+    switch (config->growth_contract) {
+        case ARENA_GROWTH_CONTRACT_RESERVE: // growth factor is commit step
+        case ARENA_GROWTH_CONTRACT_CHUNKY: {
+            if (config->growth_factor < ARENA_GROWTH_FACTOR_CHUNKY_MIN) config->growth_factor = ARENA_GROWTH_FACTOR_CHUNKY_MIN;
+            if (config->growth_factor > ARENA_GROWTH_FACTOR_CHUNKY_MAX) config->growth_factor = ARENA_GROWTH_FACTOR_CHUNKY_MAX;
+        } break;
+
+        case ARENA_GROWTH_CONTRACT_REALLOC: {
+            if (config->growth_factor > ARENA_GROWTH_FACTOR_REALLOC_8X) config->growth_factor = ARENA_GROWTH_FACTOR_REALLOC_8X;
+            if (config->growth_factor < 2) config->growth_factor = ARENA_GROWTH_FACTOR_REALLOC_2X;
+        } break;
+
+        default: {
+            config->growth_factor = ARENA_GROWTH_FACTOR_NONE;
+        } break;
+    }
+
+    // 32-bit sys check
+    bool overflow = false;
+    size_t alloc_size = _arena_downcast_size(config->capacity, &overflow); // this is very important
+    if (overflow) {
+        // cannot allocate >4GB
+        config->max_capacity = ARENA_CAPACITY_4GB - 1;
+    }
+
+    return alloc_size;
+}
+
+static inline Arena arena_create_ex(ArenaConfig config)
+{
+    size_t alloc_size = _arena_resolve_config(&config);
+    
+    // finnaly allocate memory for arena
+    uint32_t alloc_type = (alloc_size > ARENA_PAGE_ALIGN_THRESHOLD) ? ARENA_ALLOC_TYPE_BIG : ARENA_ALLOC_TYPE_SMALL;
+
+    ArenaChunk *chunk = NULL;
+    if (config.growth_contract == ARENA_GROWTH_CONTRACT_RESERVE) {
+        alloc_type = ARENA_ALLOC_TYPE_BIG;
+        chunk = _arena_alloc_reserved_chunk(alloc_size, config.max_capacity);
+    } else {
+        chunk = (ArenaChunk*)_arena_alloc_chunk(alloc_size, alloc_type);
+    }
+    if (!chunk) return ARENA_EMPTY;
+
+    if (config.flags & ARENA_FLAG_FILLZEROES) arena_memset(chunk->base, 0, chunk->capacity);
+    
+    Arena arena = {};
+    arena.reserved        = chunk->capacity; // how much memory reserved in total
+    arena.max_capacity    = config.max_capacity;
+    arena.growth_factor   = config.growth_factor;
+    arena.growth_contract = config.growth_contract;
+    arena.flags           = config.flags;
+    arena.error           = ARENA_ERROR_NONE;
+    arena.alloc_type      = alloc_type;
+    arena.epoch           = 0;
+    arena.head_chunk      = chunk;
+    arena.last_chunk      = chunk;
+    arena.chunks          = NULL;
+    arena.chunks_sorted   = NULL;
+    arena.chunk_count     = 1;
+    arena.owned_count     = 1;
+    arena.chunk_capacity  = 0;
+    return arena;
+}
+
+static inline ArenaConfig arena_config_create(arena_size_t capacity, arena_size_t max_capacity, ArenaGrowthContract contract, size_t growth_factor, ArenaFlag flags)
+{
+    return (ArenaConfig){
+        .capacity        = capacity,
+        .max_capacity    = max_capacity,
+        .growth_contract = contract,
+        .growth_factor   = growth_factor,
+        .flags           = flags
+    };
+}
+
+static inline Arena arena_create(arena_size_t capacity)
+{
+    return arena_create_ex((ArenaConfig){
+        .capacity        = capacity,
+        .max_capacity    = ARENA_CAPACITY_256MB, // i like this number
+        .growth_contract = ARENA_GROWTH_CONTRACT_FIXED,
+        .growth_factor   = ARENA_GROWTH_FACTOR_NONE,
+        .flags           = ARENA_FLAG_NONE
+    });
+}
+
+/*
+    Chunk directory:
+    - `chunks`        chain order, chunks[i]->index == i, used by handles
+    - `chunks_sorted` every chunk owned by the arena (chain + cache) sorted by address, used by ownership queries
+    Both are allocated on first chunky growth. Until then `head_chunk` is the only chunk
+    and `_arena_chain` / `_arena_owned` point at it as at one element array.
+*/
+_ARENA_FORCE_INLINE ArenaChunk *const *_arena_chain(const Arena *arena)
+{
+    return arena->chunks ? arena->chunks : &arena->head_chunk;
+}
+
+_ARENA_FORCE_INLINE ArenaChunk *const *_arena_owned(const Arena *arena)
+{
+    return arena->chunks_sorted ? arena->chunks_sorted : &arena->head_chunk;
+}
+
+static inline bool _arena_reserve_chunk_dir(Arena *arena)
+{
+    if (arena->chunks && arena->owned_count < arena->chunk_capacity) return true;
+
+    uint32_t new_capacity = arena->chunk_capacity ? arena->chunk_capacity * 2 : 8;
+    if (new_capacity > ARENA_HANDLE_CHUNK_MASK) return false;
+
+    ArenaChunk **chunks = (ArenaChunk**)realloc(arena->chunks, new_capacity * sizeof(*chunks));
+    if (!chunks) return false;
+    if (!arena->chunks) chunks[0] = arena->head_chunk;
+    arena->chunks = chunks;
+
+    ArenaChunk **sorted = (ArenaChunk**)realloc(arena->chunks_sorted, new_capacity * sizeof(*sorted));
+    if (!sorted) return false; // `chunks` is still valid, just bigger than capacity says
+    if (!arena->chunks_sorted) sorted[0] = arena->head_chunk;
+    arena->chunks_sorted = sorted;
+
+    arena->chunk_capacity = new_capacity;
+    return true;
+}
+
+static inline uint32_t _arena_lower_bound_chunk(const Arena *arena, arena_ptr_t address)
+{
+    // index of the first owned chunk that starts above `address`
+    ArenaChunk *const *sorted = _arena_owned(arena);
+    uint32_t lo = 0, hi = arena->owned_count;
+    while (lo < hi) {
+        uint32_t mid = lo + ((hi - lo) >> 1);
+        if ((arena_ptr_t)sorted[mid] <= address) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+static inline void _arena_insert_owned_chunk(Arena *arena, ArenaChunk *chunk)
+{
+    // directory must be reserved
+    uint32_t at = _arena_lower_bound_chunk(arena, (arena_ptr_t)chunk);
+    for (uint32_t i = arena->owned_count; i > at; --i) {
+        arena->chunks_sorted[i] = arena->chunks_sorted[i - 1];
+    }
+    arena->chunks_sorted[at] = chunk;
+    arena->owned_count++;
+}
+
+static inline void _arena_remove_owned_chunk(Arena *arena, ArenaChunk *chunk)
+{
+    if (!arena->chunks_sorted) return;
+    uint32_t at = _arena_lower_bound_chunk(arena, (arena_ptr_t)chunk);
+    if (at == 0 || arena->chunks_sorted[at - 1] != chunk) return;
+    for (uint32_t i = at; i < arena->owned_count; ++i) {
+        arena->chunks_sorted[i - 1] = arena->chunks_sorted[i];
+    }
+    arena->owned_count--;
+}
+
+static inline void _arena_push_chunk(Arena *arena, ArenaChunk *chunk)
+{
+    // appends chunk to the chain, directory must be reserved
+    chunk->index = arena->chunk_count;
+    arena->chunks[arena->chunk_count++] = chunk;
+
+    arena->last_chunk->next = chunk;
+    arena->last_chunk = chunk;
+    arena->reserved += chunk->capacity;
+}
+
+static inline ArenaChunk *_arena_take_free_chunk(Arena *arena, arena_size_t min_capacity)
+{
+    // first fit, cache is short (only chunks dropped by restore live here)
+    for (ArenaChunk **link = &arena->free_chunks; *link != NULL; link = &(*link)->next) {
+        ArenaChunk *chunk = *link;
+        if (chunk->capacity >= min_capacity && arena->reserved + chunk->capacity <= arena->max_capacity) {
+            *link        = chunk->next;
+            chunk->next   = NULL;
+            chunk->offset = 0;
+            ARENA_LOG("Chunk reused from cache at: %p", chunk);
+            return chunk;
+        }
+    }
+    return NULL;
+}
+
+static inline ArenaChunk *_arena_new_chunk(Arena *arena, size_t capacity)
+{
+#if ARENA_PLATFORM == _ARENA_PLATFORM_UNIX
+    if (arena->backing == ARENA_CHUNK_BACKING_FILE) return _arena_alloc_file_chunk(arena, capacity);
+#endif
+    return (ArenaChunk*)_arena_alloc_chunk(capacity, arena->alloc_type);
+}
+
+#if ARENA_PLATFORM == _ARENA_PLATFORM_UNIX
+static inline bool _arena_spill_chunk(Arena *arena, ArenaChunk *chunk)
+{
+    // same bytes, now page cache of the spill file: kernel writes them back and evicts under pressure
+    size_t size = (size_t)_arena_align_up(_arena_calc_chunk_real_size(chunk->capacity), _arena_get_platform_page_size());
+    off_t at = (off_t)arena->file_size;
+
+    bool ok = ftruncate(arena->fd, at + (off_t)size) == 0 &&
+              _arena_pwrite_all(arena->fd, chunk, sizeof(ArenaChunk) + _arena_downcast_size(chunk->offset, NULL), at) &&
+              mmap(chunk, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, arena->fd, at) != MAP_FAILED;
+    if (!ok) return false;
+
+    chunk->backing = ARENA_CHUNK_BACKING_SPILLED;
+    arena->file_size += size;
+    arena->remaps++;
+#ifdef MADV_COLD
+    madvise(chunk, size, MADV_COLD);
+#endif
+    ARENA_LOG("Chunk spilled at: %p File offset: %lld", chunk, (long long)at);
+    return true;
+}
+
+static inline void _arena_spill(Arena *arena)
+{
+    // oldest chain chunks first, last one is still being filled
+    arena_size_t resident = 0;
+    ArenaChunk *const *owned = _arena_owned(arena);
+    for (uint32_t i = 0; i < arena->owned_count; ++i) {
+        if (owned[i]->backing == ARENA_CHUNK_BACKING_DEFAULT) resident += owned[i]->capacity;
+    }
+
+    ArenaChunk *const *chain = _arena_chain(arena);
+    for (uint32_t i = 0; i + 1 < arena->chunk_count && resident > arena->spill_budget; ++i) {
+        if (chain[i]->backing != ARENA_CHUNK_BACKING_DEFAULT) continue;
+        if (!_arena_spill_chunk(arena, chain[i])) {
+            ARENA_LOG("Failed to spill chunk at: %p", chain[i]);
+            return; // stays resident, growth itself succeeded
+        }
+        resident -= chain[i]->capacity;
+    }
+}
+#endif
+
+static inline void _arena_run_defers(Arena *arena, ArenaHandle stop)
+{
+    // newest first, head moves before each call so a callback never runs twice
+    while (arena->defer != ARENA_HANDLE_NULL && arena->defer != stop) {
+        uint32_t     index  = (uint32_t)((arena->defer >> ARENA_HANDLE_OFFSET_BITS) & ARENA_HANDLE_CHUNK_MASK) - 1;
+        arena_size_t offset = arena->defer & ARENA_HANDLE_OFFSET_MASK;
+        if (index >= arena->chunk_count) {
+            arena->defer = ARENA_HANDLE_NULL; // broken chain, nothing sane left to run
+            return;
+        }
+
+        ArenaDeferRecord *record = (ArenaDeferRecord*)(_arena_chain(arena)[index]->base + offset);
+        arena->defer = record->prev;
+        record->fn(record->ctx);
+    }
+}
+
+static inline void arena_destroy(Arena *arena)
+{
+    if (!arena || !arena->head_chunk) return;
+
+    _arena_run_defers(arena, ARENA_HANDLE_NULL);
+
+#if ARENA_PLATFORM == _ARENA_PLATFORM_UNIX
+    if (arena->backing == ARENA_CHUNK_BACKING_FILE) {
+        // keep the file reopenable, data itself is written back by the shared mappings
+        _arena_file_write_header(arena);
+    }
+#endif
+
+    ArenaChunk *const *owned = _arena_owned(arena);
+    for (uint32_t i = 0; i < arena->owned_count; ++i) {
+        _arena_free_chunk(arena, owned[i]);
+    }
+    free(arena->chunks);
+    free(arena->chunks_sorted);
+    free(arena->fork);
+
+#if ARENA_PLATFORM == _ARENA_PLATFORM_UNIX
+    if (arena->backing == ARENA_CHUNK_BACKING_FILE || arena->spill_budget) close(arena->fd);
+#endif
+
+    arena->backing                 = ARENA_CHUNK_BACKING_DEFAULT;
+    arena->fd                      = 0;
+    arena->file_size               = 0;
+    arena->spill_budget            = 0;
+    arena->fork                    = NULL;
+    arena->defer                   = ARENA_HANDLE_NULL;
+    arena->last_chunk              = NULL;
+    arena->head_chunk              = NULL;
+    arena->free_chunks             = NULL;
+    arena->chunks                  = NULL;
+    arena->chunks_sorted           = NULL;
+    arena->chunk_count             = 0;
+    arena->chunk_capacity          = 0;
+    arena->owned_count             = 0;
+    arena->remaps++;
+    arena->reserved                = 0;
+    arena->flags                   = ARENA_FLAG_NONE;
+    arena->growth_contract         = ARENA_GROWTH_CONTRACT_FIXED;
+    arena->growth_factor           = 0;
+    arena->max_capacity            = 0;
+    arena->alloc_type              = 0;
+    arena->error                   = ARENA_ERROR_NONE;
+    arena->debug.end               = NULL;
+    arena->debug.bytes_lost        = 0;
+    arena->debug.total_allocations = 0;
+
+    ARENA_LOG("Arena destroyed. Platform: %s", arena_platform_str());
+}
+
+static inline ArenaChunk *arena_chunk_of(const Arena *arena, const void *ptr)
+{
+    // O(log n) lookup of the chunk in the chain which memory contains `ptr`
+    if (!arena || !arena->head_chunk || !ptr) return NULL;
+
+    arena_ptr_t address = (arena_ptr_t)ptr;
+    uint32_t at = _arena_lower_bound_chunk(arena, address);
+    if (at == 0) return NULL;
+
+    ArenaChunk *chunk = _arena_owned(arena)[at - 1];
+    if (address < (arena_ptr_t)chunk->base || address >= (arena_ptr_t)chunk->base + chunk->capacity) return NULL;
+
+    // chunks sitting in the cache are owned but not in use
+    if (chunk->index >= arena->chunk_count || _arena_chain(arena)[chunk->index] != chunk) return NULL;
+
+    return chunk;
+}
+
+static inline bool arena_owns(const Arena *arena, const void *ptr)
+{
+    return arena_chunk_of(arena, ptr) != NULL;
+}
+
+static inline ArenaMemory arena_alloc(Arena *arena, arena_size_t size, size_t alignment)
+{
+    void *p = arena_alloc_raw(arena, size, alignment);
+    if (!p) return (ArenaMemory){};
+    return (ArenaMemory){
+        .chunk     = arena->last_chunk,
+        .data      = p,
+        .alignment = alignment,
+        .offset    = (arena_ptr_t)p - (arena_ptr_t)arena->last_chunk->base,
+        .size      = size,
+        .epoch     = arena->epoch
+    };
+}
+
+static inline void 
+_arena_calc_alloc_data(
+    ArenaChunk *last_chunk, arena_size_t size, 
+    size_t alignment, arena_ptr_t *address, 
+    arena_ptr_t *aligned_address, 
+    arena_size_t *new_offset, arena_size_t *lost_bytes)
+{
+    *address = (arena_ptr_t)last_chunk->base + last_chunk->offset;
+    *aligned_address = (arena_ptr_t)_arena_align_up((*address), alignment);
+    *lost_bytes = (arena_size_t)((*aligned_address) - (*address));
+    *new_offset = ((*aligned_address) - (arena_ptr_t)last_chunk->base) + size;
+}
+
+#if ARENA_PLATFORM == _ARENA_PLATFORM_UNIX
+_ARENA_FORCE_INLINE ArenaSharedHeader *_arena_shared_header(const Arena *arena)
+{
+    return (ArenaSharedHeader*)((uint8_t*)arena->head_chunk - _arena_get_platform_page_size());
+}
+
+static inline void *_arena_alloc_shared(Arena *arena, arena_size_t size, size_t alignment)
+{
+    // other processes bump the same offset, so claim the range with CAS instead of plain store
+    ArenaChunk        *chunk     = arena->head_chunk;
+    ArenaSharedHeader *header    = _arena_shared_header(arena);
+    arena_ptr_t       base       = (arena_ptr_t)chunk->base;
+    arena_ptr_t       aligned    = 0;
+    arena_size_t      new_offset = 0;
+    arena_size_t      epoch      = 0;
+
+    // a reset between the claim and the epoch read would stamp a pre-reset range with the new epoch
+    do {
+        epoch = _ARENA_ATOMIC_LOAD(&header->epoch);
+        arena_size_t offset = _ARENA_ATOMIC_LOAD(&chunk->offset);
+        do {
+            aligned    = (arena_ptr_t)_arena_align_up(base + offset, alignment);
+            new_offset = (arena_size_t)(aligned - base) + size;
+            if (new_offset > chunk->capacity || new_offset < offset) {
+                _arena_set_error(arena, ARENA_ERROR_GROWTH_FORBIDDEN);
+                return NULL;
+            }
+        } while (!_ARENA_ATOMIC_CAS(&chunk->offset, &offset, new_offset));
+    } while (_ARENA_ATOMIC_LOAD(&header->epoch) != epoch);
+
+    arena->epoch = epoch;
+    _arena_set_error(arena, ARENA_ERROR_NONE);
+    return (void*)aligned;
+}
+#endif
+
+static inline void *arena_alloc_raw(Arena *arena, arena_size_t size, size_t alignment)
+{
+    if (!arena || size == 0) return NULL;
+    if (!_arena_is_pow2(alignment)) {
+        _arena_set_error(arena, ARENA_ERROR_INVALID_ALIGNMENT);
+        return NULL;
+    }
+    // if alignment is forced then every address should be aligned to CPU cache line size
+    if (arena->flags & ARENA_FLAG_ENFORCE_ALIGNMENT)
+        alignment = ARENA_ALIGN_CACHELINE;
+    if (arena->flags & ARENA_FLAG_FROZEN) {
+        _arena_set_error(arena, ARENA_ERROR_FROZEN);
+        return NULL;
+    }
+
+#if ARENA_PLATFORM == _ARENA_PLATFORM_UNIX
+    if (arena->flags & ARENA_FLAG_SHARED) return _arena_alloc_shared(arena, size, alignment);
+#endif
+
+    arena_ptr_t  addr         = 0;
+    arena_ptr_t  aligned_addr = 0;
+    arena_size_t lost_bytes   = 0;
+    arena_size_t new_offset   = 0;
+    
+    _arena_calc_alloc_data(arena->last_chunk, size, alignment, &addr, &aligned_addr, &new_offset, &lost_bytes);
+    
+    arena_size_t alloc_size = size + lost_bytes;
+    if (new_offset > arena->last_chunk->capacity) {
+        bool has_grown = arena_grow(arena, alloc_size);
+        if (!has_grown) {
+            ARENA_LOG(
+                "Failed to allocate `%d` bytes on arena (OOM error. Requested: " ARENA_SIZE_FMT ", Reserved: " ARENA_SIZE_FMT ")",
+                size + lost_bytes, size, arena->reserved
+            );
+            return NULL;
+        }
+        // important recalc after growth !!!
+        _arena_calc_alloc_data(arena->last_chunk, size, alignment, &addr, &aligned_addr, &new_offset, &lost_bytes); 
+    }
+    
+    alloc_size = size + lost_bytes;
+    arena->last_chunk->offset = new_offset;
+    
+    ARENA_LOG(
+        "Allocated `%d` bytes on arena (align = %zu, loss = %d, requested = %d)",
+        alloc_size, alignment, lost_bytes, size
+    );
+    
+    if (arena->flags & ARENA_FLAG_DEBUG) {
+        arena->debug.end        = (uint8_t*)((arena_ptr_t)arena->last_chunk->base + new_offset);
+        arena->debug.bytes_lost += lost_bytes;
+        arena->debug.total_allocations++;
+    }
+
+    _arena_set_error(arena, ARENA_ERROR_NONE);
+    return (void*)aligned_addr;
+}
+
+static inline ArenaMemory arena_alloc_zero(Arena *arena, arena_size_t size, size_t alignment)
+{
+    ARENA_LOG("Arena `arena_alloc_zero` called.");
+
+    void *p = arena_alloc_raw(arena, size, alignment);
+    if (!p) return (ArenaMemory){};
+
+    arena_memset(p, 0, size);
+
+    return (ArenaMemory){
+        .chunk     = arena->last_chunk,
+        .data      = p,
+        .alignment = alignment,
+        .offset    = (arena_ptr_t)p - (arena_ptr_t)arena->last_chunk->base,
+        .size      = size,
+        .epoch     = arena->epoch
+    };
+}
+
+static inline bool arena_grow(Arena *arena, arena_size_t min_contiguous_size)
+{
+    if (!arena || min_contiguous_size < (arena->last_chunk->capacity - arena->last_chunk->offset)) return false;
+
+    if (arena->flags & ARENA_FLAG_FROZEN) {
+        _arena_set_error(arena, ARENA_ERROR_FROZEN);
+        return false;
+    }
+
+    if (arena->growth_contract == ARENA_GROWTH_CONTRACT_FIXED) {
+        _arena_set_error(arena, ARENA_ERROR_GROWTH_FORBIDDEN);
+        return false;
+    }
+
+    if (min_contiguous_size > arena->max_capacity) {
+        _arena_set_error(arena, ARENA_ERROR_MAX_CAPACITY_REACHED);
+        return false;
+    }
+    
+    switch (arena->growth_contract) {        
+        case ARENA_GROWTH_CONTRACT_RESERVE: {
+            arena_size_t required_capacity = min_contiguous_size + arena->last_chunk->offset;
+            if (required_capacity > arena->max_capacity) {
+                _arena_set_error(arena, ARENA_ERROR_MAX_CAPACITY_REACHED);
+                return false;
+            }
+            if (!_arena_commit_reserved_chunk(arena, arena->last_chunk, required_capacity)) {
+                _arena_set_error(arena, ARENA_ERROR_CHUNK_ALLOC_FAILED);
+                return false;
+            }
+            arena->reserved = arena->last_chunk->capacity;
+        } break;
+
+        case ARENA_GROWTH_CONTRACT_REALLOC: {
+            arena_size_t required_capacity = min_contiguous_size + arena->last_chunk->offset;
+            ArenaChunk *new_chunk = _arena_realloc(arena, required_capacity);
+            if (!new_chunk) {
+                _arena_set_error(arena, ARENA_ERROR_REALLOC_FAILED);
+                return false;
+            }
+            
+            arena->last_chunk = new_chunk;
+
+            ARENA_LOG(
+                "Arena reallocated at: %p\n"
+                "    Capacity:          " ARENA_SIZE_FMT "\n"
+                "    Growth factor:     " ARENA_SIZE_FMT "X\n"
+                "    Required capacity: " ARENA_SIZE_FMT "\n"
+                "    Offset:            " ARENA_SIZE_FMT "\n"
+                "    Base:              %p\n",
+                arena->last_chunk,
+                arena->last_chunk->capacity,
+                arena->growth_factor,
+                required_capacity,
+                arena->last_chunk->offset,
+                arena->last_chunk->base
+            );
+        } break;
+
+        case ARENA_GROWTH_CONTRACT_CHUNKY: {
+            arena_size_t required_capacity = min_contiguous_size;
+            if (!_arena_reserve_chunk_dir(arena)) {
+                _arena_set_error(arena, ARENA_ERROR_CHUNK_ALLOC_FAILED);
+                return false;
+            }
+
+            ArenaChunk *cached_chunk = _arena_take_free_chunk(arena, required_capacity);
+            if (cached_chunk) {
+                _arena_push_chunk(arena, cached_chunk);
+            #if ARENA_PLATFORM == _ARENA_PLATFORM_UNIX
+                if (arena->spill_budget) _arena_spill(arena);
+            #endif
+                break;
+            }
+
+            arena_size_t chunk_capacity = arena->growth_factor;
+            if (chunk_capacity < required_capacity) {
+                if (!(arena->flags & ARENA_FLAG_FIXED_CHUNK_SIZE)) {
+                    // add extra bytes to prevent alloc failure due to address alignment
+                    chunk_capacity = _arena_align_up(required_capacity, ARENA_ALIGN_512B);
+                } else {
+                    _arena_set_error(arena, ARENA_ERROR_OOM);
+                    return false;
+                }
+            }
+
+            ARENA_LOG("New chunk capacity: " ARENA_SIZE_FMT, chunk_capacity);
+
+            if (arena->reserved + chunk_capacity > arena->max_capacity) {
+                ARENA_LOG("Failed to allocate new chunk. Max capacity overflow.");
+                _arena_set_error(arena, ARENA_ERROR_OOM);
+                return false;
+            }
+
+            _arena_set_error(arena, ARENA_ERROR_NONE);
+            ArenaChunk *chunk = _arena_new_chunk(arena, _arena_downcast_size(chunk_capacity, NULL));
+            if (!chunk) {
+                // file backed chunks report their own failure (I/O or mapping)
+                if (arena->error == ARENA_ERROR_NONE) _arena_set_error(arena, ARENA_ERROR_CHUNK_ALLOC_FAILED);
+                return false;
+            }
+
+            _arena_insert_owned_chunk(arena, chunk);
+            _arena_push_chunk(arena, chunk);
+        #if ARENA_PLATFORM == _ARENA_PLATFORM_UNIX
+            if (arena->spill_budget) _arena_spill(arena);
+        #endif
+
+            ARENA_LOG(
+                "New chunk added at: %p\n"
+                "    Capacity:          " ARENA_SIZE_FMT "\n"
+                "    Growth factor:     " ARENA_SIZE_FMT "\n"
+                "    Required capacity: " ARENA_SIZE_FMT "\n"
+                "    Offset:            " ARENA_SIZE_FMT "\n"
+                "    Base:              %p\n",
+                chunk,
+                chunk->capacity,
+                arena->growth_factor,
+                required_capacity,
+                chunk->offset,
+                chunk->base
+            );
+        } break;
+
+        default: return false;
+    }
+
+    if (arena->flags & ARENA_FLAG_RESET_AFTER_GROW) arena_reset(arena); // Bye bye =D
+    
+    return true;
+}
+
+static inline void *arena_memory_resolve(Arena *arena, ArenaMemory *memory)
+{
+    if (!arena || !memory || !arena->head_chunk) return NULL;
+    if (memory->epoch != arena->epoch) {
+        _arena_set_error(arena, ARENA_ERROR_EPOCH_MISMATCH);
+        return NULL;
+    }    
+
+    if (arena->growth_contract == ARENA_GROWTH_CONTRACT_REALLOC) {
+        memory->chunk = arena->head_chunk;
+    }
+
+    memory->data = (void*)((arena_ptr_t)memory->chunk->base + memory->offset);
+    
+    return memory->data;
+}
+
+static inline bool arena_reset(Arena *arena)
+{
+    /*
+    - Invalidates all previous pointers
+    - Does not free the memory
+    - Chunky arena goes back to its head chunk, the rest waits in the chunk cache and is reused in order
+    - After a chunky reset `reserved` and `chunk_count` only cover the head chunk, cached chunks count again once growth reuses them
+    - Literally just resets arena (but with all previously allocated memory)
+    - O(1) =D
+    */
+    if (!arena || !arena->last_chunk) goto reset_failure;
+    if (arena->flags & ARENA_FLAG_FROZEN) {
+        _arena_set_error(arena, ARENA_ERROR_FROZEN);
+        goto reset_failure;
+    }
+    _arena_run_defers(arena, ARENA_HANDLE_NULL);
+
+#if ARENA_PLATFORM == _ARENA_PLATFORM_UNIX
+    if (arena->flags & ARENA_FLAG_SHARED) {
+        // epoch first, so handles of other processes go stale before memory is handed out again
+        arena->epoch = _ARENA_ATOMIC_FETCH_ADD(&_arena_shared_header(arena)->epoch, 1) + 1;
+        _ARENA_ATOMIC_STORE(&arena->head_chunk->offset, 0);
+        goto reset_success;
+    }
+#endif
+
+    if (arena->growth_contract == ARENA_GROWTH_CONTRACT_CHUNKY) {
+        // allocation only ever bumps the last chunk, so the chain has to be rewound to reuse it
+        ArenaChunk *head = arena->head_chunk;
+        if (head != arena->last_chunk) {
+            arena->last_chunk->next = arena->free_chunks;
+            arena->free_chunks      = head->next;
+            head->next              = NULL;
+            arena->last_chunk       = head;
+            arena->reserved         = head->capacity;
+            arena->chunk_count      = 1;
+        }
+        head->offset = 0;
+        arena->epoch++;
+        goto reset_success;
+    } else {
+        arena->last_chunk->offset = 0;
+        arena->epoch++;
+        goto reset_success;
+    }
+
+reset_failure:
+    ARENA_LOG("Arena reset failed");
+    return false;
+reset_success:
+    ARENA_LOG("Arena reset success");
+    return true;
+}
+
+#ifndef ARENA_USE_STD_STRING
+static inline void *arena_memcpy(void *dst, const void *src, size_t count)
+{
+    uint8_t *start = (uint8_t*)dst;
+    const uint8_t *from = (const uint8_t*)src;
+    if ((((arena_ptr_t)start ^ (arena_ptr_t)from) & 7) == 0) {
+        // same misalignment, bytes up to the word boundary then whole words
+        while (count && ((arena_ptr_t)start & 7)) { *start++ = *from++; count--; }
+        while (count >= 8) { // type cast ol trick
+            *(uint64_t*)start = *(const uint64_t*)from;
+            start += 8; from += 8;
+            count -= 8;
+        }
+    }
+
+    while (count--) *start++ = *from++;
+    
+    return dst;
+}
+
+static inline void *arena_memset(void *dst, int value, size_t size)
+{
+    // who said that fast algorithms should look readable?
+    if (!dst || size == 0) return NULL;
+
+    int word = 0;
+    uint64_t pattern64 = (uint8_t)value;
+    
+    if (size >= 0x4000) {
+        word = 8;
+        pattern64 |= (pattern64 << 8);
+        pattern64 |= (pattern64 << 16);
+        pattern64 |= (pattern64 << 32);
+    } else if (size >= 0x1000) {
+        word = 4;
+        pattern64 |= (pattern64 << 8);
+        pattern64 |= (pattern64 << 16);
+    }
+
+    uint8_t *p8 = (uint8_t*)dst;
+    
+    if (word) {
+        size_t offset = (uintptr_t)dst & (word-1);
+        
+        if (offset) {
+            size_t align = word - offset;
+            if (size < align) align = size;
+            for (size_t i = 0; i < align; ++i) *p8++ = (uint8_t)value;
+            size -= align;
+        }
+
+        if (word == 4) {
+            uint32_t *p32 = (uint32_t*)p8;
+            size_t blocks  = size / word;
+            uint32_t pattern32 = (uint32_t)pattern64;
+
+            while (blocks--) {
+                *p32++ = pattern32;
+            }
+
+            p8 = (uint8_t*)p32;
+            size = size % word;
+        } else if (word == 8) {
+             uint64_t *p64 = (uint64_t*)p8;
+             size_t blocks = size / word;
+
+            while (blocks--) {
+                *p64++ = pattern64;
+            }
+
+            p8 = (uint8_t*)p64;
+            size = size % word;
+        }
+
+        while (size--) {
+            *p8++ = (uint8_t)value;
+        }
+    } else {
+        while (size--) {
+            *p8++ = (uint8_t)value;
+        }
+    }
+
+    return dst;
+}
+
+static inline char *arena_strdup(Arena *arena, const char *src)
+{
+    if (!arena || arena->reserved == 0 || !src) return NULL;
+    void *dst = arena_alloc_raw(arena, arena_strlen(src)+1, alignof(char));
+    if (dst) arena_memcpy(dst, src, arena_strlen(src)+1);
+    return (char*)dst;
+}
+
+static inline size_t arena_strlen(const char *str) // USA international debt growth simulator
+{
+    size_t usa_international_debt = 0;
+    while (*str++) {
+        usa_international_debt++;
+    }
+    return usa_international_debt;
+}
+
+#define _ARENA_HAS_ZERO_BYTE(v) (((v) - 0x0101010101010101ull) & ~(v) & 0x8080808080808080ull)
+// 1 nanosec faster on O0, O1 and O2 than arena_strlen (still slower than libc strlen)
+static inline size_t arena_strlen_fast(const char *str)
+{
+    const char *p = str;
+    while ((arena_ptr_t)p & 7) {
+        if (*p == 0) return p - str;
+        p++;
+    }
+
+    const uint64_t *word = (uint64_t*)p;
+    while (1) {
+        uint64_t value = *word;
+        if (_ARENA_HAS_ZERO_BYTE(value)) break;
+        word++;
+    }
+
+    const char *byte = (const char*)word;
+    for (int i = 0; i < 8; ++i) {
+        if (byte[i] == 0) return (byte + i) - str;
+    }
+
+    return 0; // should be unreachable actually
+}
+#endif
+
+_ARENA_FORCE_INLINE long long arena_abs(long long value)
+{
+    long long result;
+    const int mask = value >> (sizeof(value) * CHAR_BIT - 1);
+    result = (value ^ mask) - mask;
+    return result;
+}
+
+_ARENA_FORCE_INLINE ArenaMark arena_mark(const Arena *arena)
+{
+    return (ArenaMark){ 
+        .chunk    = arena->last_chunk,
+        .offset   = arena->last_chunk->offset,
+        .epoch    = arena->epoch,
+        .reserved = arena->reserved,
+        .defer    = arena->defer
+    };
+}
+
+static inline bool arena_restore(Arena *arena, ArenaMark mark, bool poison_memory)
+{
+    /*
+    - Rolls arena back to the exact position of the mark
+    - Marks must be restored in LIFO order (nesting is fine)
+    - Chunks allocated after the mark go to the chunk cache (see `arena_trim`)
+    - Callbacks deferred after the mark run first (newest first)
+    - O(1) unless `poison_memory` is set or callbacks were deferred
+    */
+    if (!arena || !arena->last_chunk || arena->epoch != mark.epoch) return false;
+    if (arena->flags & ARENA_FLAG_FROZEN) {
+        _arena_set_error(arena, ARENA_ERROR_FROZEN);
+        return false;
+    }
+
+    // realloc contract moves the only chunk around so the marked pointer may be stale
+    ArenaChunk *chunk = (arena->growth_contract == ARENA_GROWTH_CONTRACT_REALLOC) ? arena->head_chunk : mark.chunk;
+    if (!chunk || mark.offset > chunk->offset) return false;
+
+    _arena_run_defers(arena, mark.defer);
+
+    if (poison_memory) {
+        arena_memset(chunk->base + mark.offset, _ARENA_POISON_RESET, chunk->offset - mark.offset);
+        ArenaChunk *const *chain = _arena_chain(arena);
+        for (uint32_t i = chunk->index + 1; i < arena->chunk_count; ++i) {
+            arena_memset(chain[i]->base, _ARENA_POISON_RESET, chain[i]->offset);
+        }
+    }
+
+    if (chunk != arena->last_chunk) {
+        arena->last_chunk->next = arena->free_chunks;
+        arena->free_chunks      = chunk->next;
+        chunk->next             = NULL;
+        arena->last_chunk       = chunk;
+        arena->reserved         = mark.reserved;
+        arena->chunk_count      = chunk->index + 1;
+    }
+
+    chunk->offset = mark.offset;
+    return true;
+}
+
+_ARENA_FORCE_INLINE ArenaHandle _arena_handle_make(const Arena *arena, const ArenaChunk *chunk, const void *p)
+{
+    arena_size_t offset = (arena_ptr_t)p - (arena_ptr_t)chunk->base;
+    if (offset > ARENA_HANDLE_OFFSET_MASK) return ARENA_HANDLE_NULL;
+
+    return ((arena->epoch & ARENA_HANDLE_EPOCH_MASK) << (ARENA_HANDLE_OFFSET_BITS + ARENA_HANDLE_CHUNK_BITS))
+         | ((ArenaHandle)(chunk->index + 1) << ARENA_HANDLE_OFFSET_BITS)
+         | offset;
+}
+
+static inline ArenaHandle arena_alloc_handle(Arena *arena, arena_size_t size, size_t alignment)
+{
+    void *p = arena_alloc_raw(arena, size, alignment);
+    if (!p) return ARENA_HANDLE_NULL;
+
+    ArenaHandle handle = _arena_handle_make(arena, arena->last_chunk, p);
+    if (handle == ARENA_HANDLE_NULL) _arena_set_error(arena, ARENA_ERROR_INVALID_HANDLE);
+    return handle;
+}
+
+static inline bool arena_defer(Arena *arena, ArenaDeferFn fn, void *ctx)
+{
+    /*
+    - Registers `fn(ctx)` to run when the memory it was registered with goes away:
+      `arena_reset`, `arena_restore` to a mark taken before this call, `arena_destroy`
+    - Costs one bump allocation, callbacks run newest first and must not allocate on this arena
+    - The record follows realloc moves, `ctx` does not: keep it outside realloc arenas (`arena_flatten` and `arena_compact` refuse while records are pending)
+    - Not for shared arenas (function pointers are per process) and `arena_fork` children
+    */
+    if (!arena || !arena->head_chunk || !fn) return false;
+    if ((arena->flags & ARENA_FLAG_SHARED) || arena->fork) {
+        _arena_set_error(arena, ARENA_ERROR_UNSUPPORTED);
+        return false;
+    }
+
+    ArenaDeferRecord *record = (ArenaDeferRecord*)arena_alloc_raw(arena, sizeof(ArenaDeferRecord), alignof(ArenaDeferRecord));
+    if (!record) return false;
+
+    record->fn   = fn;
+    record->ctx  = ctx;
+    record->prev = arena->defer;
+    arena->defer = _arena_handle_make(arena, arena->last_chunk, record);
+    return true;
+}
+
+static inline ArenaHandle arena_handle_of(const Arena *arena, const void *ptr)
+{
+    ArenaChunk *chunk = arena_chunk_of(arena, ptr);
+    return chunk ? _arena_handle_make(arena, chunk, ptr) : ARENA_HANDLE_NULL;
+}
+
+_ARENA_FORCE_INLINE void *arena_handle_resolve(Arena *arena, ArenaHandle handle)
+{
+    if (!arena || handle == ARENA_HANDLE_NULL) return NULL;
+
+#if ARENA_PLATFORM == _ARENA_PLATFORM_UNIX
+    if (arena->flags & ARENA_FLAG_SHARED) arena->epoch = _ARENA_ATOMIC_LOAD(&_arena_shared_header(arena)->epoch);
+#endif
+
+    if (((handle >> (ARENA_HANDLE_OFFSET_BITS + ARENA_HANDLE_CHUNK_BITS)) ^ arena->epoch) & ARENA_HANDLE_EPOCH_MASK) {
+        _arena_set_error(arena, ARENA_ERROR_EPOCH_MISMATCH);
+        return NULL;
+    }
+
+    uint32_t     index  = (uint32_t)((handle >> ARENA_HANDLE_OFFSET_BITS) & ARENA_HANDLE_CHUNK_MASK) - 1;
+    arena_size_t offset = handle & ARENA_HANDLE_OFFSET_MASK;
+    if (index >= arena->chunk_count) {
+        _arena_set_error(arena, ARENA_ERROR_INVALID_HANDLE);
+        return NULL;
+    }
+
+    ArenaChunk *chunk = _arena_chain(arena)[index];
+    if (offset >= chunk->offset) {
+        _arena_set_error(arena, ARENA_ERROR_INVALID_HANDLE); // memory was released by restore
+        return NULL;
+    }
+
+    return chunk->base + offset;
+}
+
+static inline ArenaTemp arena_temp_begin(Arena *arena)
+{
+    return (ArenaTemp){
+        .arena = arena,
+        .mark  = arena_mark(arena)
+    };
+}
+
+static inline bool arena_temp_end(ArenaTemp temp)
+{
+    return arena_restore(temp.arena, temp.mark, false);
+}
+
+static inline void _arena_temp_cleanup(ArenaTemp *temp)
+{
+    arena_temp_end(*temp);
+}
+
+static inline void arena_trim(Arena *arena)
+{
+    // gives chunks cached by `arena_restore` back to the system
+    if (!arena) return;
+    while (arena->free_chunks) {
+        ArenaChunk *chunk = arena->free_chunks;
+        arena->free_chunks = chunk->next;
+        _arena_remove_owned_chunk(arena, chunk);
+        // region of a file chunk stays in the file, `arena_open_file` puts it back to the cache
+        if (chunk->backing == ARENA_CHUNK_BACKING_FILE && chunk->index != ARENA_U32_MAX) chunk->index = ARENA_U32_MAX;
+        _arena_free_chunk(arena, chunk);
+        arena->remaps++;
+    }
+}
+
+static inline ArenaTable arena_table_create(ArenaConfig config)
+{
+    Arena arena = arena_create_ex(config);
+    if (!arena.head_chunk) return (ArenaTable){};
+
+    ArenaTable table = {};
+    table.arena  = arena;
+    table.config = config;
+    return table;
+}
+
+static inline void arena_table_destroy(ArenaTable *table)
+{
+    if (!table) return;
+    arena_destroy(&table->arena);
+    free(table->entries);
+    *table = (ArenaTable){};
+}
+
+_ARENA_FORCE_INLINE ArenaTableEntry *_arena_table_entry(const ArenaTable *table, ArenaRef ref)
+{
+    uint32_t slot = (uint32_t)ref - 1; // NULL ref wraps around and fails the check
+    if (slot >= table->entry_count) return NULL;
+
+    ArenaTableEntry *entry = &table->entries[slot];
+    if (entry->generation != (uint32_t)(ref >> 32) || entry->handle == ARENA_HANDLE_NULL) return NULL;
+
+    return entry;
+}
+
+static inline ArenaRef arena_table_alloc(ArenaTable *table, arena_size_t size, size_t alignment)
+{
+    if (!table || !table->arena.head_chunk) return ARENA_REF_NULL;
+
+    uint32_t slot = 0;
+    if (table->free_slot) {
+        slot = table->free_slot - 1;
+    } else {
+        if (table->entry_count == table->entry_capacity) {
+            uint32_t new_capacity = table->entry_capacity ? table->entry_capacity * 2 : 64;
+            ArenaTableEntry *entries = (ArenaTableEntry*)realloc(table->entries, new_capacity * sizeof(*entries));
+            if (!entries) {
+                _arena_set_error(&table->arena, ARENA_ERROR_OOM);
+                return ARENA_REF_NULL;
+            }
+            table->entries        = entries;
+            table->entry_capacity = new_capacity;
+        }
+        slot = table->entry_count;
+        table->entries[slot] = (ArenaTableEntry){};
+    }
+
+    ArenaHandle handle = arena_alloc_handle(&table->arena, size, alignment);
+    if (handle == ARENA_HANDLE_NULL) return ARENA_REF_NULL;
+
+    ArenaTableEntry *entry = &table->entries[slot];
+    if (table->free_slot) {
+        table->free_slot = (uint32_t)entry->size;
+    } else {
+        table->entry_count++;
+    }
+
+    entry->handle    = handle;
+    entry->size      = size;
+    entry->alignment = (uint32_t)alignment;
+    table->live_bytes += size;
+
+    return ((ArenaRef)entry->generation << 32) | (slot + 1);
+}
+
+_ARENA_FORCE_INLINE void *arena_table_get(ArenaTable *table, ArenaRef ref)
+{
+    // returned pointer is valid until next `arena_compact`
+    ArenaTableEntry *entry = table ? _arena_table_entry(table, ref) : NULL;
+    return entry ? arena_handle_resolve(&table->arena, entry->handle) : NULL;
+}
+
+static inline bool arena_table_free(ArenaTable *table, ArenaRef ref)
+{
+    ArenaTableEntry *entry = table ? _arena_table_entry(table, ref) : NULL;
+    if (!entry) return false;
+
+    table->live_bytes -= entry->size;
+    table->dead_bytes += entry->size;
+
+    entry->handle = ARENA_HANDLE_NULL;
+    entry->size   = table->free_slot;
+    entry->generation++;
+    table->free_slot = (uint32_t)(entry - table->entries) + 1;
+
+    return true;
+}
+
+static inline double arena_table_fragmentation(const ArenaTable *table)
+{
+    // share of storage occupied by freed objects, use it to decide when to compact
+    if (!table || table->live_bytes + table->dead_bytes == 0) return 0.0;
+    return (double)table->dead_bytes / (double)(table->live_bytes + table->dead_bytes);
+}
+
+static inline bool arena_compact(ArenaTable *table)
+{
+    /*
+    - Copies live objects into fresh dense storage and gives old storage back to the system
+    - Refs stay valid, raw pointers from `arena_table_get` do not
+    - Old storage stays untouched if compaction fails
+    - Refused while `arena_defer` callbacks are pending on the storage, releasing it would run them
+    */
+    if (!table || !table->arena.head_chunk) return false;
+    if (table->arena.flags & ARENA_FLAG_FROZEN) {
+        _arena_set_error(&table->arena, ARENA_ERROR_FROZEN);
+        return false;
+    }
+    if (table->arena.defer != ARENA_HANDLE_NULL) {
+        _arena_set_error(&table->arena, ARENA_ERROR_UNSUPPORTED);
+        return false;
+    }
+
+    arena_size_t required = 0;
+    for (uint32_t i = 0; i < table->entry_count; ++i) {
+        const ArenaTableEntry *entry = &table->entries[i];
+        if (entry->handle != ARENA_HANDLE_NULL) required += entry->size + entry->alignment;
+    }
+
+    ArenaConfig config = table->config;
+    if (required > config.capacity) config.capacity = required;
+    if (config.max_capacity && config.capacity > config.max_capacity) config.max_capacity = config.capacity;
+
+    Arena fresh = arena_create_ex(config);
+    if (!fresh.head_chunk) return false;
+
+    ArenaHandle *moved = (ArenaHandle*)malloc((table->entry_count ? table->entry_count : 1) * sizeof(*moved));
+    if (!moved) {
+        arena_destroy(&fresh);
+        return false;
+    }
+
+    for (uint32_t i = 0; i < table->entry_count; ++i) {
+        const ArenaTableEntry *entry = &table->entries[i];
+        moved[i] = ARENA_HANDLE_NULL;
+        if (entry->handle == ARENA_HANDLE_NULL) continue;
+
+        moved[i] = arena_alloc_handle(&fresh, entry->size, entry->alignment);
+        if (moved[i] == ARENA_HANDLE_NULL) {
+            free(moved);
+            arena_destroy(&fresh);
+            return false;
+        }
+        arena_memcpy(arena_handle_resolve(&fresh, moved[i]), arena_handle_resolve(&table->arena, entry->handle), entry->size);
+    }
+
+    for (uint32_t i = 0; i < table->entry_count; ++i) {
+        if (table->entries[i].handle != ARENA_HANDLE_NULL) table->entries[i].handle = moved[i];
+    }
+    free(moved);
+
+    ARENA_LOG("Table compacted. Live: " ARENA_SIZE_FMT " Released: " ARENA_SIZE_FMT, table->live_bytes, table->arena.reserved - fresh.reserved);
+
+    fresh.remaps = table->arena.remaps + 1; // same Arena object, new memory
+    arena_destroy(&table->arena);
+    table->arena      = fresh;
+    table->dead_bytes = 0;
+
+    return true;
+}
+
+typedef struct _ArenaForward {
+    void *from;
+    void *to;
+} _ArenaForward;
+
+typedef struct _ArenaEvacuation {
+    Arena         *from;
+    Arena         *to;
+    ArenaTraceFn  trace;
+    _ArenaForward *forwards;      // copied objects in copy order, doubles as Cheney scan queue
+    uint32_t      count;
+    uint32_t      capacity;
+    uint32_t      *index;         // open addressing: forward index + 1 by hash of `from` address
+    uint32_t      index_capacity; // power of two
+    bool          failed;
+} _ArenaEvacuation;
+
+_ARENA_FORCE_INLINE uint32_t _arena_ptr_hash(const void *ptr, uint32_t mask)
+{
+    return (uint32_t)((((arena_ptr_t)ptr >> 3) * 0x9E3779B97F4A7C15ull) >> 32) & mask;
+}
+
+static inline bool _arena_evacuation_reserve(_ArenaEvacuation *ev)
+{
+    if (ev->count < ev->capacity) return true;
+
+    uint32_t new_capacity = ev->capacity ? ev->capacity * 2 : 256;
+    _ArenaForward *forwards = (_ArenaForward*)realloc(ev->forwards, new_capacity * sizeof(*forwards));
+    if (!forwards) return false;
+    ev->forwards = forwards;
+    ev->capacity = new_capacity;
+
+    // keep load factor <= 0.5
+    uint32_t *index = (uint32_t*)calloc(new_capacity * 2, sizeof(*index));
+    if (!index) return false;
+    free(ev->index);
+    ev->index          = index;
+    ev->index_capacity = new_capacity * 2;
+
+    uint32_t mask = ev->index_capacity - 1;
+    for (uint32_t i = 0; i < ev->count; ++i) {
+        uint32_t h = _arena_ptr_hash(ev->forwards[i].from, mask);
+        while (ev->index[h]) h = (h + 1) & mask;
+        ev->index[h] = i + 1;
+    }
+    return true;
+}
+
+static inline void *_arena_forward(_ArenaEvacuation *ev, void *object)
+{
+    if (ev->index_capacity) {
+        uint32_t mask = ev->index_capacity - 1;
+        for (uint32_t h = _arena_ptr_hash(object, mask); ev->index[h]; h = (h + 1) & mask) {
+            if (ev->forwards[ev->index[h] - 1].from == object) return ev->forwards[ev->index[h] - 1].to;
+        }
+    }
+
+    void *copy = NULL;
+    if (_arena_evacuation_reserve(ev)) {
+        size_t alignment  = ARENA_ALIGN_DEFAULT;
+        arena_size_t size = ev->trace(object, &alignment, NULL, NULL);
+        copy = arena_alloc_raw(ev->to, size, alignment);
+        if (copy) arena_memcpy(copy, object, _arena_downcast_size(size, NULL));
+    }
+    if (!copy) {
+        ev->failed = true;
+        return object;
+    }
+
+    uint32_t mask = ev->index_capacity - 1;
+    uint32_t h = _arena_ptr_hash(object, mask);
+    while (ev->index[h]) h = (h + 1) & mask;
+    ev->index[h] = ev->count + 1;
+    ev->forwards[ev->count++] = (_ArenaForward){ .from = object, .to = copy };
+
+    return copy;
+}
+
+static inline void _arena_evacuate_visit(void **slot, void *ctx)
+{
+    _ArenaEvacuation *ev = (_ArenaEvacuation*)ctx;
+    if (ev->failed || !*slot || !arena_owns(ev->from, *slot)) return;
+    *slot = _arena_forward(ev, *slot);
+}
+
+static inline bool _arena_evacuate(Arena *from, Arena *to, void **roots, size_t root_count, ArenaTraceFn trace, size_t *copied)
+{
+    /*
+    Cheney style copy of everything reachable from `roots` out of `from` into `to`:
+    - roots and pointer fields of the copies are rewritten to new locations
+    - shared objects and cycles are copied once (forwarding table)
+    - pointers that do not belong to `from` are left as is
+    - `from` is not modified, reset it after success to reclaim the garbage
+    - on failure roots are untouched and `to` is restored to where it was
+    */
+    if (!from || !to || !trace || from == to || (root_count && !roots)) return false;
+    if (to->growth_contract == ARENA_GROWTH_CONTRACT_REALLOC) {
+        // copies must not move while their fields are being rewritten
+        _arena_set_error(to, ARENA_ERROR_GROWTH_FORBIDDEN);
+        return false;
+    }
+
+    _ArenaEvacuation ev = {};
+    ev.from  = from;
+    ev.to    = to;
+    ev.trace = trace;
+
+    ArenaMark to_mark = arena_mark(to);
+    void **new_roots = (void**)malloc((root_count ? root_count : 1) * sizeof(*new_roots));
+    if (!new_roots) return false;
+
+    for (size_t i = 0; i < root_count; ++i) {
+        new_roots[i] = roots[i];
+        _arena_evacuate_visit(&new_roots[i], &ev);
+    }
+
+    for (uint32_t scan = 0; scan < ev.count && !ev.failed; ++scan) {
+        trace(ev.forwards[scan].to, NULL, _arena_evacuate_visit, &ev);
+    }
+
+    if (!ev.failed) {
+        for (size_t i = 0; i < root_count; ++i) roots[i] = new_roots[i];
+        if (copied) *copied = ev.count;
+        ARENA_LOG("Evacuated %u objects.", ev.count);
+    } else {
+        arena_restore(to, to_mark, false);
+        ARENA_LOG("Evacuation failed after %u objects.", ev.count);
+    }
+
+    free(new_roots);
+    free(ev.forwards);
+    free(ev.index);
+
+    return !ev.failed;
+}
+
+static inline bool arena_evacuate(Arena *from, Arena *to, void **roots, size_t root_count, ArenaTraceFn trace)
+{
+    return _arena_evacuate(from, to, roots, root_count, trace, NULL);
+}
+
+static inline arena_size_t arena_used_bytes(const Arena *arena)
+{
+    // bytes taken by allocations in the chain (alignment padding included)
+    if (!arena || !arena->head_chunk) return 0;
+
+    arena_size_t used = 0;
+    ArenaChunk *const *chain = _arena_chain(arena);
+    for (uint32_t i = 0; i < arena->chunk_count; ++i) used += chain[i]->offset;
+    return used;
+}
+
+static inline bool arena_flatten(Arena *arena, ArenaRelocMap *map_out, bool read_mostly)
+{
+    /*
+    - Copies used bytes of every chain chunk into one right-sized mapping, old chunks (and cache) are freed
+    - Every chunk lands at an address congruent to the old one mod page size (at least ARENA_LOAD_DIRECT_ALIGN),
+      so all alignments up to that survive, page aligned `arena_load_file` copies included
+    - Pointers into the arena are stale afterwards, fix them up with `map_out` (optional) and `arena_relocate_ptr`
+    - Epoch is bumped, handles and marks from before are rejected
+    - `read_mostly` asks the OS to fault the block in and back it with huge pages where it can
+    - Refused while `arena_defer` callbacks are pending, their objects would move under them
+    */
+    if (!arena || !arena->head_chunk) return false;
+    if (arena->flags & ARENA_FLAG_FROZEN) {
+        _arena_set_error(arena, ARENA_ERROR_FROZEN);
+        return false;
+    }
+    if (arena->growth_contract != ARENA_GROWTH_CONTRACT_CHUNKY || arena->backing != ARENA_CHUNK_BACKING_DEFAULT ||
+        arena->defer != ARENA_HANDLE_NULL) {
+        _arena_set_error(arena, ARENA_ERROR_UNSUPPORTED);
+        return false;
+    }
+
+    uint32_t count = arena->chunk_count;
+    ArenaChunk *const *chain = _arena_chain(arena);
+    ArenaRelocEntry *entries = (ArenaRelocEntry*)malloc(count * sizeof(*entries));
+    if (!entries) {
+        _arena_set_error(arena, ARENA_ERROR_OOM);
+        return false;
+    }
+
+    // layout as if base was at sizeof(ArenaChunk) mod page size (page aligned mapping)
+    size_t page_size = _arena_get_platform_page_size();
+    const arena_ptr_t congruence = page_size > ARENA_LOAD_DIRECT_ALIGN ? page_size : ARENA_LOAD_DIRECT_ALIGN;
+    arena_size_t total = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        arena_ptr_t old_base = (arena_ptr_t)chain[i]->base;
+        arena_ptr_t at = sizeof(ArenaChunk) + total;
+        total += (arena_size_t)((old_base - at) & (congruence - 1));
+        entries[i] = (ArenaRelocEntry){ .old_base = old_base, .size = chain[i]->offset, .new_base = total };
+        total += chain[i]->offset;
+    }
+
+    ArenaChunk *flat = (ArenaChunk*)_arena_alloc_chunk(_arena_downcast_size(total + congruence - 1, NULL), ARENA_ALLOC_TYPE_BIG);
+    if (!flat) {
+        free(entries);
+        _arena_set_error(arena, ARENA_ERROR_CHUNK_ALLOC_FAILED);
+        return false;
+    }
+
+    // malloc backed platform may put base anywhere, constant shift keeps the layout congruent
+    arena_ptr_t shift = (sizeof(ArenaChunk) - (arena_ptr_t)flat->base) & (congruence - 1);
+    for (uint32_t i = 0; i < count; ++i) {
+        entries[i].new_base += (arena_ptr_t)flat->base + shift;
+        arena_memcpy((void*)entries[i].new_base, (void*)entries[i].old_base, _arena_downcast_size(entries[i].size, NULL));
+    }
+    flat->offset = total + shift;
+
+#if ARENA_PLATFORM == _ARENA_PLATFORM_UNIX
+    if (read_mostly) {
+        size_t flat_size = _arena_calc_chunk_real_size(flat->capacity);
+    #ifdef MADV_HUGEPAGE
+        madvise(flat, flat_size, MADV_HUGEPAGE);
+    #endif
+        madvise(flat, flat_size, MADV_WILLNEED);
+    }
+#endif
+
+    // drop old chunks, arena becomes single chunk again (loaded files stay where they are)
+    ArenaChunk *loaded = NULL;
+    ArenaChunk *const *owned = _arena_owned(arena);
+    for (uint32_t i = 0; i < arena->owned_count; ++i) {
+        if (owned[i]->backing == ARENA_CHUNK_BACKING_LOADED) {
+            owned[i]->next = loaded;
+            loaded = owned[i];
+            continue;
+        }
+        _arena_free_chunk(arena, owned[i]);
+    }
+    free(arena->chunks);
+    free(arena->chunks_sorted);
+
+    arena->alloc_type     = ARENA_ALLOC_TYPE_BIG; // every chunk it owns is big now
+    arena->head_chunk     = flat;
+    arena->last_chunk     = flat;
+    arena->free_chunks    = NULL;
+    arena->chunks         = NULL;
+    arena->chunks_sorted  = NULL;
+    arena->chunk_count    = 1;
+    arena->owned_count    = 1;
+    arena->chunk_capacity = 0;
+    arena->reserved       = flat->capacity;
+    arena->epoch++;
+    arena->remaps++;
+
+    while (loaded) {
+        ArenaChunk *next = loaded->next;
+        loaded->next = NULL;
+        if (_arena_reserve_chunk_dir(arena)) _arena_insert_owned_chunk(arena, loaded);
+        else _arena_free_chunk(arena, loaded); // can not track it any more
+        loaded = next;
+    }
+
+    if (map_out) {
+        // few entries, insertion sort by old address
+        for (uint32_t i = 1; i < count; ++i) {
+            ArenaRelocEntry entry = entries[i];
+            uint32_t j = i;
+            for (; j > 0 && entries[j - 1].old_base > entry.old_base; --j) entries[j] = entries[j - 1];
+            entries[j] = entry;
+        }
+        *map_out = (ArenaRelocMap){ .entries = entries, .count = count };
+    } else {
+        free(entries);
+    }
+
+    ARENA_LOG("Arena flattened. Chunks: %u Size: " ARENA_SIZE_FMT, count, total);
+    return true;
+}
+
+static inline void *arena_relocate_ptr(const ArenaRelocMap *map, const void *ptr)
+{
+    // new address of `ptr` after `arena_flatten`, NULL if it was not inside used part of the arena
+    if (!map || !ptr) return NULL;
+
+    arena_ptr_t address = (arena_ptr_t)ptr;
+    uint32_t lo = 0, hi = map->count;
+    while (lo < hi) {
+        uint32_t mid = lo + ((hi - lo) >> 1);
+        if (map->entries[mid].old_base <= address) lo = mid + 1;
+        else hi = mid;
+    }
+    if (lo == 0) return NULL;
+
+    const ArenaRelocEntry *entry = &map->entries[lo - 1];
+    if (address - entry->old_base >= entry->size) return NULL;
+    return (void*)(entry->new_base + (address - entry->old_base));
+}
+
+static inline void arena_reloc_map_destroy(ArenaRelocMap *map)
+{
+    if (!map) return;
+    free(map->entries);
+    map->entries = NULL;
+    map->count   = 0;
+}
+
+_ARENA_FORCE_INLINE bool _arena_protect_chunk(ArenaChunk *chunk, bool writable)
+{
+    size_t size = (size_t)_arena_align_up(_arena_calc_chunk_real_size(chunk->capacity), _arena_get_platform_page_size());
+#if ARENA_PLATFORM == _ARENA_PLATFORM_UNIX
+    return mprotect(chunk, size, writable ? PROT_READ | PROT_WRITE : PROT_READ) == 0;
+#elif (ARENA_PLATFORM == _ARENA_PLATFORM_WIN32)
+    DWORD old_protect;
+    return VirtualProtect(chunk, size, writable ? PAGE_READWRITE : PAGE_READONLY, &old_protect) != 0;
+#else
+    (void)chunk; (void)size; (void)writable;
+    return false;
+#endif
+}
+
+#if ARENA_PLATFORM == _ARENA_PLATFORM_UNIX
+static inline bool _arena_share_chunk(ArenaChunk *chunk)
+{
+    // replaces private pages of the chunk with a shared memfd mapping holding the same bytes (read only)
+    size_t size = (size_t)_arena_align_up(_arena_calc_chunk_real_size(chunk->capacity), _arena_get_platform_page_size());
+    int fd = _arena_memfd_create("arena_frozen");
+    if (fd < 0) return false;
+
+    bool ok = ftruncate(fd, (off_t)size) == 0 &&
+              _arena_pwrite_all(fd, chunk, sizeof(ArenaChunk) + _arena_downcast_size(chunk->offset, NULL), 0) &&
+              mmap(chunk, size, PROT_READ, MAP_SHARED | MAP_FIXED, fd, 0) != MAP_FAILED;
+    close(fd);
+    return ok;
+}
+#endif
+
+static inline bool arena_freeze(Arena *arena, bool share)
+{
+    /*
+    - Makes every chunk read only, writes through stale pointers fault instead of silently copying pages
+    - Allocation, grow, reset and restore fail with ARENA_ERROR_FROZEN until `arena_thaw`,
+      so do `arena_flatten`, `arena_compact`, `arena_fork` and `arena_fork_commit` into it
+    - `share` (unix) moves default backed chunks to shared memfd mappings, so processes forked later never
+      copy them, even after `arena_thaw` in one of them (writes after thaw are seen by every process)
+    - MADV_DONTFORK is not used on purpose, children would lose the pages altogether
+    - Only big (page aligned) arenas can be frozen
+    */
+    if (!arena || !arena->head_chunk) return false;
+    if (arena->flags & ARENA_FLAG_FROZEN) return true;
+    if (arena->alloc_type != ARENA_ALLOC_TYPE_BIG) {
+        _arena_set_error(arena, ARENA_ERROR_UNSUPPORTED);
+        return false;
+    }
+
+    // cached chunks can not enter the chain while frozen, mark them now so header writes
+    // (`arena_sync`, `arena_fork`, `arena_destroy`) and `arena_trim` never store into protected pages
+    for (ArenaChunk *chunk = arena->free_chunks; chunk != NULL; chunk = chunk->next) chunk->index = ARENA_U32_MAX;
+
+    ArenaChunk *const *owned = _arena_owned(arena);
+    for (uint32_t i = 0; i < arena->owned_count; ++i) {
+        ArenaChunk *chunk = owned[i];
+        if (chunk->backing == ARENA_CHUNK_BACKING_LOADED) continue; // read only already
+        bool ok = false;
+    #if ARENA_PLATFORM == _ARENA_PLATFORM_UNIX
+        if (share && chunk->backing == ARENA_CHUNK_BACKING_DEFAULT) {
+            ok = _arena_share_chunk(chunk);
+            if (ok) arena->remaps++;
+        }
+    #endif
+        if (!ok) ok = _arena_protect_chunk(chunk, false);
+        if (!ok) {
+            for (uint32_t j = 0; j < i; ++j) {
+                if (owned[j]->backing != ARENA_CHUNK_BACKING_LOADED) _arena_protect_chunk(owned[j], true);
+            }
+            _arena_set_error(arena, ARENA_ERROR_MAPPING_FAILED);
+            return false;
+        }
+    }
+
+    arena->flags = (ArenaFlag)(arena->flags | ARENA_FLAG_FROZEN);
+    ARENA_LOG("Arena frozen. Chunks: %u Shared: %d", arena->owned_count, share);
+    return true;
+}
+
+static inline bool arena_thaw(Arena *arena)
+{
+    if (!arena || !arena->head_chunk) return false;
+    if (!(arena->flags & ARENA_FLAG_FROZEN)) return true;
+
+    ArenaChunk *const *owned = _arena_owned(arena);
+    for (uint32_t i = 0; i < arena->owned_count; ++i) {
+        if (owned[i]->backing == ARENA_CHUNK_BACKING_LOADED) continue;
+        if (!_arena_protect_chunk(owned[i], true)) {
+            _arena_set_error(arena, ARENA_ERROR_MAPPING_FAILED);
+            return false;
+        }
+    }
+
+    arena->flags = (ArenaFlag)(arena->flags & ~ARENA_FLAG_FROZEN);
+    return true;
+}
+
+static inline ArenaGen arena_gen_create(ArenaConfig nursery_config, ArenaConfig tenured_config)
+{
+    tenured_config.growth_contract = ARENA_GROWTH_CONTRACT_CHUNKY;
+
+    Arena nursery = arena_create_ex(nursery_config);
+    if (!nursery.head_chunk) return (ArenaGen){};
+
+    Arena tenured = arena_create_ex(tenured_config);
+    if (!tenured.head_chunk) {
+        arena_destroy(&nursery);
+        return (ArenaGen){};
+    }
+
+    ArenaGen gen = {};
+    gen.nursery    = nursery;
+    gen.tenured    = tenured;
+    gen.cycle_mark = arena_mark(&nursery);
+    return gen;
+}
+
+static inline void arena_gen_destroy(ArenaGen *gen)
+{
+    if (!gen) return;
+    arena_destroy(&gen->nursery);
+    arena_destroy(&gen->tenured);
+    *gen = (ArenaGen){};
+}
+
+_ARENA_FORCE_INLINE void *arena_gen_alloc(ArenaGen *gen, arena_size_t size, size_t alignment)
+{
+    void *p = arena_alloc_raw(&gen->nursery, size, alignment);
+    if (p) gen->stats.cycle_allocated += size;
+    return p;
+}
+
+static inline void *arena_gen_promote(ArenaGen *gen, const void *object, arena_size_t size, size_t alignment)
+{
+    // copies one survivor into tenured arena, pointers inside it are copied as is
+    if (!gen || !object) return NULL;
+
+    void *p = arena_alloc_raw(&gen->tenured, size, alignment);
+    if (!p) return NULL;
+
+    arena_memcpy(p, object, _arena_downcast_size(size, NULL));
+    gen->stats.cycle_promoted += size;
+    gen->stats.promoted_objects++;
+    return p;
+}
+
+static inline bool arena_gen_promote_graph(ArenaGen *gen, void **roots, size_t root_count, ArenaTraceFn trace)
+{
+    // promotes everything reachable from roots, nursery pointers inside survivors are rewritten
+    if (!gen) return false;
+
+    arena_size_t used = arena_used_bytes(&gen->tenured);
+    size_t copied = 0;
+    if (!_arena_evacuate(&gen->nursery, &gen->tenured, roots, root_count, trace, &copied)) return false;
+
+    gen->stats.cycle_promoted   += arena_used_bytes(&gen->tenured) - used;
+    gen->stats.promoted_objects += copied;
+    return true;
+}
+
+static inline void arena_gen_cycle(ArenaGen *gen)
+{
+    /*
+    - Drops everything allocated in nursery during the cycle
+    - Nursery goes back to its first chunk (extra chunks are cached) so next cycle runs over the same warm bytes
+    - Old nursery handles and marks are invalidated
+    */
+    if (!gen || !gen->nursery.head_chunk) return;
+
+    if (!arena_restore(&gen->nursery, gen->cycle_mark, false)) {
+        // mark went stale (nursery reset or flattened directly), drop everything instead
+        arena_reset(&gen->nursery);
+    }
+    gen->nursery.epoch++;
+    gen->cycle_mark = arena_mark(&gen->nursery);
+
+    gen->stats.allocated_bytes += gen->stats.cycle_allocated;
+    gen->stats.promoted_bytes  += gen->stats.cycle_promoted;
+    gen->stats.cycle_allocated  = 0;
+    gen->stats.cycle_promoted   = 0;
+    gen->stats.cycles++;
+}
+
+static inline double arena_gen_survival_rate(const ArenaGen *gen)
+{
+    // promoted / allocated over finished cycles
+    if (!gen || gen->stats.allocated_bytes == 0) return 0.0;
+    return (double)gen->stats.promoted_bytes / (double)gen->stats.allocated_bytes;
+}
+
+_ARENA_FORCE_INLINE void *arena_relptr32_get(const ArenaRelPtr32 *rel)
+{
+    return rel->offset ? (void*)((intptr_t)rel + rel->offset) : NULL;
+}
+
+_ARENA_FORCE_INLINE bool arena_relptr32_set(ArenaRelPtr32 *rel, const void *target)
+{
+    // false if target is further than 2GB away, field is left untouched then
+    intptr_t distance = target ? (intptr_t)target - (intptr_t)rel : 0;
+    if (distance < INT32_MIN || distance > INT32_MAX) return false;
+    rel->offset = (int32_t)distance;
+    return true;
+}
+
+_ARENA_FORCE_INLINE void *arena_relptr64_get(const ArenaRelPtr64 *rel)
+{
+    return rel->offset ? (void*)((intptr_t)rel + (intptr_t)rel->offset) : NULL;
+}
+
+_ARENA_FORCE_INLINE bool arena_relptr64_set(ArenaRelPtr64 *rel, const void *target)
+{
+    rel->offset = target ? (int64_t)((intptr_t)target - (intptr_t)rel) : 0;
+    return true;
+}
+
+_ARENA_FORCE_INLINE ArenaCPtr arena_cptr_encode(const Arena *arena, const void *ptr)
+{
+    // relative to chunk header, so the first object is never 0
+    if (!ptr) return ARENA_CPTR_NULL;
+    arena_ptr_t distance = (arena_ptr_t)ptr - (arena_ptr_t)arena->head_chunk;
+    ARENA_ASSERT(arena->growth_contract == ARENA_GROWTH_CONTRACT_FIXED || arena->growth_contract == ARENA_GROWTH_CONTRACT_RESERVE);
+    ARENA_ASSERT((arena_ptr_t)ptr > (arena_ptr_t)arena->head_chunk);
+    ARENA_ASSERT((distance & ((1 << ARENA_CPTR_SHIFT) - 1)) == 0);
+    ARENA_ASSERT((distance >> ARENA_CPTR_SHIFT) <= ARENA_U32_MAX);
+    return (ArenaCPtr)(distance >> ARENA_CPTR_SHIFT);
+}
+
+_ARENA_FORCE_INLINE void *arena_cptr_decode(const Arena *arena, ArenaCPtr cptr)
+{
+    return cptr ? (void*)((arena_ptr_t)arena->head_chunk + ((arena_ptr_t)cptr << ARENA_CPTR_SHIFT)) : NULL;
+}
+
+static inline ArenaBufBuilder arena_buf_builder_create(arena_size_t capacity)
+{
+    if (capacity == ARENA_CAPACITY_CHOOSE_FOR_ME_PLS) capacity = ARENA_CAPACITY_DEFAULT;
+    ArenaBufBuilder builder = {};
+    builder.arena = arena_create_ex(arena_config_create(
+        capacity,
+        ARENA_CAPACITY_4GB - 1,
+        ARENA_GROWTH_CONTRACT_REALLOC,
+        ARENA_GROWTH_FACTOR_REALLOC_2X,
+        ARENA_FLAG_NONE
+    ));
+    builder.error = builder.arena.error;
+    if (builder.arena.head_chunk) arena_buf_builder_reset(&builder);
+    return builder;
+}
+
+static inline void arena_buf_builder_destroy(ArenaBufBuilder *builder)
+{
+    if (!builder) return;
+    arena_destroy(&builder->arena);
+    builder->error = ARENA_ERROR_NONE;
+}
+
+static inline bool arena_buf_builder_reset(ArenaBufBuilder *builder)
+{
+    // drops built objects, keeps the memory for the next buffer
+    if (!builder || !builder->arena.head_chunk) return false;
+    arena_reset(&builder->arena);
+
+    ArenaBufHeader *header = (ArenaBufHeader*)arena_alloc_raw(&builder->arena, sizeof(ArenaBufHeader), 1);
+    if (!header) {
+        builder->error = builder->arena.error;
+        return false;
+    }
+    arena_memset(header, 0, sizeof(*header));
+    builder->error = ARENA_ERROR_NONE;
+    return true;
+}
+
+static inline ArenaBufOffset _arena_buf_alloc(ArenaBufBuilder *builder, uint32_t prefix, arena_size_t size, uint32_t alignment)
+{
+    // places `prefix` bytes so data right after them is aligned relative to buffer start, padding is zeroed
+    if (!builder || !builder->arena.head_chunk) return 0;
+    if (!_arena_is_pow2(alignment) || alignment > ARENA_BUF_MAX_ALIGN) {
+        builder->error = ARENA_ERROR_INVALID_ALIGNMENT;
+        return 0;
+    }
+
+    arena_size_t used    = builder->arena.last_chunk->offset;
+    arena_size_t data_at = _arena_align_up(used + prefix, alignment);
+    arena_size_t end     = data_at + size;
+    if (end > ARENA_U32_MAX) {
+        builder->error = ARENA_ERROR_SIZE_OVERFLOW;
+        return 0;
+    }
+
+    // one byte aligned bump, chunk may move (realloc) so base is taken afterwards
+    if (!arena_alloc_raw(&builder->arena, end - used, 1)) {
+        builder->error = builder->arena.error;
+        return 0;
+    }
+    uint8_t *base = builder->arena.last_chunk->base;
+    arena_memset(base + used, 0, _arena_downcast_size(data_at - prefix - used, NULL));
+
+    builder->error = ARENA_ERROR_NONE;
+    return (ArenaBufOffset)(data_at - prefix);
+}
+
+static inline ArenaBufOffset arena_buf_add_struct(ArenaBufBuilder *builder, const void *data, uint32_t size, uint32_t alignment)
+{
+    // copies `size` bytes (zeroes if `data` is NULL), returns offset or 0 on failure
+    if (size == 0) {
+        if (builder) builder->error = ARENA_ERROR_SIZE_ZERO;
+        return 0;
+    }
+    ArenaBufOffset offset = _arena_buf_alloc(builder, 0, size, alignment);
+    if (!offset) return 0;
+
+    uint8_t *dst = builder->arena.last_chunk->base + offset;
+    if (data) arena_memcpy(dst, data, size);
+    else arena_memset(dst, 0, size);
+    return offset;
+}
+
+static inline ArenaBufOffset arena_buf_add_vector(ArenaBufBuilder *builder, const void *items, uint32_t count, uint32_t item_size, uint32_t alignment)
+{
+    // items zeroed when `items` is NULL, fill them later through `arena_buf_at`
+    if (alignment < alignof(uint32_t)) alignment = alignof(uint32_t);
+    arena_size_t size = (arena_size_t)count * item_size;
+    ArenaBufOffset offset = _arena_buf_alloc(builder, sizeof(uint32_t), size, alignment);
+    if (!offset) return 0;
+
+    uint8_t *dst = builder->arena.last_chunk->base + offset;
+    arena_memcpy(dst, &count, sizeof(count));
+    if (size) {
+        if (items) arena_memcpy(dst + sizeof(uint32_t), items, _arena_downcast_size(size, NULL));
+        else arena_memset(dst + sizeof(uint32_t), 0, _arena_downcast_size(size, NULL));
+    }
+    return offset;
+}
+
+static inline ArenaBufOffset arena_buf_add_string(ArenaBufBuilder *builder, const char *str, uint32_t length)
+{
+    // stored NUL terminated, readers get a C string in place
+    ArenaBufOffset offset = _arena_buf_alloc(builder, sizeof(uint32_t), (arena_size_t)length + 1, alignof(uint32_t));
+    if (!offset) return 0;
+
+    uint8_t *dst = builder->arena.last_chunk->base + offset;
+    arena_memcpy(dst, &length, sizeof(length));
+    if (length) arena_memcpy(dst + sizeof(uint32_t), str, length);
+    dst[sizeof(uint32_t) + length] = '\0';
+    return offset;
+}
+
+static inline void *arena_buf_at(ArenaBufBuilder *builder, ArenaBufOffset offset)
+{
+    // writable pointer into the buffer being built, valid until the next add (buffer may move)
+    if (!builder || !builder->arena.head_chunk || offset == 0 || offset >= builder->arena.last_chunk->offset) return NULL;
+    return builder->arena.last_chunk->base + offset;
+}
+
+static inline ArenaSpan arena_buf_finish(ArenaBufBuilder *builder, ArenaBufOffset root)
+{
+    // stamps the header, returned bytes stay valid until the next add, reset or destroy
+    if (!builder || !builder->arena.head_chunk) return (ArenaSpan){};
+    ArenaChunk *chunk = builder->arena.last_chunk;
+    if (root >= chunk->offset) {
+        builder->error = ARENA_ERROR_BUFFER_INVALID;
+        return (ArenaSpan){};
+    }
+
+    ArenaBufHeader header = {
+        .magic   = ARENA_BUF_MAGIC,
+        .version = ARENA_BUF_VERSION,
+        .size    = (uint32_t)chunk->offset,
+        .root    = root
+    };
+    arena_memcpy(chunk->base, &header, sizeof(header));
+    builder->error = ARENA_ERROR_NONE;
+    return (ArenaSpan){ .data = chunk->base, .size = chunk->offset, .mapped = false };
+}
+
+static inline ArenaBufView arena_buf_view(const void *data, arena_size_t size)
+{
+    /*
+    - Checks header and root, no parsing and no copy, `data` must stay alive while the view is used
+    - Every accessor checks its own bounds, so corrupted offsets give NULL instead of stray reads
+    - `data` has to be ARENA_BUF_MAX_ALIGN aligned (mmap, arena memory), misaligned objects are rejected
+    */
+    ArenaBufHeader header;
+    ArenaBufView view = {};
+    view.error = ARENA_ERROR_BUFFER_INVALID;
+    if (!data || size < sizeof(header)) return view;
+    arena_memcpy(&header, data, sizeof(header));
+
+    if (header.magic != ARENA_BUF_MAGIC || header.version != ARENA_BUF_VERSION ||
+        header.size < sizeof(header) || header.size > size || header.root >= header.size ||
+        (header.root != 0 && header.root < sizeof(header))) {
+        return view;
+    }
+
+    return (ArenaBufView){
+        .data  = (const uint8_t*)data,
+        .size  = header.size,
+        .root  = header.root,
+        .error = ARENA_ERROR_NONE
+    };
+}
+
+_ARENA_FORCE_INLINE const uint8_t *_arena_buf_check(const ArenaBufView *view, ArenaBufOffset offset, arena_size_t size, uint32_t alignment)
+{
+    // [offset, offset + size) inside the buffer, past the header and aligned
+    if (!view || !view->data || offset < sizeof(ArenaBufHeader)) return NULL;
+    if ((arena_size_t)offset + size > view->size) return NULL;
+    const uint8_t *p = view->data + offset;
+    if (((arena_ptr_t)p & (alignment - 1)) != 0) return NULL;
+    return p;
+}
+
+static inline const void *arena_buf_struct(const ArenaBufView *view, ArenaBufOffset offset, uint32_t size, uint32_t alignment)
+{
+    if (!_arena_is_pow2(alignment)) return NULL;
+    return _arena_buf_check(view, offset, size, alignment);
+}
+
+static inline const void *arena_buf_vector(const ArenaBufView *view, ArenaBufOffset offset, uint32_t item_size, uint32_t alignment, uint32_t *count)
+{
+    // returns items, empty vector gives non NULL pointer with `*count` = 0
+    if (count) *count = 0;
+    if (!_arena_is_pow2(alignment)) return NULL;
+    if (alignment < alignof(uint32_t)) alignment = alignof(uint32_t);
+
+    const uint8_t *p = _arena_buf_check(view, offset, sizeof(uint32_t), alignof(uint32_t));
+    if (!p) return NULL;
+    uint32_t n;
+    arena_memcpy(&n, p, sizeof(n));
+
+    const uint8_t *items = _arena_buf_check(view, offset + (ArenaBufOffset)sizeof(uint32_t), (arena_size_t)n * item_size, alignment);
+    if (!items) return NULL;
+    if (count) *count = n;
+    return items;
+}
+
+static inline const char *arena_buf_string(const ArenaBufView *view, ArenaBufOffset offset, uint32_t *length)
+{
+    if (length) *length = 0;
+    const uint8_t *p = _arena_buf_check(view, offset, sizeof(uint32_t), alignof(uint32_t));
+    if (!p) return NULL;
+    uint32_t n;
+    arena_memcpy(&n, p, sizeof(n));
+
+    const uint8_t *str = _arena_buf_check(view, offset + (ArenaBufOffset)sizeof(uint32_t), (arena_size_t)n + 1, 1);
+    if (!str || str[n] != '\0') return NULL;
+    if (length) *length = n;
+    return (const char*)str;
+}
+
+#if ARENA_PLATFORM == _ARENA_PLATFORM_UNIX
+static inline ArenaRing arena_ring_create(arena_size_t capacity)
+{
+    /*
+        Same pages are mapped twice back to back:
+        [ view 0 | view 1 ] - byte at `base + capacity + i` is byte at `base + i`
+        so a record that crosses the end of view 0 is still one contiguous span.
+    */
+    size_t page_size = _arena_get_platform_page_size();
+
+    if (capacity == ARENA_CAPACITY_CHOOSE_FOR_ME_PLS) capacity = ARENA_CAPACITY_DEFAULT;
+    capacity = _arena_align_up(capacity, page_size);
+
+    bool overflow = false;
+    size_t view_size = _arena_downcast_size(capacity, &overflow);
+    ArenaRing ring = ARENA_RING_EMPTY;
+    ring.error = ARENA_ERROR_INVALID_CAPACITY;
+    if (overflow || view_size > ARENA_SIZE_MAX / 2) return ring;
+
+    uint8_t *base = NULL;
+    void *view0 = NULL, *view1 = NULL;
+
+    int fd = _arena_memfd_create("arena_ring");
+    if (fd < 0) goto exit_error;
+
+    if (ftruncate(fd, (off_t)view_size) != 0) {
+        close(fd);
+        goto exit_error;
+    }
+
+    base = (uint8_t*)mmap(NULL, view_size * 2, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) {
+        close(fd);
+        goto exit_error;
+    }
+
+    view0 = mmap(base,             view_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0);
+    view1 = mmap(base + view_size, view_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0);
+    close(fd); // mappings keep the pages alive
+
+    if (view0 != base || view1 != base + view_size) {
+        munmap(base, view_size * 2);
+        goto exit_error;
+    }
+
+    ARENA_LOG("Ring created at: %p Capacity: " ARENA_SIZE_FMT, base, capacity);
+
+    ring.base     = base;
+    ring.capacity = capacity;
+    ring.error    = ARENA_ERROR_NONE;
+    return ring;
+
+exit_error:
+    ARENA_LOG("Failed to create ring.");
+    ring.error = ARENA_ERROR_MAPPING_FAILED;
+    return ring;
+}
+
+static inline void arena_ring_destroy(ArenaRing *ring)
+{
+    if (!ring || !ring->base) return;
+    munmap(ring->base, _arena_downcast_size(ring->capacity * 2, NULL));
+    *ring = ARENA_RING_EMPTY;
+}
+
+static inline void *arena_ring_alloc(ArenaRing *ring, arena_size_t size, size_t alignment)
+{
+    /*
+        Producer side. Bytes are not visible to the consumer until `arena_ring_commit`,
+        so one producer and one consumer may work on the ring from different threads.
+    */
+    if (!ring || !ring->base || size == 0) return NULL;
+    if (!_arena_is_pow2(alignment) || alignment > _arena_get_platform_page_size()) {
+        ring->error = ARENA_ERROR_INVALID_ALIGNMENT;
+        return NULL;
+    }
+
+    arena_size_t tail         = _ARENA_ATOMIC_LOAD(&ring->tail);
+    arena_ptr_t  address      = (arena_ptr_t)ring->base + (ring->write % ring->capacity);
+    arena_ptr_t  aligned_addr = (arena_ptr_t)_arena_align_up(address, alignment);
+    arena_size_t new_write    = ring->write + (aligned_addr - address) + size;
+
+    if (new_write - tail > ring->capacity) {
+        ring->error = ARENA_ERROR_RING_FULL;
+        return NULL;
+    }
+
+    ring->write = new_write;
+    ring->error = ARENA_ERROR_NONE;
+    return (void*)aligned_addr;
+}
+
+static inline void arena_ring_commit(ArenaRing *ring)
+{
+    if (!ring) return;
+    _ARENA_ATOMIC_STORE(&ring->head, ring->write);
+}
+
+static inline void *arena_ring_peek(const ArenaRing *ring, arena_size_t *available)
+{
+    /*
+        Consumer side. Returns oldest unreleased byte and how many bytes
+        after it are readable as one span (never crosses the mirror end).
+    */
+    if (available) *available = 0;
+    if (!ring || !ring->base) return NULL;
+
+    arena_size_t head = _ARENA_ATOMIC_LOAD(&ring->head);
+    if (available) *available = head - ring->tail;
+
+    return ring->base + (ring->tail % ring->capacity);
+}
+
+static inline bool arena_ring_release(ArenaRing *ring, arena_size_t size)
+{
+    if (!ring || !ring->base) return false;
+
+    arena_size_t head = _ARENA_ATOMIC_LOAD(&ring->head);
+    if (size > head - ring->tail) return false;
+
+    _ARENA_ATOMIC_STORE(&ring->tail, ring->tail + size);
+    return true;
+}
+
+static inline bool arena_ring_release_to(ArenaRing *ring, const void *end)
+{
+    /*
+        Releases everything before `end` (e.g. end of consumed record, including alignment padding before it).
+        `end` may point into either view, distance from the tail is taken modulo capacity.
+    */
+    if (!ring || !ring->base) return false;
+
+    arena_ptr_t  base = (arena_ptr_t)ring->base;
+    if ((arena_ptr_t)end < base || (arena_ptr_t)end - base > ring->capacity * 2) return false;
+
+    arena_size_t end_offset  = (arena_size_t)((arena_ptr_t)end - base);
+    arena_size_t tail_offset = ring->tail % ring->capacity;
+    arena_size_t distance    = (end_offset + ring->capacity * 2 - tail_offset) % ring->capacity;
+    if (distance == 0 && end_offset != tail_offset) distance = ring->capacity; // a whole view ahead, ring drained full
+
+    return arena_ring_release(ring, distance);
+}
+_ARENA_FORCE_INLINE size_t _arena_snapshot_region_size(arena_ptr_t chunk_address, arena_size_t capacity, size_t page_size)
+{
+    size_t in_page = (size_t)(chunk_address & (page_size - 1));
+    return (size_t)_arena_align_up(in_page + _arena_calc_chunk_real_size(capacity), page_size);
+}
+
+static inline ArenaError arena_snapshot_write(const Arena *arena, const char *path)
+{
+    /*
+    - Persists chain chunks with metadata (chunk cache is not persisted)
+    - Only used bytes are written, rest of every chunk is a file hole
+    */
+    if (!arena || !arena->head_chunk || !path) return ARENA_ERROR_SNAPSHOT_INVALID;
+
+    size_t page_size = _arena_get_platform_page_size();
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return ARENA_ERROR_IO;
+
+    ArenaSnapshotHeader header = _arena_file_header(arena, ARENA_SNAPSHOT_MAGIC);
+
+    bool ok = _arena_pwrite_all(fd, &header, sizeof(header), 0);
+
+    off_t region = (off_t)page_size;
+    ArenaChunk *const *chain = _arena_chain(arena);
+    for (uint32_t i = 0; ok && i < arena->chunk_count; ++i) {
+        const ArenaChunk *chunk = chain[i];
+        arena_ptr_t address = (arena_ptr_t)chunk;
+        off_t image = region + (off_t)(address & (page_size - 1));
+
+        ok = _arena_pwrite_all(fd, chunk, sizeof(ArenaChunk) + _arena_downcast_size(chunk->offset, NULL), image);
+        region += (off_t)_arena_snapshot_region_size(address, chunk->capacity, page_size);
+    }
+
+    if (ok) ok = ftruncate(fd, region) == 0;
+    if (close(fd) != 0) ok = false;
+
+    ARENA_LOG("Snapshot written to `%s`. Chunks: %u Size: %lld", path, arena->chunk_count, (long long)region);
+    return ok ? ARENA_ERROR_NONE : ARENA_ERROR_IO;
+}
+
+static inline Arena arena_snapshot_map(const char *path)
+{
+    /*
+    - Maps chunks back privately (copy-on-write, file is never modified)
+    - Tries original addresses first, so raw pointers inside the arena stay valid
+    - If any chunk could not be placed at its address, arena is still usable but
+      `error` is ARENA_ERROR_SNAPSHOT_RELOCATED (handles and offsets work, raw pointers do not)
+    - Failure returns empty arena with `error` set
+    */
+    ArenaError error = ARENA_ERROR_NONE;
+    size_t page_size = _arena_get_platform_page_size();
+
+    int fd = path ? open(path, O_RDONLY) : -1;
+    if (fd < 0) return _arena_failed(ARENA_ERROR_IO);
+
+    struct stat st;
+    ArenaSnapshotHeader header;
+    if (fstat(fd, &st) != 0 || !_arena_pread_all(fd, &header, sizeof(header), 0)) {
+        close(fd);
+        return _arena_failed(ARENA_ERROR_IO);
+    }
+
+    if (header.magic != ARENA_SNAPSHOT_MAGIC || header.version != ARENA_SNAPSHOT_VERSION ||
+        header.page_size != page_size || header.chunk_header_size != sizeof(ArenaChunk) ||
+        header.chunk_count == 0 || header.chunk_count > ARENA_HANDLE_CHUNK_MASK) {
+        close(fd);
+        return _arena_failed(ARENA_ERROR_SNAPSHOT_INVALID);
+    }
+
+    Arena arena = {};
+    arena.max_capacity    = header.max_capacity;
+    arena.growth_factor   = header.growth_factor;
+    arena.growth_contract = (ArenaGrowthContract)header.growth_contract;
+    arena.flags           = (ArenaFlag)(header.flags & ~(ARENA_FLAG_SHARED | ARENA_FLAG_FROZEN)); // private writable mappings
+    arena.error           = ARENA_ERROR_NONE;
+    arena.alloc_type      = header.alloc_type;
+    arena.epoch           = header.epoch;
+
+    off_t region = (off_t)page_size;
+    arena_ptr_t address = (arena_ptr_t)header.head_address;
+    for (uint32_t i = 0; i < header.chunk_count; ++i) {
+        ArenaChunk image;
+        size_t in_page = (size_t)(address & (page_size - 1));
+        if (!_arena_pread_all(fd, &image, sizeof(image), region + (off_t)in_page) || image.index != i ||
+            image.offset > image.capacity || image.capacity > (arena_size_t)st.st_size) {
+            error = ARENA_ERROR_SNAPSHOT_INVALID;
+            goto exit_error;
+        }
+
+        // pages past the end of file would SIGBUS on first touch
+        size_t region_size = _arena_snapshot_region_size(address, image.capacity, page_size);
+        if (region_size > (size_t)(st.st_size - region)) {
+            error = ARENA_ERROR_SNAPSHOT_INVALID;
+            goto exit_error;
+        }
+        void *want = (void*)(address - in_page);
+        uint8_t *mapping = (uint8_t*)mmap(want, region_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED_NOREPLACE, fd, region);
+        if (mapping != MAP_FAILED && mapping != want) {
+            munmap(mapping, region_size);
+            mapping = (uint8_t*)MAP_FAILED;
+        }
+        if (mapping == MAP_FAILED) {
+            mapping = (uint8_t*)mmap(NULL, region_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, region);
+            if (mapping == MAP_FAILED) {
+                error = ARENA_ERROR_MAPPING_FAILED;
+                goto exit_error;
+            }
+            arena.error = ARENA_ERROR_SNAPSHOT_RELOCATED;
+        }
+
+        ArenaChunk *chunk = (ArenaChunk*)(mapping + in_page);
+        address = (arena_ptr_t)chunk->next; // original address of the next chunk
+        chunk->next    = NULL;
+        chunk->backing = ARENA_CHUNK_BACKING_MAPPED;
+
+        if (i == 0) {
+            arena.head_chunk  = chunk;
+            arena.last_chunk  = chunk;
+            arena.reserved    = chunk->capacity;
+            arena.chunk_count = 1;
+            arena.owned_count = 1;
+        } else {
+            if (!_arena_reserve_chunk_dir(&arena)) {
+                _arena_free_chunk(&arena, chunk);
+                error = ARENA_ERROR_OOM;
+                goto exit_error;
+            }
+            _arena_insert_owned_chunk(&arena, chunk);
+            _arena_push_chunk(&arena, chunk);
+        }
+
+        region += (off_t)region_size;
+    }
+
+    close(fd);
+    ARENA_LOG("Snapshot mapped from `%s`. Chunks: %u Relocated: %d", path, header.chunk_count, arena.error == ARENA_ERROR_SNAPSHOT_RELOCATED);
+    return arena;
+
+exit_error:
+    close(fd);
+    arena_destroy(&arena);
+    return _arena_failed(error);
+}
+
+static inline ArenaError _arena_map_file_chunks(Arena *arena, int fd, off_t file_size, uint32_t chain_count, int map_flags, bool keep_cached)
+{
+    /*
+    - Walks chunk regions of arena file and rebuilds `arena` directory from chunk indices
+    - Regions outside of the chain become cached chunks, or are skipped without `keep_cached`
+    - On failure every mapped region is released and `arena` is left empty (fd is not closed)
+    */
+    ArenaError error = ARENA_ERROR_NONE;
+    size_t page_size = _arena_get_platform_page_size();
+
+    ArenaChunk **chain = (ArenaChunk**)calloc(chain_count, sizeof(*chain));
+    if (!chain) return ARENA_ERROR_OOM;
+
+    ArenaChunk *cached = NULL;
+    off_t region = (off_t)page_size;
+    while (region < file_size) {
+        ArenaChunk image;
+        if (!_arena_pread_all(fd, &image, sizeof(image), region) || image.backing != ARENA_CHUNK_BACKING_FILE) {
+            error = ARENA_ERROR_SNAPSHOT_INVALID;
+            goto exit_error;
+        }
+
+        size_t region_size = (size_t)_arena_align_up(_arena_calc_chunk_real_size(image.capacity), page_size);
+        if (region_size > (size_t)(file_size - region)) {
+            error = ARENA_ERROR_SNAPSHOT_INVALID;
+            goto exit_error;
+        }
+
+        bool in_chain = image.index < chain_count && !chain[image.index];
+        if (in_chain || keep_cached) {
+            ArenaChunk *chunk = (ArenaChunk*)mmap(NULL, region_size, PROT_READ | PROT_WRITE, map_flags, fd, region);
+            if (chunk == MAP_FAILED) {
+                error = ARENA_ERROR_MAPPING_FAILED;
+                goto exit_error;
+            }
+
+            chunk->next = NULL;
+            if (in_chain) {
+                chain[chunk->index] = chunk;
+            } else {
+                chunk->index = ARENA_U32_MAX;
+                chunk->next  = cached;
+                cached       = chunk;
+            }
+        }
+
+        region += (off_t)region_size;
+    }
+
+    for (uint32_t i = 0; i < chain_count; ++i) {
+        if (!chain[i]) {
+            error = ARENA_ERROR_SNAPSHOT_INVALID;
+            goto exit_error;
+        }
+    }
+
+    // rebuild directory, from here on `arena_destroy` owns every chunk it has seen
+    arena->head_chunk  = chain[0];
+    arena->last_chunk  = chain[0];
+    arena->reserved    = chain[0]->capacity;
+    arena->chunk_count = 1;
+    arena->owned_count = 1;
+    chain[0] = NULL;
+
+    for (uint32_t i = 1; i < chain_count; ++i) {
+        if (!_arena_reserve_chunk_dir(arena)) {
+            error = ARENA_ERROR_OOM;
+            goto exit_error;
+        }
+        _arena_insert_owned_chunk(arena, chain[i]);
+        _arena_push_chunk(arena, chain[i]);
+        chain[i] = NULL;
+    }
+
+    while (cached) {
+        if (!_arena_reserve_chunk_dir(arena)) {
+            error = ARENA_ERROR_OOM;
+            goto exit_error;
+        }
+        ArenaChunk *chunk = cached;
+        cached = chunk->next;
+        _arena_insert_owned_chunk(arena, chunk);
+        chunk->next = arena->free_chunks;
+        arena->free_chunks = chunk;
+    }
+
+    if (arena->backing == ARENA_CHUNK_BACKING_FILE) arena->file_size = (arena_size_t)region;
+    free(chain);
+    return ARENA_ERROR_NONE;
+
+exit_error:
+    for (uint32_t i = 0; i < chain_count; ++i) {
+        if (chain[i]) _arena_free_chunk(arena, chain[i]);
+    }
+    while (cached) {
+        ArenaChunk *chunk = cached;
+        cached = chunk->next;
+        _arena_free_chunk(arena, chunk);
+    }
+    free(chain);
+
+    if (arena->head_chunk) {
+        arena->backing = ARENA_CHUNK_BACKING_DEFAULT; // don't touch the header of a file we failed to map
+        arena_destroy(arena);
+    }
+    return error;
+}
+
+static inline Arena arena_create_file(const char *path, ArenaConfig config)
+{
+    /*
+    - Every chunk is a page aligned region of the file mapped MAP_SHARED, data survives the process
+    - Page 0 holds the header, chunk regions follow in allocation order
+    - Chunks land at different addresses after `arena_open_file`, store handles or offsets, not raw pointers
+    - Realloc contract would move the head chunk, only fixed and chunky arenas can be file backed
+    - File never shrinks, trimmed chunks stay in it and come back as cached chunks
+    - NULL `path` gives anonymous memfd file, handy for `arena_fork`
+    */
+    if (config.growth_contract == ARENA_GROWTH_CONTRACT_REALLOC) return _arena_failed(ARENA_ERROR_GROWTH_FORBIDDEN);
+
+    size_t capacity = _arena_resolve_config(&config);
+    int fd = path ? open(path, O_RDWR | O_CREAT | O_TRUNC, 0644) : _arena_memfd_create("arena_file");
+    if (fd < 0) return _arena_failed(ARENA_ERROR_IO);
+
+    Arena arena = {};
+    arena.max_capacity    = config.max_capacity;
+    arena.growth_factor   = config.growth_factor;
+    arena.growth_contract = config.growth_contract;
+    arena.flags           = config.flags;
+    arena.error           = ARENA_ERROR_NONE;
+    arena.alloc_type      = ARENA_ALLOC_TYPE_BIG;
+    arena.backing         = ARENA_CHUNK_BACKING_FILE;
+    arena.fd              = fd;
+    arena.file_size       = _arena_get_platform_page_size();
+
+    ArenaChunk *chunk = _arena_alloc_file_chunk(&arena, capacity);
+    if (!chunk) {
+        close(fd);
+        return _arena_failed(arena.error);
+    }
+
+    arena.head_chunk  = chunk;
+    arena.last_chunk  = chunk;
+    arena.reserved    = chunk->capacity;
+    arena.chunk_count = 1;
+    arena.owned_count = 1;
+
+    if (!_arena_file_write_header(&arena)) {
+        arena_destroy(&arena);
+        return _arena_failed(ARENA_ERROR_IO);
+    }
+
+    ARENA_LOG("File arena created at `%s`. Capacity: " ARENA_SIZE_FMT, path ? path : "(memfd)", arena.reserved);
+    return arena;
+}
+
+static inline Arena arena_open_file(const char *path)
+{
+    /*
+    - Maps every chunk region of a file created by `arena_create_file` back MAP_SHARED
+    - Chain is rebuilt from chunk indices, regions outside of the chain become cached chunks
+    - Epoch is persisted, handles from previous sessions resolve
+    - Failure returns empty arena with `error` set
+    */
+    size_t page_size = _arena_get_platform_page_size();
+
+    int fd = path ? open(path, O_RDWR) : -1;
+    if (fd < 0) return _arena_failed(ARENA_ERROR_IO);
+
+    ArenaSnapshotHeader header;
+    off_t file_size = lseek(fd, 0, SEEK_END);
+    if (file_size < 0 || !_arena_pread_all(fd, &header, sizeof(header), 0)) {
+        close(fd);
+        return _arena_failed(ARENA_ERROR_IO);
+    }
+
+    if (header.magic != ARENA_FILE_MAGIC || header.version != ARENA_SNAPSHOT_VERSION ||
+        header.page_size != page_size || header.chunk_header_size != sizeof(ArenaChunk) ||
+        header.growth_contract == ARENA_GROWTH_CONTRACT_REALLOC ||
+        header.chunk_count == 0 || header.chunk_count > ARENA_HANDLE_CHUNK_MASK) {
+        close(fd);
+        return _arena_failed(ARENA_ERROR_SNAPSHOT_INVALID);
+    }
+
+    Arena arena = {};
+    arena.max_capacity    = header.max_capacity;
+    arena.growth_factor   = header.growth_factor;
+    arena.growth_contract = (ArenaGrowthContract)header.growth_contract;
+    arena.flags           = (ArenaFlag)(header.flags & ~(ARENA_FLAG_SHARED | ARENA_FLAG_FROZEN)); // writable mappings
+    arena.error           = ARENA_ERROR_NONE;
+    arena.alloc_type      = ARENA_ALLOC_TYPE_BIG;
+    arena.epoch           = header.epoch;
+    arena.backing         = ARENA_CHUNK_BACKING_FILE;
+    arena.fd              = fd;
+
+    ArenaError error = _arena_map_file_chunks(&arena, fd, file_size, header.chunk_count, MAP_SHARED, true);
+    if (error != ARENA_ERROR_NONE) {
+        close(fd);
+        return _arena_failed(error);
+    }
+
+    ARENA_LOG("File arena opened from `%s`. Chunks: %u Owned: %u", path, arena.chunk_count, arena.owned_count);
+    return arena;
+}
+
+static inline bool arena_sync(Arena *arena)
+{
+    // writes header and flushes every chunk of a file backed arena to disk
+    if (!arena || !arena->head_chunk || arena->backing != ARENA_CHUNK_BACKING_FILE) return false;
+
+    bool ok = _arena_file_write_header(arena);
+
+    ArenaChunk *const *owned = _arena_owned(arena);
+    for (uint32_t i = 0; ok && i < arena->owned_count; ++i) {
+        ArenaChunk *chunk = owned[i];
+        ok = msync(chunk, _arena_calc_chunk_real_size(chunk->capacity), MS_SYNC) == 0;
+    }
+    if (ok) ok = fsync(arena->fd) == 0;
+
+    if (!ok) _arena_set_error(arena, ARENA_ERROR_IO);
+    return ok;
+}
+
+static inline Arena arena_fork(Arena *parent)
+{
+    /*
+    - Child maps chain chunks of a file backed parent MAP_PRIVATE, pages are copied only when child writes them
+    - Child is a view at different addresses, link data with handles, offsets or `ArenaRelPtr`
+    - Parent must stay untouched while child is alive (its writes would show through clean child pages)
+    - Finish with `arena_fork_commit` or throw the child away with `arena_destroy`
+    */
+    if (!parent || !parent->head_chunk) return _arena_failed(ARENA_ERROR_INVALID_CAPACITY);
+    if (parent->backing != ARENA_CHUNK_BACKING_FILE) return _arena_failed(ARENA_ERROR_UNSUPPORTED);
+    if (parent->defer != ARENA_HANDLE_NULL) return _arena_failed(ARENA_ERROR_UNSUPPORTED); // child would run them too
+    if (parent->flags & ARENA_FLAG_FROZEN) return _arena_failed(ARENA_ERROR_FROZEN);
+
+    // cached chunks get ARENA_U32_MAX index so the walk skips them
+    if (!_arena_file_write_header(parent)) return _arena_failed(ARENA_ERROR_IO);
+
+    uint32_t count = parent->chunk_count;
+    ArenaFork *fork = (ArenaFork*)malloc(sizeof(ArenaFork) + 2 * count * sizeof(ArenaChunk*));
+    if (!fork) return _arena_failed(ARENA_ERROR_OOM);
+
+    Arena child = {};
+    child.max_capacity    = parent->max_capacity;
+    child.growth_factor   = parent->growth_factor;
+    child.growth_contract = parent->growth_contract;
+    child.flags           = (ArenaFlag)(parent->flags & ~(ARENA_FLAG_SHARED | ARENA_FLAG_FROZEN)); // private writable pages
+    child.error           = ARENA_ERROR_NONE;
+    child.alloc_type      = ARENA_ALLOC_TYPE_BIG;
+    child.epoch           = parent->epoch;
+    child.backing         = ARENA_CHUNK_BACKING_DEFAULT; // child growth never touches parent file
+
+    ArenaError error = _arena_map_file_chunks(&child, parent->fd, (off_t)parent->file_size, count, MAP_PRIVATE, false);
+    if (error != ARENA_ERROR_NONE) {
+        free(fork);
+        return _arena_failed(error);
+    }
+
+    ArenaChunk *const *child_chain  = _arena_chain(&child);
+    ArenaChunk *const *parent_chain = _arena_chain(parent);
+    for (uint32_t i = 0; i < count; ++i) {
+        fork->twins[2*i]     = child_chain[i];
+        fork->twins[2*i + 1] = parent_chain[i];
+    }
+    fork->parent_head        = parent->head_chunk;
+    fork->parent_epoch       = parent->epoch;
+    fork->parent_used        = arena_used_bytes(parent);
+    fork->parent_chunk_count = count;
+    fork->count              = count;
+    child.fork = fork;
+
+    ARENA_LOG("Arena forked. Chunks: %u", count);
+    return child;
+}
+
+static inline void _arena_fork_copy_dirty(int pagemap, const ArenaChunk *from, ArenaChunk *to)
+{
+    // copies pages child has written (private anonymous now), clean pages still equal the parent
+    size_t page_size = _arena_get_platform_page_size();
+    size_t pages = (size_t)_arena_align_up(sizeof(ArenaChunk) + from->offset, page_size) / page_size;
+
+    uint64_t entries[64];
+    for (size_t first = 0; first < pages; first += 64) {
+        size_t batch = (pages - first < 64) ? pages - first : 64;
+        const uint8_t *src = (const uint8_t*)from + first * page_size;
+        uint8_t *dst = (uint8_t*)to + first * page_size;
+
+        off_t at = (off_t)(((arena_ptr_t)src / page_size) * sizeof(uint64_t));
+        if (pagemap < 0 || !_arena_pread_all(pagemap, entries, batch * sizeof(uint64_t), at)) {
+            arena_memcpy(dst, src, batch * page_size);
+            continue;
+        }
+
+        for (size_t i = 0; i < batch; ++i) {
+            bool present  = (entries[i] >> 63) & 1;
+            bool swapped  = (entries[i] >> 62) & 1;
+            bool file_map = (entries[i] >> 61) & 1;
+            if ((present && !file_map) || swapped) arena_memcpy(dst + i * page_size, src + i * page_size, page_size);
+        }
+    }
+}
+
+static inline bool arena_fork_commit(Arena *parent, Arena *child)
+{
+    /*
+    - Makes parent look exactly like the child (chain, offsets, epoch), child is destroyed
+    - Chunks child mapped from parent copy only dirty pages (/proc/self/pagemap, whole used range without it)
+    - Chunks child allocated itself are copied into new parent chunks
+    - Parent chunks child dropped go to parent chunk cache
+    */
+    if (!parent || !child || !parent->head_chunk || !child->head_chunk) return false;
+
+    if (parent->flags & ARENA_FLAG_FROZEN) {
+        _arena_set_error(parent, ARENA_ERROR_FROZEN);
+        return false;
+    }
+
+    ArenaFork *fork = child->fork;
+    if (!fork) {
+        _arena_set_error(parent, ARENA_ERROR_UNSUPPORTED);
+        return false;
+    }
+    if (parent->head_chunk != fork->parent_head || parent->epoch != fork->parent_epoch ||
+        parent->chunk_count != fork->parent_chunk_count || arena_used_bytes(parent) != fork->parent_used) {
+        _arena_set_error(parent, ARENA_ERROR_FORK_STALE);
+        return false;
+    }
+
+    uint32_t count = child->chunk_count;
+    ArenaChunk *const *child_chain = _arena_chain(child);
+    ArenaChunk **chain = (ArenaChunk**)malloc(count * sizeof(*chain));
+    if (!chain) {
+        _arena_set_error(parent, ARENA_ERROR_OOM);
+        return false;
+    }
+
+    // new parent chunks first, failure here leaves parent as is (new chunks land in its cache)
+    for (uint32_t i = 0; i < count; ++i) {
+        chain[i] = NULL;
+        for (uint32_t t = 0; t < fork->count; ++t) {
+            if (fork->twins[2*t] == child_chain[i]) chain[i] = fork->twins[2*t + 1];
+        }
+        if (chain[i]) continue;
+
+        ArenaChunk *chunk = _arena_reserve_chunk_dir(parent) ? _arena_new_chunk(parent, child_chain[i]->capacity) : NULL;
+        if (!chunk) {
+            free(chain);
+            _arena_set_error(parent, ARENA_ERROR_CHUNK_ALLOC_FAILED);
+            return false;
+        }
+        _arena_insert_owned_chunk(parent, chunk);
+        chunk->next = parent->free_chunks;
+        parent->free_chunks = chunk;
+        chain[i] = chunk;
+    }
+    if (!_arena_reserve_chunk_dir(parent)) {
+        free(chain);
+        _arena_set_error(parent, ARENA_ERROR_OOM);
+        return false;
+    }
+
+    int pagemap = open("/proc/self/pagemap", O_RDONLY);
+    for (uint32_t i = 0; i < count; ++i) {
+        ArenaChunk *from = child_chain[i];
+        if (from->backing == ARENA_CHUNK_BACKING_FILE) {
+            _arena_fork_copy_dirty(pagemap, from, chain[i]); // header page comes along, fixed below
+        } else {
+            arena_memcpy(chain[i]->base, from->base, _arena_downcast_size(from->offset, NULL));
+        }
+        chain[i]->offset = from->offset;
+    }
+    if (pagemap >= 0) close(pagemap);
+
+    // rebuild parent chain in child order, everything else goes to the cache
+    ArenaChunk *const *owned = _arena_owned(parent);
+    for (uint32_t i = 0; i < parent->owned_count; ++i) {
+        owned[i]->index = ARENA_U32_MAX;
+        owned[i]->next  = NULL;
+    }
+
+    parent->free_chunks = NULL;
+    parent->head_chunk  = chain[0];
+    parent->last_chunk  = chain[0];
+    parent->reserved    = chain[0]->capacity;
+    parent->chunk_count = 1;
+    chain[0]->index     = 0;
+    for (uint32_t i = 1; i < count; ++i) _arena_push_chunk(parent, chain[i]);
+
+    for (uint32_t i = 0; i < parent->owned_count; ++i) {
+        ArenaChunk *chunk = owned[i];
+        if (chunk->index != ARENA_U32_MAX || chunk->backing == ARENA_CHUNK_BACKING_LOADED) continue;
+        chunk->next = parent->free_chunks;
+        parent->free_chunks = chunk;
+    }
+
+    parent->epoch = child->epoch;
+    free(chain);
+    arena_destroy(child);
+    _arena_set_error(parent, ARENA_ERROR_NONE);
+    return true;
+}
+
+static inline Arena _arena_map_shared(int fd, size_t size)
+{
+    // maps header page + chunk, both processes see the same chunk header (offset) and epoch
+    uint8_t *mapping = (uint8_t*)mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) return _arena_failed(ARENA_ERROR_MAPPING_FAILED);
+
+    ArenaChunk *chunk = (ArenaChunk*)(mapping + _arena_get_platform_page_size());
+    Arena arena = {};
+    arena.reserved        = chunk->capacity;
+    arena.max_capacity    = chunk->capacity;
+    arena.growth_factor   = ARENA_GROWTH_FACTOR_NONE;
+    arena.growth_contract = ARENA_GROWTH_CONTRACT_FIXED;
+    arena.flags           = ARENA_FLAG_SHARED;
+    arena.error           = ARENA_ERROR_NONE;
+    arena.alloc_type      = ARENA_ALLOC_TYPE_BIG;
+    arena.epoch           = _ARENA_ATOMIC_LOAD(&((ArenaSharedHeader*)mapping)->epoch);
+    arena.head_chunk      = chunk;
+    arena.last_chunk      = chunk;
+    arena.chunk_count     = 1;
+    arena.owned_count     = 1;
+    return arena;
+}
+
+static inline Arena arena_create_shared(const char *name, ArenaConfig config)
+{
+    /*
+    - Single fixed chunk in a shared memory object (`shm_open` with `name`, or anonymous memfd
+      shared only with children forked after creation when `name` is NULL)
+    - Any process may allocate, offset is claimed with CAS so allocations never overlap
+    - `arena_reset` from any process bumps the shared epoch, handles made before it stop resolving
+    - Chunks land at different addresses in every process, pass handles or offsets, not raw pointers
+    - Restore is not coordinated between processes, use reset
+    */
+    if (config.growth_contract != ARENA_GROWTH_CONTRACT_FIXED) return _arena_failed(ARENA_ERROR_GROWTH_FORBIDDEN);
+
+    size_t page_size = _arena_get_platform_page_size();
+    size_t capacity  = _arena_resolve_config(&config);
+    size_t size      = page_size + (size_t)_arena_align_up(_arena_calc_chunk_real_size(capacity), page_size);
+
+    int fd = name ? shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600) : _arena_memfd_create("arena_shared");
+    if (fd < 0) return _arena_failed(ARENA_ERROR_IO);
+    if (ftruncate(fd, (off_t)size) != 0) {
+        close(fd);
+        if (name) shm_unlink(name);
+        return _arena_failed(ARENA_ERROR_IO);
+    }
+
+    Arena arena = _arena_map_shared(fd, size);
+    if (!arena.head_chunk) {
+        if (name) shm_unlink(name);
+        return arena;
+    }
+
+    ArenaChunk *chunk = arena.head_chunk;
+    chunk->next     = NULL;
+    chunk->offset   = 0;
+    chunk->index    = 0;
+    chunk->backing  = ARENA_CHUNK_BACKING_SHARED;
+    chunk->capacity = _arena_calc_chunk_capacity(size - page_size);
+    arena.reserved     = chunk->capacity;
+    arena.max_capacity = chunk->capacity;
+    arena.flags        = (ArenaFlag)(config.flags | ARENA_FLAG_SHARED);
+
+    ArenaSharedHeader *header = _arena_shared_header(&arena);
+    header->version   = ARENA_SHARED_VERSION;
+    header->page_size = (uint32_t)page_size;
+    header->size      = size;
+    header->epoch     = 0;
+    _ARENA_ATOMIC_STORE(&header->magic, ARENA_SHARED_MAGIC); // publish
+
+    ARENA_LOG("Shared arena created `%s`. Capacity: " ARENA_SIZE_FMT, name ? name : "(anonymous)", chunk->capacity);
+    return arena;
+}
+
+static inline Arena arena_attach_shared(const char *name)
+{
+    // maps arena created by `arena_create_shared` in another process, detach with `arena_destroy`
+    int fd = name ? shm_open(name, O_RDWR, 0600) : -1;
+    if (fd < 0) return _arena_failed(ARENA_ERROR_IO);
+
+    ArenaSharedHeader header;
+    if (!_arena_pread_all(fd, &header, sizeof(header), 0)) {
+        close(fd);
+        return _arena_failed(ARENA_ERROR_SHARED_INVALID); // creator has not sized it yet
+    }
+
+    // a header claiming more than the object holds would map fine and fault on first touch
+    struct stat st;
+    size_t page_size = _arena_get_platform_page_size();
+    if (header.magic != ARENA_SHARED_MAGIC || header.version != ARENA_SHARED_VERSION ||
+        header.page_size != page_size || header.size <= page_size + sizeof(ArenaChunk) ||
+        fstat(fd, &st) != 0 || st.st_size < 0 || (uint64_t)st.st_size < header.size) {
+        close(fd);
+        return _arena_failed(ARENA_ERROR_SHARED_INVALID);
+    }
+
+    Arena arena = _arena_map_shared(fd, header.size);
+    if (arena.head_chunk && (arena.head_chunk->backing != ARENA_CHUNK_BACKING_SHARED ||
+        arena.head_chunk->capacity > header.size - page_size - sizeof(ArenaChunk))) {
+        munmap(_arena_shared_header(&arena), header.size);
+        return _arena_failed(ARENA_ERROR_SHARED_INVALID);
+    }
+    return arena;
+}
+
+static inline bool arena_shared_unlink(const char *name)
+{
+    // removes the name, mappings stay valid until every process destroys its arena
+    return name && shm_unlink(name) == 0;
+}
+
+static inline size_t arena_to_iovec(const Arena *arena, struct iovec *out, size_t n)
+{
+    /*
+    - Fills `out` with used bytes of chain chunks in allocation order (empty chunks skipped)
+    - Returns number of entries needed, only first `n` are written (call with n = 0 to size the array)
+    - Alignment padding between allocations is part of the ranges
+    */
+    if (!arena || !arena->head_chunk) return 0;
+
+    size_t count = 0;
+    ArenaChunk *const *chain = _arena_chain(arena);
+    for (uint32_t i = 0; i < arena->chunk_count; ++i) {
+        if (chain[i]->offset == 0) continue;
+        if (out && count < n) {
+            out[count].iov_base = chain[i]->base;
+            out[count].iov_len  = _arena_downcast_size(chain[i]->offset, NULL);
+        }
+        count++;
+    }
+    return count;
+}
+
+static inline arena_size_t arena_readv_into(Arena *arena, int fd, arena_size_t size)
+{
+    /*
+    - Appends up to `size` bytes from `fd` to the arena (unaligned), stops early on EOF
+    - Reads straight into chunks: tail of the last chunk first, a new growth step only once it is full
+    - Returns bytes read, error is set if it stopped before EOF or `size` (I/O or growth failure)
+    - Read bytes can be shipped again with `arena_to_iovec` (take `arena_mark` before to find them)
+    */
+    if (!arena || !arena->head_chunk || fd < 0) return 0;
+    if (arena->flags & ARENA_FLAG_FROZEN) {
+        _arena_set_error(arena, ARENA_ERROR_FROZEN);
+        return 0;
+    }
+
+    arena_size_t total = 0;
+    while (total < size) {
+        arena_size_t remaining = size - total;
+        ArenaChunk  *chunk     = arena->last_chunk;
+        arena_size_t space     = chunk->capacity - chunk->offset;
+
+        // grow only once the tail is used up and only by one step, short reads must not strand chunks
+        if (space == 0) {
+            arena_size_t step = (arena->growth_contract == ARENA_GROWTH_CONTRACT_REALLOC) ? chunk->capacity : arena->growth_factor;
+            if (!arena_grow(arena, remaining < step ? remaining : step)) return total; // error set by `arena_grow`
+            chunk = arena->last_chunk;
+            space = chunk->capacity - chunk->offset;
+        }
+
+        struct iovec iov = { chunk->base + chunk->offset, _arena_downcast_size(space < remaining ? space : remaining, NULL) };
+        ssize_t got = readv(fd, &iov, 1);
+        if (got < 0 && errno == EINTR) continue;
+        if (got < 0) {
+            _arena_set_error(arena, ARENA_ERROR_IO);
+            return total;
+        }
+        if (got == 0) break; // EOF
+
+        chunk->offset += (arena_size_t)got;
+        total         += (arena_size_t)got;
+    }
+
+    _arena_set_error(arena, ARENA_ERROR_NONE);
+    return total;
+}
+
+static inline ArenaSpan _arena_load_mapped(Arena *arena, int fd, size_t size)
+{
+    /*
+        [ header page (chunk header at its end) ][ file pages, read only ][ zero pages, read only ]
+        Chunk is owned so `arena_destroy` unmaps it, index is ARENA_U32_MAX so it is never part of the chain.
+    */
+    size_t page_size = _arena_get_platform_page_size();
+    size_t capacity  = (size_t)_arena_align_up(size + ARENA_LOAD_PADDING, page_size);
+
+    if (!_arena_reserve_chunk_dir(arena)) {
+        _arena_set_error(arena, ARENA_ERROR_OOM);
+        return (ArenaSpan){};
+    }
+
+    uint8_t *region = (uint8_t*)mmap(NULL, page_size + capacity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (region == MAP_FAILED) {
+        _arena_set_error(arena, ARENA_ERROR_MAPPING_FAILED);
+        return (ArenaSpan){};
+    }
+    // bytes past EOF in the last file page read as zero, so does the anonymous tail
+    if (mmap(region + page_size, size, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED ||
+        mprotect(region + page_size, capacity, PROT_READ) != 0) {
+        munmap(region, page_size + capacity);
+        _arena_set_error(arena, ARENA_ERROR_MAPPING_FAILED);
+        return (ArenaSpan){};
+    }
+    madvise(region + page_size, size, MADV_WILLNEED);
+
+    ArenaChunk *chunk = (ArenaChunk*)(region + page_size - sizeof(ArenaChunk));
+    chunk->next     = NULL;
+    chunk->capacity = capacity;
+    chunk->offset   = capacity;
+    chunk->index    = ARENA_U32_MAX;
+    chunk->backing  = ARENA_CHUNK_BACKING_LOADED;
+    _arena_insert_owned_chunk(arena, chunk);
+
+    ARENA_LOG("File mapped into arena at: %p Size: %zu", chunk->base, size);
+    return (ArenaSpan){ .data = chunk->base, .size = size, .mapped = true };
+}
+
+static inline ArenaSpan arena_load_file(Arena *arena, const char *path, ArenaLoadFlag flags)
+{
+    /*
+    - Reads whole file at `path` into the arena, returned span is followed by ARENA_LOAD_PADDING zero bytes
+    - Files from ARENA_LOAD_MMAP_THRESHOLD up are mapped read only (chunky arenas with default backing only),
+      the mapping is released by `arena_destroy`, reset and restore do not touch it
+    - Copies land page aligned (ARENA_LOAD_DIRECT_ALIGN with ARENA_LOAD_DIRECT) and are writable
+    - Returns empty span and sets error on failure (ARENA_ERROR_IO for open/read errors)
+    */
+    if (!arena || !arena->head_chunk || !path) return (ArenaSpan){};
+    if (arena->flags & ARENA_FLAG_FROZEN) {
+        _arena_set_error(arena, ARENA_ERROR_FROZEN);
+        return (ArenaSpan){};
+    }
+
+    bool can_map = arena->growth_contract == ARENA_GROWTH_CONTRACT_CHUNKY &&
+                   arena->backing == ARENA_CHUNK_BACKING_DEFAULT && !(arena->flags & ARENA_FLAG_SHARED);
+    if ((flags & ARENA_LOAD_MMAP) && !can_map) {
+        _arena_set_error(arena, ARENA_ERROR_UNSUPPORTED);
+        return (ArenaSpan){};
+    }
+
+    bool direct = (flags & ARENA_LOAD_DIRECT) != 0;
+    int fd = -1;
+#ifdef O_DIRECT
+    if (direct) fd = open(path, O_RDONLY | O_CLOEXEC | O_DIRECT);
+#endif
+    if (fd < 0) fd = open(path, O_RDONLY | O_CLOEXEC); // no O_DIRECT here or filesystem refused it
+    if (fd < 0) {
+        _arena_set_error(arena, ARENA_ERROR_IO);
+        return (ArenaSpan){};
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < 0 || (uint64_t)st.st_size > ARENA_SIZE_MAX - ARENA_LOAD_DIRECT_ALIGN) {
+        close(fd);
+        _arena_set_error(arena, ARENA_ERROR_IO);
+        return (ArenaSpan){};
+    }
+    size_t size = (size_t)st.st_size;
+
+    bool map = can_map && size > 0 && !(flags & (ARENA_LOAD_COPY | ARENA_LOAD_DIRECT)) &&
+               ((flags & ARENA_LOAD_MMAP) || size >= ARENA_LOAD_MMAP_THRESHOLD);
+    if (map) {
+        ArenaSpan span = _arena_load_mapped(arena, fd, size);
+        close(fd);
+        if (span.data) _arena_set_error(arena, ARENA_ERROR_NONE);
+        return span;
+    }
+
+    // O_DIRECT wants buffer, offset and length aligned, tail read past EOF just comes back short
+    size_t alignment = direct ? ARENA_LOAD_DIRECT_ALIGN : _arena_get_platform_page_size();
+    size_t alloc_size = (size_t)_arena_align_up(size + ARENA_LOAD_PADDING, alignment);
+    size_t read_size  = direct ? (size_t)_arena_align_up(size, alignment) : size;
+
+    // grow up front with room for the worst alignment loss, new chunk base is not page aligned
+    ArenaChunk *tail = arena->last_chunk;
+    if (tail->capacity - tail->offset < alloc_size + alignment && arena->growth_contract != ARENA_GROWTH_CONTRACT_FIXED) {
+        arena_grow(arena, alloc_size + alignment);
+    }
+    uint8_t *data = (uint8_t*)arena_alloc_raw(arena, alloc_size, alignment);
+    if (!data) {
+        close(fd);
+        return (ArenaSpan){}; // error is set by allocation
+    }
+
+    size_t done = 0;
+    while (done < read_size) {
+        ssize_t got = pread(fd, data + done, read_size - done, (off_t)done);
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) break;
+        done += (size_t)got;
+    }
+    close(fd);
+    if (done < size) {
+        _arena_set_error(arena, ARENA_ERROR_IO); // read failed or file shrank, bytes stay allocated
+        return (ArenaSpan){};
+    }
+
+    arena_memset(data + size, 0, alloc_size - size);
+    _arena_set_error(arena, ARENA_ERROR_NONE);
+    return (ArenaSpan){ .data = data, .size = size, .mapped = false };
+}
+
+static inline bool arena_spill_enable(Arena *arena, arena_size_t budget, const char *dir)
+{
+    /*
+    - Once chunks resident in memory exceed `budget` bytes, growth moves the oldest full chain chunks
+      into an unlinked temporary file in `dir` (NULL = /tmp) and maps them back from it at the same address
+    - Pointers stay valid, spilled chunks are read and written as before, kernel pages them out to the file
+    - Chunky arenas with page backed chunks only, calling again just changes the budget
+    */
+    if (!arena || !arena->head_chunk) return false;
+    if (arena->growth_contract != ARENA_GROWTH_CONTRACT_CHUNKY || arena->alloc_type != ARENA_ALLOC_TYPE_BIG ||
+        arena->backing != ARENA_CHUNK_BACKING_DEFAULT || (arena->flags & (ARENA_FLAG_SHARED | ARENA_FLAG_FROZEN))) {
+        _arena_set_error(arena, ARENA_ERROR_UNSUPPORTED);
+        return false;
+    }
+    if (budget == 0) {
+        _arena_set_error(arena, ARENA_ERROR_INVALID_CAPACITY);
+        return false;
+    }
+
+    if (!arena->spill_budget) {
+        if (!dir) dir = "/tmp";
+        int fd = -1;
+    #ifdef O_TMPFILE
+        fd = open(dir, O_TMPFILE | O_RDWR | O_CLOEXEC, 0600);
+    #endif
+        if (fd < 0) {
+            // no O_TMPFILE (or filesystem without it): named file, unlinked right away
+            char path[4096];
+            const char *tail = "/arena_spill_XXXXXX";
+            size_t len = 0;
+            while (*dir && len < sizeof(path) - 32) path[len++] = *dir++;
+            if (*dir == '\0') {
+                while (*tail) path[len++] = *tail++;
+                path[len] = '\0';
+                fd = mkstemp(path);
+                if (fd >= 0) unlink(path);
+            }
+        }
+        if (fd < 0) {
+            _arena_set_error(arena, ARENA_ERROR_IO);
+            return false;
+        }
+        arena->fd        = fd;
+        arena->file_size = 0;
+    }
+
+    arena->spill_budget = budget;
+    _arena_spill(arena);
+    _arena_set_error(arena, ARENA_ERROR_NONE);
+    return true;
+}
+
+static inline ArenaUring arena_uring_create(uint32_t entries)
+{
+    /*
+        Minimal io_uring on raw syscalls. Submission and completion rings are mapped once,
+        `arena_uring_register` pins arena chunks so I/O into them skips per operation page pinning.
+    */
+#ifdef _ARENA_HAS_URING
+    ArenaUring ring = {};
+    ring.fd = -1;
+
+    _ArenaUringParams params;
+    arena_memset(&params, 0, sizeof(params));
+    int fd = (int)syscall(SYS_io_uring_setup, entries, &params);
+    if (fd < 0) {
+        // not built in or blocked by seccomp / sysctl
+        ring.error = (errno == ENOSYS || errno == EPERM) ? ARENA_ERROR_UNSUPPORTED : ARENA_ERROR_IO;
+        return ring;
+    }
+    ring.fd = fd;
+
+    ring.sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+    ring.cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(_ArenaUringCqe);
+    bool single_mmap = (params.features & _ARENA_URING_FEAT_SINGLE_MMAP) != 0;
+    if (single_mmap) {
+        if (ring.cq_ring_size > ring.sq_ring_size) ring.sq_ring_size = ring.cq_ring_size;
+        ring.cq_ring_size = ring.sq_ring_size;
+    }
+
+    ring.sq_ring = (uint8_t*)mmap(NULL, ring.sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, _ARENA_URING_OFF_SQ_RING);
+    if (ring.sq_ring == MAP_FAILED) {
+        ring.sq_ring = NULL;
+        goto exit_error;
+    }
+    ring.cq_ring = single_mmap ? ring.sq_ring :
+        (uint8_t*)mmap(NULL, ring.cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, _ARENA_URING_OFF_CQ_RING);
+    if (ring.cq_ring == MAP_FAILED) {
+        ring.cq_ring = NULL;
+        goto exit_error;
+    }
+    ring.sqes_size = params.sq_entries * sizeof(_ArenaUringSqe);
+    ring.sqes = mmap(NULL, ring.sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, _ARENA_URING_OFF_SQES);
+    if (ring.sqes == MAP_FAILED) {
+        ring.sqes = NULL;
+        goto exit_error;
+    }
+
+    ring.sq_head    = (uint32_t*)(ring.sq_ring + params.sq_off.head);
+    ring.sq_tail    = (uint32_t*)(ring.sq_ring + params.sq_off.tail);
+    ring.sq_array   = (uint32_t*)(ring.sq_ring + params.sq_off.array);
+    ring.sq_mask    = *(uint32_t*)(ring.sq_ring + params.sq_off.ring_mask);
+    ring.sq_entries = params.sq_entries;
+    ring.cq_head    = (uint32_t*)(ring.cq_ring + params.cq_off.head);
+    ring.cq_tail    = (uint32_t*)(ring.cq_ring + params.cq_off.tail);
+    ring.cq_mask    = *(uint32_t*)(ring.cq_ring + params.cq_off.ring_mask);
+    ring.cqes       = ring.cq_ring + params.cq_off.cqes;
+
+    ARENA_LOG("io_uring created. Entries: %u Single mmap: %d", params.sq_entries, single_mmap);
+    return ring;
+
+exit_error:
+    if (ring.sqes) munmap(ring.sqes, ring.sqes_size);
+    if (ring.cq_ring && ring.cq_ring != ring.sq_ring) munmap(ring.cq_ring, ring.cq_ring_size);
+    if (ring.sq_ring) munmap(ring.sq_ring, ring.sq_ring_size);
+    close(fd);
+    ring = (ArenaUring){};
+    ring.fd    = -1;
+    ring.error = ARENA_ERROR_MAPPING_FAILED;
+    return ring;
+#else
+    (void)entries;
+    ArenaUring ring = {};
+    ring.fd    = -1;
+    ring.error = ARENA_ERROR_UNSUPPORTED;
+    return ring;
+#endif
+}
+
+static inline void arena_uring_destroy(ArenaUring *ring)
+{
+    if (!ring || !ring->sq_ring) return;
+    // closing the ring drops registered buffers too
+    munmap(ring->sqes, ring->sqes_size);
+    if (ring->cq_ring != ring->sq_ring) munmap(ring->cq_ring, ring->cq_ring_size);
+    munmap(ring->sq_ring, ring->sq_ring_size);
+    close(ring->fd);
+    free(ring->buffers);
+    *ring = (ArenaUring){};
+    ring->fd = -1;
+}
+
+static inline bool arena_uring_register(ArenaUring *ring, const Arena *arena)
+{
+    /*
+    - Registers every page backed chunk the arena owns as a fixed buffer, replaces previous registration
+    - Reads and writes touching memory inside a registered chunk use READ_FIXED/WRITE_FIXED
+    - Chunks added later (growth) are served by plain READ/WRITE until this is called again
+    - Registered pages stay pinned, so once any chunk is unmapped or remapped (trim, realloc growth, flatten,
+      spill, shared freeze, compact, destroy) every operation goes plain READ/WRITE until this is called again
+    - `arena` must stay at the same address while registered
+    */
+    if (!ring || !ring->sq_ring || !arena || !arena->head_chunk) return false;
+#ifdef _ARENA_HAS_URING
+    if (arena->alloc_type != ARENA_ALLOC_TYPE_BIG) {
+        ring->error = ARENA_ERROR_UNSUPPORTED;
+        return false;
+    }
+
+    if (ring->buffers) {
+        syscall(SYS_io_uring_register, ring->fd, _ARENA_URING_UNREGISTER_BUFFERS, NULL, 0);
+        free(ring->buffers);
+        ring->buffers      = NULL;
+        ring->buffer_count = 0;
+    }
+
+    struct iovec *buffers = (struct iovec*)malloc(arena->owned_count * sizeof(*buffers));
+    if (!buffers) {
+        ring->error = ARENA_ERROR_OOM;
+        return false;
+    }
+
+    // owned list is sorted by address already, file and shared mappings are left out
+    uint32_t count = 0;
+    ArenaChunk *const *owned = _arena_owned(arena);
+    for (uint32_t i = 0; i < arena->owned_count; ++i) {
+        ArenaChunk *chunk = owned[i];
+        if (chunk->backing != ARENA_CHUNK_BACKING_DEFAULT && chunk->backing != ARENA_CHUNK_BACKING_RESERVED) continue;
+        buffers[count].iov_base = chunk->base;
+        buffers[count].iov_len  = _arena_downcast_size(chunk->capacity, NULL);
+        count++;
+    }
+
+    if (count == 0 || syscall(SYS_io_uring_register, ring->fd, _ARENA_URING_REGISTER_BUFFERS, buffers, count) < 0) {
+        free(buffers);
+        ring->error = count == 0 ? ARENA_ERROR_UNSUPPORTED : ARENA_ERROR_IO;
+        return false;
+    }
+
+    ring->buffers      = buffers;
+    ring->buffer_count = count;
+    ring->arena        = arena;
+    ring->arena_head   = arena->head_chunk;
+    ring->arena_remaps = arena->remaps;
+    ring->error        = ARENA_ERROR_NONE;
+    ARENA_LOG("Arena chunks registered with io_uring. Count: %u", count);
+    return true;
+#else
+    ring->error = ARENA_ERROR_UNSUPPORTED;
+    return false;
+#endif
+}
+
+#ifdef _ARENA_HAS_URING
+static inline uint32_t _arena_uring_buffer_index(const ArenaUring *ring, const void *buffer, uint32_t size)
+{
+    // fixed buffer holding [buffer, buffer + size), ARENA_U32_MAX if none
+    if (ring->buffer_count == 0) return ARENA_U32_MAX;
+    if (ring->arena->head_chunk != ring->arena_head || ring->arena->remaps != ring->arena_remaps) {
+        return ARENA_U32_MAX; // registered pages may not back these addresses any more
+    }
+
+    arena_ptr_t address = (arena_ptr_t)buffer;
+    uint32_t lo = 0, hi = ring->buffer_count;
+    while (lo < hi) {
+        uint32_t mid = lo + ((hi - lo) >> 1);
+        if ((arena_ptr_t)ring->buffers[mid].iov_base <= address) lo = mid + 1;
+        else hi = mid;
+    }
+    if (lo == 0) return ARENA_U32_MAX;
+
+    const struct iovec *found = &ring->buffers[lo - 1];
+    arena_ptr_t end = (arena_ptr_t)found->iov_base + found->iov_len;
+    return (address + size <= end) ? lo - 1 : ARENA_U32_MAX;
+}
+
+static inline bool _arena_uring_queue(ArenaUring *ring, uint8_t opcode, uint8_t fixed_opcode, int fd,
+                                      const void *buffer, uint32_t size, uint64_t offset, uint64_t user_data)
+{
+    if (!ring || !ring->sq_ring || fd < 0) return false;
+
+    uint32_t tail = *ring->sq_tail; // only we move the tail
+    if (tail - _ARENA_ATOMIC_LOAD(ring->sq_head) >= ring->sq_entries) {
+        ring->error = ARENA_ERROR_RING_FULL;
+        return false;
+    }
+
+    uint32_t index = tail & ring->sq_mask;
+    _ArenaUringSqe *sqe = &((_ArenaUringSqe*)ring->sqes)[index];
+    arena_memset(sqe, 0, sizeof(*sqe));
+
+    uint32_t buffer_index = _arena_uring_buffer_index(ring, buffer, size);
+    sqe->opcode    = buffer_index != ARENA_U32_MAX ? fixed_opcode : opcode;
+    sqe->fd        = fd;
+    sqe->addr      = (uint64_t)(arena_ptr_t)buffer;
+    sqe->len       = size;
+    sqe->off       = offset;
+    sqe->user_data = user_data;
+    if (buffer_index != ARENA_U32_MAX) sqe->buf_index = (uint16_t)buffer_index;
+
+    ring->sq_array[index] = index;
+    _ARENA_ATOMIC_STORE(ring->sq_tail, tail + 1);
+    ring->pending++;
+    return true;
+}
+#endif
+
+static inline bool arena_uring_read(ArenaUring *ring, int fd, void *buffer, uint32_t size, uint64_t offset, uint64_t user_data)
+{
+    // queues read of `size` bytes at file `offset` (pass (uint64_t)-1 for current position), see `arena_uring_submit`
+#ifdef _ARENA_HAS_URING
+    return _arena_uring_queue(ring, _ARENA_URING_OP_READ, _ARENA_URING_OP_READ_FIXED, fd, buffer, size, offset, user_data);
+#else
+    (void)fd; (void)buffer; (void)size; (void)offset; (void)user_data;
+    if (ring) ring->error = ARENA_ERROR_UNSUPPORTED;
+    return false;
+#endif
+}
+
+static inline bool arena_uring_write(ArenaUring *ring, int fd, const void *buffer, uint32_t size, uint64_t offset, uint64_t user_data)
+{
+#ifdef _ARENA_HAS_URING
+    return _arena_uring_queue(ring, _ARENA_URING_OP_WRITE, _ARENA_URING_OP_WRITE_FIXED, fd, buffer, size, offset, user_data);
+#else
+    (void)fd; (void)buffer; (void)size; (void)offset; (void)user_data;
+    if (ring) ring->error = ARENA_ERROR_UNSUPPORTED;
+    return false;
+#endif
+}
+
+static inline int arena_uring_submit(ArenaUring *ring, uint32_t wait_count)
+{
+    // hands queued operations to the kernel and waits for `wait_count` completions, returns number submitted
+    if (!ring || !ring->sq_ring) return -1;
+#ifdef _ARENA_HAS_URING
+    for (;;) {
+        long submitted = syscall(SYS_io_uring_enter, ring->fd, ring->pending, wait_count,
+                                 wait_count ? _ARENA_URING_ENTER_GETEVENTS : 0, NULL, 0);
+        if (submitted < 0 && errno == EINTR) continue;
+        if (submitted < 0) {
+            ring->error = ARENA_ERROR_IO;
+            return -1;
+        }
+        ring->pending -= (uint32_t)submitted;
+        return (int)submitted;
+    }
+#else
+    (void)wait_count;
+    ring->error = ARENA_ERROR_UNSUPPORTED;
+    return -1;
+#endif
+}
+
+static inline ArenaUringCompletion *arena_uring_reap(ArenaUring *ring, Arena *arena, size_t *count)
+{
+    /*
+    - Moves every ready completion into an array allocated on `arena` (one bump for the whole batch)
+    - Returns NULL with `*count` = 0 when nothing is ready, completions stay queued if allocation fails
+    */
+    if (count) *count = 0;
+    if (!ring || !ring->sq_ring || !arena) return NULL;
+#ifdef _ARENA_HAS_URING
+    uint32_t head = *ring->cq_head;
+    uint32_t tail = _ARENA_ATOMIC_LOAD(ring->cq_tail);
+    if (head == tail) return NULL;
+
+    ArenaUringCompletion *records = (ArenaUringCompletion*)arena_alloc_raw(arena, (tail - head) * sizeof(ArenaUringCompletion), alignof(ArenaUringCompletion));
+    if (!records) return NULL;
+
+    const _ArenaUringCqe *cqes = (const _ArenaUringCqe*)ring->cqes;
+    for (uint32_t i = 0; head + i != tail; ++i) {
+        const _ArenaUringCqe *cqe = &cqes[(head + i) & ring->cq_mask];
+        records[i] = (ArenaUringCompletion){ .user_data = cqe->user_data, .result = cqe->res, .flags = cqe->flags };
+    }
+    _ARENA_ATOMIC_STORE(ring->cq_head, tail);
+
+    if (count) *count = tail - head;
+    return records;
+#else
+    return NULL;
+#endif
+}
+#endif // ARENA_PLATFORM == _ARENA_PLATFORM_UNIX
+
+/* Helper macros */
+#define arena_alloc_struct(pArena, type)           ((type*)arena_alloc_raw((pArena), sizeof(type), alignof(type)))
+#define arena_alloc_array(pArena, size, type)      ((size) == 0 ? NULL : (type*)arena_alloc_raw((pArena), sizeof(type)*size, alignof(type)))
+#define arena_alloc_struct_zero(pArena, type)      ((type*)arena_alloc_zero((pArena), sizeof(type), alignof(type)))
+#define arena_alloc_array_zero(pArena, size, type) ((size) == 0 ? NULL : (type*)arena_alloc_zero((pArena), sizeof(type)*size, alignof(type)))
+
+// serialized buffers, typed access with bounds and alignment checks
+#define arena_buf_add(pBuilder, type, pValue)          arena_buf_add_struct((pBuilder), (pValue), sizeof(type), alignof(type))
+#define arena_buf_get(pView, offset, type)             ((const type*)arena_buf_struct((pView), (offset), sizeof(type), alignof(type)))
+#define arena_buf_get_array(pView, offset, type, pCount) ((const type*)arena_buf_vector((pView), (offset), sizeof(type), alignof(type), (pCount)))
+
+// self-relative pointers, `pRel` is `ArenaRelPtr32*` or `ArenaRelPtr64*`
+#define arena_relptr_get(pRel) _Generic((pRel),                   \
+    ArenaRelPtr32*: arena_relptr32_get, const ArenaRelPtr32*: arena_relptr32_get, \
+    ArenaRelPtr64*: arena_relptr64_get, const ArenaRelPtr64*: arena_relptr64_get  \
+)(pRel)
+#define arena_relptr_set(pRel, target) _Generic((pRel),           \
+    ArenaRelPtr32*: arena_relptr32_set,                           \
+    ArenaRelPtr64*: arena_relptr64_set                            \
+)((pRel), (target))
+#define arena_relptr_get_as(pRel, type) ((type*)arena_relptr_get((pRel)))
+
+#ifdef __GNUC__
+// temporary scope restored automatically when `name` goes out of scope
+#define ARENA_TEMP_SCOPE(name, pArena) ArenaTemp name __attribute__((cleanup(_arena_temp_cleanup))) = arena_temp_begin((pArena))
+#endif
+
+#endif // ARENA_IMPLEMENTATION
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ARENA_H_
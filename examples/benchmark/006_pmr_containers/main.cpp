@@ -0,0 +1,170 @@
+#include <stdio.h>
+#include <time.h>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include <unordered_map>
+#include <memory_resource>
+
+#include "arena.hpp"
+
+#define BATCHES (size_t)2000
+#define RECORDS (size_t)500  // per batch
+#define RUNS    (size_t)5
+
+/*
+    One batch looks like a request: parse RECORDS key/value records into a vector of strings
+    and an index map, do a few lookups, drop everything.
+    Strings are longer than the SSO buffer so every one of them is an allocation.
+    - default:   std containers, global new/delete
+    - monotonic: std::pmr containers on monotonic_buffer_resource, `release()` per batch
+    - arena:     std::pmr containers on ArenaResource, `reset()` per batch
+    - allocator: std containers with ArenaAllocator (no virtual call), `arena_reset` per batch
+*/
+
+static char KEYS[RECORDS][48];
+
+struct StringHash {
+    template <typename String>
+    size_t operator()(const String &s) const noexcept { return std::hash<std::string_view>()(std::string_view(s.data(), s.size())); }
+};
+
+template <typename Vector, typename Map>
+static long long run_batch(Vector &names, Map &index)
+{
+    using String = typename Vector::value_type;
+    names.reserve(RECORDS);
+    for (size_t i = 0; i < RECORDS; ++i) {
+        // pmr containers pass their resource down on their own, plain allocators have to be handed over
+        if constexpr (std::is_same_v<typename String::allocator_type, ArenaAllocator<char>>) {
+            names.emplace_back(KEYS[i], KEYS[i] + 40, typename String::allocator_type(names.get_allocator()));
+        } else {
+            names.emplace_back(KEYS[i], KEYS[i] + 40);
+        }
+        index.emplace(names.back(), (long long)i);
+    }
+
+    long long sum = 0;
+    for (size_t i = 0; i < RECORDS; i += 7) sum += index.find(names[i])->second;
+    return sum;
+}
+
+static double now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+static void report(const char *name, double time, long long check)
+{
+    printf("%-10s: %8.3f ms per run, %6.2f us per batch (check: %lld)\n", name, time, time * 1000.0 / BATCHES, check);
+}
+
+static void test_default(void)
+{
+    long long check = 0;
+    double time = 0;
+    for (size_t r = 0; r < RUNS; ++r) {
+        double t = now_ms();
+        for (size_t b = 0; b < BATCHES; ++b) {
+            std::vector<std::string> names;
+            std::unordered_map<std::string, long long, StringHash> index;
+            check += run_batch(names, index);
+        }
+        time += now_ms() - t;
+    }
+    report("default", time / RUNS, check);
+}
+
+static void test_monotonic(void)
+{
+    std::pmr::monotonic_buffer_resource resource(ARENA_CAPACITY_64KB);
+    long long check = 0;
+    double time = 0;
+    for (size_t r = 0; r < RUNS; ++r) {
+        double t = now_ms();
+        for (size_t b = 0; b < BATCHES; ++b) {
+            {
+                std::pmr::vector<std::pmr::string> names(&resource);
+                std::pmr::unordered_map<std::pmr::string, long long, StringHash> index(&resource);
+                check += run_batch(names, index);
+            }
+            resource.release();
+        }
+        time += now_ms() - t;
+    }
+    report("monotonic", time / RUNS, check);
+}
+
+static void test_arena(void)
+{
+    ArenaResource resource(arena_config_create(
+        ARENA_CAPACITY_64KB,
+        ARENA_CAPACITY_128MB,
+        ARENA_GROWTH_CONTRACT_CHUNKY,
+        ARENA_GROWTH_FACTOR_CHUNKY_64KB,
+        ARENA_FLAG_NONE
+    ));
+    long long check = 0;
+    double time = 0;
+    for (size_t r = 0; r < RUNS; ++r) {
+        double t = now_ms();
+        for (size_t b = 0; b < BATCHES; ++b) {
+            {
+                std::pmr::vector<std::pmr::string> names(&resource);
+                std::pmr::unordered_map<std::pmr::string, long long, StringHash> index(&resource);
+                check += run_batch(names, index);
+            }
+            resource.reset();
+        }
+        time += now_ms() - t;
+    }
+    report("arena", time / RUNS, check);
+}
+
+static void test_allocator(void)
+{
+    using String = std::basic_string<char, std::char_traits<char>, ArenaAllocator<char>>;
+    using Vector = std::vector<String, ArenaAllocator<String>>;
+    using Map    = std::unordered_map<String, long long, StringHash, std::equal_to<String>, ArenaAllocator<std::pair<const String, long long>>>;
+
+    Arena arena = arena_create_ex(arena_config_create(
+        ARENA_CAPACITY_64KB,
+        ARENA_CAPACITY_128MB,
+        ARENA_GROWTH_CONTRACT_CHUNKY,
+        ARENA_GROWTH_FACTOR_CHUNKY_64KB,
+        ARENA_FLAG_NONE
+    ));
+    ArenaAllocator<char> alloc(&arena);
+    long long check = 0;
+    double time = 0;
+    for (size_t r = 0; r < RUNS; ++r) {
+        double t = now_ms();
+        for (size_t b = 0; b < BATCHES; ++b) {
+            {
+                Vector names(alloc);
+                Map index(0, StringHash(), std::equal_to<String>(), alloc);
+                check += run_batch(names, index);
+            }
+            arena_reset(&arena);
+        }
+        time += now_ms() - t;
+    }
+    report("allocator", time / RUNS, check);
+    arena_destroy(&arena);
+}
+
+int main(void)
+{
+    for (size_t i = 0; i < RECORDS; ++i) snprintf(KEYS[i], sizeof(KEYS[i]), "record-%06zu-%-32s", i, "payload");
+
+    printf("Containers per batch: vector<string> + unordered_map<string, long long>\nBatches: %zu\nRecords per batch: %zu\nRuns: %zu\n",
+        BATCHES, RECORDS, RUNS);
+    test_default();
+    test_monotonic();
+    test_arena();
+    test_allocator();
+    return 0;
+}
@@ -0,0 +1,166 @@
+#include <stdio.h>
+#include <time.h>
+#include <exception>
+#include <coroutine>
+
+#include "arena.hpp"
+
+#define TREE_DEPTH (int)20      // 2^21 - 1 task frames per run
+#define GENERATORS (int)2000000 // short generator frames per run
+#define RUNS       (size_t)5
+
+/*
+    Same coroutine types twice, the only difference is the promise base:
+    - heap:  no base, frames come from global operator new
+    - arena: `ArenaPromise`, frames come from the arena of the innermost `ArenaFrameScope`
+    Task tree: every task awaits two child tasks (symmetric transfer), frames die in LIFO order.
+    Generators: one short generator per item, consumed right away.
+    Arena is reset once per run, after the whole tree / pipeline is done.
+*/
+
+struct HeapFrames {};
+
+template <typename Base>
+struct Task {
+    struct promise_type : Base {
+        long                    value        = 0;
+        std::coroutine_handle<> continuation = std::noop_coroutine();
+
+        struct FinalAwaiter {
+            bool await_ready() noexcept { return false; }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> h) noexcept { return h.promise().continuation; }
+            void await_resume() noexcept {}
+        };
+
+        Task get_return_object() { return Task{std::coroutine_handle<promise_type>::from_promise(*this)}; }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        FinalAwaiter final_suspend() noexcept { return {}; }
+        void return_value(long v) noexcept { value = v; }
+        void unhandled_exception() { std::terminate(); }
+    };
+
+    std::coroutine_handle<promise_type> handle;
+
+    explicit Task(std::coroutine_handle<promise_type> h) : handle(h) {}
+    Task(Task &&other) noexcept : handle(other.handle) { other.handle = nullptr; }
+    ~Task() { if (handle) handle.destroy(); }
+
+    bool await_ready() noexcept { return false; }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+    {
+        handle.promise().continuation = awaiting;
+        return handle;
+    }
+    long await_resume() noexcept { return handle.promise().value; }
+
+    long run()
+    {
+        handle.resume();
+        return handle.promise().value;
+    }
+};
+
+template <typename Base>
+struct Generator {
+    struct promise_type : Base {
+        int value = 0;
+
+        Generator get_return_object() { return Generator{std::coroutine_handle<promise_type>::from_promise(*this)}; }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        std::suspend_always yield_value(int v) noexcept { value = v; return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() { std::terminate(); }
+    };
+
+    std::coroutine_handle<promise_type> handle;
+
+    explicit Generator(std::coroutine_handle<promise_type> h) : handle(h) {}
+    Generator(Generator &&other) noexcept : handle(other.handle) { other.handle = nullptr; }
+    ~Generator() { if (handle) handle.destroy(); }
+
+    bool next() { handle.resume(); return !handle.done(); }
+    int  value() const { return handle.promise().value; }
+};
+
+template <typename Base>
+static Task<Base> tree(int depth)
+{
+    if (depth == 0) co_return 1;
+    long left  = co_await tree<Base>(depth - 1);
+    long right = co_await tree<Base>(depth - 1);
+    co_return left + right + 1;
+}
+
+template <typename Base>
+static Generator<Base> digits(int value)
+{
+    do {
+        co_yield value % 10;
+        value /= 10;
+    } while (value);
+}
+
+template <typename Base>
+static long pipeline(void)
+{
+    long sum = 0;
+    for (int i = 0; i < GENERATORS; ++i) {
+        Generator<Base> g = digits<Base>(i);
+        while (g.next()) sum += g.value();
+    }
+    return sum;
+}
+
+static double now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+template <typename Base>
+static void bench(const char *name, Arena *arena)
+{
+    double tree_time = 0, gen_time = 0;
+    long check = 0;
+    for (size_t r = 0; r < RUNS; ++r) {
+        double t = now_ms();
+        check += tree<Base>(TREE_DEPTH).run();
+        if (arena) arena_reset(arena);
+        tree_time += now_ms() - t;
+
+        t = now_ms();
+        check += pipeline<Base>();
+        if (arena) arena_reset(arena);
+        gen_time += now_ms() - t;
+    }
+    tree_time /= RUNS;
+    gen_time  /= RUNS;
+
+    double tree_frames = (double)((2l << TREE_DEPTH) - 1);
+    printf("%-6s: tree %8.3f ms (%5.1f ns/frame), generators %8.3f ms (%5.1f ns/frame) (check: %ld)\n",
+        name, tree_time, tree_time * 1e6 / tree_frames, gen_time, gen_time * 1e6 / GENERATORS, check);
+}
+
+int main(void)
+{
+    printf("Coroutine frames, heap vs arena\nTree depth: %d\nGenerators: %d\nRuns: %zu\n", TREE_DEPTH, GENERATORS, RUNS);
+
+    bench<HeapFrames>("heap", NULL);
+
+    Arena arena = arena_create_ex(arena_config_create(
+        ARENA_CAPACITY_64KB,
+        ARENA_CAPACITY_128MB,
+        ARENA_GROWTH_CONTRACT_CHUNKY,
+        ARENA_GROWTH_FACTOR_CHUNKY_64KB,
+        ARENA_FLAG_NONE
+    ));
+    {
+        ArenaFrameScope scope(&arena);
+        bench<ArenaPromise>("arena", &arena);
+    }
+    printf("Arena reserved: %.1f KB\n", (double)arena.reserved / 1024);
+    arena_destroy(&arena);
+    return 0;
+}